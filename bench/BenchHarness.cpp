@@ -0,0 +1,127 @@
+// BenchHarness.cpp - 计时、内存分配统计和JSON输出
+#include "BenchHarness.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// ==================== 内存分配统计 ====================
+
+static std::atomic<uint64_t> allocationCount{0};
+static std::atomic<uint64_t> allocatedBytes{0};
+
+static void* countedAlloc(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+uint64_t benchAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t benchAllocatedBytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+// ==================== 计时 ====================
+
+BenchResult BenchHarness::measure(BenchCase& benchCase) const {
+    using Clock = std::chrono::steady_clock;
+    
+    // 预热一轮（不计入结果）
+    benchCase.setup();
+    benchCase.run();
+    
+    int64_t runs = 0;
+    double elapsedNs = 0.0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    while (elapsedNs < minTimeMs * 1e6 || runs == 0) {
+        benchCase.setup();
+        for (int i = 0; i < benchCase.runsPerSetup; i++) {
+            uint64_t allocationsBefore = benchAllocationCount();
+            uint64_t bytesBefore = benchAllocatedBytes();
+            auto start = Clock::now();
+            benchCase.run();
+            auto end = Clock::now();
+            allocations += benchAllocationCount() - allocationsBefore;
+            bytes += benchAllocatedBytes() - bytesBefore;
+            elapsedNs += std::chrono::duration<double, std::nano>(end - start).count();
+            runs++;
+        }
+    }
+    
+    BenchResult result;
+    result.name = benchCase.name;
+    result.soldiers = benchCase.soldiers;
+    result.placedSoldiers = benchCase.placedSoldiers;
+    result.op = benchCase.op;
+    result.ops = runs * benchCase.opsPerRun;
+    result.nsPerOp = elapsedNs / result.ops;
+    result.allocsPerOp = static_cast<double>(allocations) / result.ops;
+    result.bytesPerOp = static_cast<double>(bytes) / result.ops;
+    result.opsPerSec = result.nsPerOp > 0.0 ? 1e9 / result.nsPerOp : 0.0;
+    return result;
+}
+
+std::vector<BenchResult> BenchHarness::run(const std::string& filter) {
+    std::vector<BenchResult> results;
+    for (auto& benchCase : cases) {
+        if (!filter.empty() && benchCase.name.find(filter) == std::string::npos) continue;
+        BenchResult result = measure(benchCase);
+        std::cerr << result.name << " [" << result.placedSoldiers << "/" << result.soldiers << " soldiers] "
+                  << static_cast<int64_t>(result.nsPerOp) << " ns/" << result.op
+                  << ", " << result.allocsPerOp << " allocs/" << result.op << std::endl;
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string BenchHarness::toJson(const std::vector<BenchResult>& results, uint32_t seed, double minTimeMs) {
+    nlohmann::json out;
+    out["seed"] = seed;
+    out["min_time_ms"] = minTimeMs;
+    out["results"] = nlohmann::json::array();
+    for (const auto& result : results) {
+        nlohmann::json entry;
+        entry["name"] = result.name;
+        entry["soldiers"] = result.soldiers;
+        entry["placed_soldiers"] = result.placedSoldiers;
+        entry["op"] = result.op;
+        entry["ops"] = result.ops;
+        entry["ns_per_op"] = result.nsPerOp;
+        entry["allocs_per_op"] = result.allocsPerOp;
+        entry["bytes_per_op"] = result.bytesPerOp;
+        entry["ops_per_sec"] = result.opsPerSec;
+        if (result.op == "turn") entry["turns_per_sec"] = result.opsPerSec;
+        out["results"].push_back(entry);
+    }
+    return out.dump(2);
+}
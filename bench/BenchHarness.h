@@ -0,0 +1,60 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ds_bench 的小型基准测试框架
+// - 每个用例由 setup（不计时，构造场景）和 run（计时）组成；一次 setup 之后执行 runsPerSetup 次 run，
+//   会改变场景的操作（战斗、移动、整回合）因此可以在固定的起点上重复测量
+// - 一次 run 包含 opsPerRun 个操作，结果按操作归一化：ns/op、每次操作的内存分配次数和字节数
+// - 内存分配通过替换全局 operator new 统计（BenchHarness.cpp），只计入计时区间内的分配
+struct BenchCase {
+    std::string name;
+    int soldiers = 0;               // 场景规模（请求的士兵数）
+    int placedSoldiers = 0;         // 场景中实际放下的士兵数（空格子不够时少于 soldiers）
+    std::string op;                 // 一个操作的含义（如 "turn"、"soldier"、"call"）
+    int opsPerRun = 1;
+    int runsPerSetup = 1;
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+struct BenchResult {
+    std::string name;
+    int soldiers = 0;
+    int placedSoldiers = 0;
+    std::string op;
+    int64_t ops = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+    double bytesPerOp = 0.0;
+    double opsPerSec = 0.0;
+};
+
+class BenchHarness {
+public:
+    explicit BenchHarness(double minTimeMs) : minTimeMs(minTimeMs) {}
+    
+    void add(BenchCase benchCase) { cases.push_back(std::move(benchCase)); }
+    
+    // 运行名称包含 filter 的用例（filter 为空时全部运行），每个用例结束时在 stderr 打印一行进度
+    std::vector<BenchResult> run(const std::string& filter);
+    
+    // 结果转为JSON（turns_per_sec 只出现在 op 为 "turn" 的用例中）
+    static std::string toJson(const std::vector<BenchResult>& results, uint32_t seed, double minTimeMs);
+    
+private:
+    double minTimeMs;
+    std::vector<BenchCase> cases;
+    
+    BenchResult measure(BenchCase& benchCase) const;
+};
+
+// 全局内存分配计数（进程启动以来）
+uint64_t benchAllocationCount();
+uint64_t benchAllocatedBytes();
+
+#endif // BENCHHARNESS_H
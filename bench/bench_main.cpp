@@ -0,0 +1,188 @@
+// bench_main.cpp - ds_bench：模拟热点路径的基准测试，结果输出为JSON
+#include "BenchHarness.h"
+#include "../include/Model.h"
+#include "../include/Controller.h"
+#include "../include/CombatSystem.h"
+#include "../include/Observation.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 访问 GameController 的私有阶段（GameController 中声明为友元）
+struct BenchAccess {
+    static void soldierBehavior(GameController& controller, std::shared_ptr<Soldier> soldier) {
+        controller.processSoldierBehavior(std::move(soldier));
+    }
+    static Position spawnPosition(GameController& controller, Team team, const Position& basePos) {
+        return controller.findSpawnPosition(team, basePos);
+    }
+};
+
+namespace {
+
+// 固定种子的测试场景：地图由种子生成，士兵随机分布在空格子上
+// A队在上方、B队在下方，中间的带状区域两队交错（有视野共享、接敌和战斗）
+// 每个士兵最多尝试 1000 个随机位置，空格子不够时实际放下的士兵会少于请求数（见 placed）
+struct Scenario {
+    std::shared_ptr<GameModel> model;
+    std::unique_ptr<GameController> controller;
+    int placed = 0;  // 实际放下的士兵数
+    
+    void build(int soldierCount, uint32_t seed) {
+        controller.reset();
+        model = std::make_shared<GameModel>(seed);
+        controller = std::make_unique<GameController>(model, GameMode::AI_VS_AI, PlayerType::AI_RULE_BASED,
+                                                      PlayerType::AI_RULE_BASED);
+        controller->setVerbose(false);
+        controller->reset();
+        
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<> xDis(0, MAP_SIZE - 1);
+        std::uniform_int_distribution<> yDisA(0, MAP_SIZE * 5 / 8 - 1);
+        std::uniform_int_distribution<> yDisB(MAP_SIZE * 3 / 8, MAP_SIZE - 1);
+        std::uniform_int_distribution<> typeDis(0, SOLDIER_TYPE_COUNT - 1);
+        for (int i = 0; i < soldierCount; i++) {
+            Team team = (i % 2 == 0) ? Team::TEAM_A : Team::TEAM_B;
+            for (int attempt = 0; attempt < 1000; attempt++) {
+                Position pos(xDis(rng), team == Team::TEAM_A ? yDisA(rng) : yDisB(rng));
+                if (!model->getMap()->isWalkable(pos) || model->isOccupied(pos)) continue;
+                model->addSoldier(std::make_shared<Soldier>(pos, static_cast<SoldierType>(typeDis(rng)), team));
+                break;
+            }
+        }
+        
+        placed = static_cast<int>(model->getSoldiers().size());
+        
+        // 回合开始时的视野、影响力图和流场
+        model->updateSharedVision();
+        model->updateInfluenceMaps();
+        model->updateFlowFields();
+    }
+};
+
+// 实际放下的士兵数低于请求数的这个比例时拒绝运行（结果不能按请求的规模标注）
+constexpr double MIN_PLACED_RATIO = 0.9;
+
+// 注册一个规模的全部用例，返回实际放下的士兵数（场景由种子决定，每次 setup 重建的结果相同）
+int addCases(BenchHarness& harness, int soldiers, uint32_t seed) {
+    auto scenario = std::make_shared<Scenario>();
+    auto rebuild = [scenario, soldiers, seed]() { scenario->build(soldiers, seed); };
+    rebuild();
+    const int placed = scenario->placed;
+    
+    harness.add({"update_shared_vision", soldiers, placed, "call", 1, 100, rebuild, [scenario]() {
+        scenario->model->updateSharedVision();
+    }});
+    
+    auto events = std::make_shared<std::vector<GameEvent>>();
+    harness.add({"process_combat", soldiers, placed, "call", 1, 1, [rebuild, events]() {
+        rebuild();
+        events->clear();
+    }, [scenario, events]() {
+        CombatSystem::processCombat(scenario->model, *events, 0, false);
+    }});
+    
+    // 每次 run 让所有士兵各行动一次，按士兵数归一化
+    auto movers = std::make_shared<std::vector<std::shared_ptr<Soldier>>>();
+    harness.add({"process_soldier_behavior", soldiers, placed, "soldier", placed, 1, [rebuild, scenario, movers]() {
+        rebuild();
+        *movers = scenario->model->getSoldiers();
+    }, [scenario, movers]() {
+        for (auto& soldier : *movers) BenchAccess::soldierBehavior(*scenario->controller, soldier);
+    }});
+    
+    auto obs = std::make_shared<Observation>();
+    harness.add({"observe", soldiers, placed, "call", 1, 1000, rebuild, [scenario, obs]() {
+        scenario->controller->observe(1, *obs);
+    }});
+    
+    // 观测 + 序列化（发给Python的状态JSON，原 getStateJson）
+    auto buffer = std::make_shared<std::string>();
+    harness.add({"observation_json", soldiers, placed, "call", 1, 1000, rebuild, [scenario, obs, buffer]() {
+        scenario->controller->observe(1, *obs);
+        buffer->clear();
+        writeObservationJson(*obs, *buffer);
+    }});
+    
+    // 轮流在两队的各个基地寻找出兵位置
+    auto nextBase = std::make_shared<size_t>(0);
+    harness.add({"find_spawn_position", soldiers, placed, "call", 1, 1000, rebuild, [scenario, nextBase]() {
+        const auto& bases = scenario->model->bases;
+        const Base& base = *bases[(*nextBase)++ % bases.size()];
+        BenchAccess::spawnPosition(*scenario->controller, base.getTeam(), base.getPosition());
+    }});
+    
+    // 完整回合（双方规则AI），同一场景连续推进10回合
+    harness.add({"process_turn", soldiers, placed, "turn", 1, 10, rebuild, [scenario]() {
+        scenario->controller->step();
+    }});
+    return placed;
+}
+
+std::vector<int> parseSizes(const std::string& list) {
+    std::vector<int> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int size = std::atoi(item.c_str());
+        if (size > 0) sizes.push_back(size);
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 12345;
+    double minTimeMs = 200.0;
+    std::string filter;
+    std::string outPath;
+    std::vector<int> sizes = {10, 100, 500, 2000};
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--min-time-ms" && i + 1 < argc) minTimeMs = std::atof(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--sizes" && i + 1 < argc) sizes = parseSizes(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [OPTIONS]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --seed <N>          Scenario seed (default: 12345)\n";
+            std::cout << "  --min-time-ms <ms>  Minimum measured time per case (default: 200)\n";
+            std::cout << "  --filter <text>     Only run cases whose name contains text\n";
+            std::cout << "  --sizes <list>      Soldier counts, comma separated (default: 10,100,500,2000)\n";
+            std::cout << "  --out <file>        Write the JSON report to file instead of stdout\n";
+            return 0;
+        }
+    }
+    
+    BenchHarness harness(minTimeMs);
+    for (int soldiers : sizes) {
+        int placed = addCases(harness, soldiers, seed);
+        if (placed < soldiers * MIN_PLACED_RATIO) {
+            std::cerr << "Scenario with " << soldiers << " soldiers only placed " << placed
+                      << " (not enough free cells for seed " << seed << ")" << std::endl;
+            return 1;
+        }
+    }
+    std::string report = BenchHarness::toJson(harness.run(filter), seed, minTimeMs);
+    
+    if (outPath.empty()) {
+        std::cout << report << std::endl;
+    } else {
+        std::ofstream out(outPath);
+        if (!out) {
+            std::cerr << "Cannot write " << outPath << std::endl;
+            return 1;
+        }
+        out << report << std::endl;
+    }
+    return 0;
+}
@@ -2,6 +2,8 @@
 #define AI_CONTROLLER_H
 
 #include "Model.h"
+#include "GameTypes.h"
+#include "GameState.h"
 #include <vector>
 #include <memory>
 #include <mutex>
@@ -17,17 +19,18 @@ class AIController {
 private:
     std::vector<SoldierType> purchaseQueue;
     std::mutex queueMutex;
-    std::mt19937& rng;
+    RngStream& rng;  // 本队的购买随机数流（属于模型的随机数上下文）
     
 public:
-    explicit AIController(std::mt19937& rng);
+    explicit AIController(RngStream& rng);
     
     // AI购买逻辑 (尝试购买一次，需要GameController来调用purchaseSoldier)
-    // 返回值: JSON格式的动作字符串（如果无法购买则返回wait动作）
-    std::string tryPurchaseOnce(std::shared_ptr<GameModel> model, GameController* controller, int turnCount, Team team);
+    // 返回值: 实际执行的动作（如果无法购买则返回wait动作）
+    Action tryPurchaseOnce(std::shared_ptr<GameModel> model, GameController* controller, int turnCount, Team team);
     
-    // AI移动决策
-    std::vector<Position> getMoveCandidates(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier);
+    // AI移动决策（移动扰动使用控制器传入的移动随机数流）
+    std::vector<Position> getMoveCandidates(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier,
+                                            RngStream& moveRng);
     std::vector<Position> getRetreatPositions(const Position& currentPos, const Position& enemyPos);
     
     // 辅助函数
@@ -40,6 +43,10 @@ public:
     
     // 计算位置的拥挤度（周围己方士兵数量）
     int getCrowdednessAtPosition(std::shared_ptr<GameModel> model, const Position& pos, Team team, int radius);
+    
+    // 快照上的规则AI出兵（MCTS 的默认策略）：queueHead 相当于购买队列的队首，
+    // 下一回合的能量够买时在随机存活基地出兵，并随机抽取新的队首；否则等待
+    static Action rolloutPurchase(const GameState& state, int team, SoldierType& queueHead, RngStream& rng);
 };
 
 #endif // AI_CONTROLLER_H
@@ -13,8 +13,9 @@ using namespace GameConstants;
 class CombatSystem {
 public:
     // 处理所有战斗，返回每个队伍的治疗量统计 {team -> heal_amount}
-    // 收集战斗事件，需要当前回合数
-    static std::map<int, int> processCombat(std::shared_ptr<GameModel> model, std::vector<GameEvent>& events, int currentTurn);
+    // 收集战斗事件，需要当前回合数；verbose 为 false 时不输出击杀信息（搜索/批量环境中的模拟）
+    static std::map<int, int> processCombat(std::shared_ptr<GameModel> model, std::vector<GameEvent>& events, int currentTurn,
+                                            bool verbose = true);
     
     // 政击目标，返回是否击杀
     static bool attackTarget(std::shared_ptr<Soldier> attacker, std::shared_ptr<Soldier> target, std::shared_ptr<GameModel> model, std::vector<GameEvent>& events, int currentTurn);
@@ -11,6 +11,7 @@ namespace GameConstants {
     constexpr float CELL_SIZE = static_cast<float>(WINDOW_WIDTH) / MAP_SIZE;
     constexpr int TURN_DURATION_MS = 250;  // 每回合 1 秒
     constexpr int MAX_TURNS = 500;  // 最大回合数限制
+    constexpr int MAX_SOLDIERS = MAP_SIZE * MAP_SIZE;  // 同时存在的士兵上限（出兵时检查，快照按它分配容量）
     
     // 基地数量配置
     constexpr int BASE_COUNT_PER_TEAM = 3;  // 每队基地数量
@@ -111,6 +112,29 @@ namespace GameConstants {
         constexpr int HEAL_RANGE = 2;        // 治疗范围
     }
     
+    // 兵种属性表（按 SoldierType 的枚举值索引）
+    struct SoldierStats {
+        int hp;
+        int attack;
+        int attackRange;
+        int visionRange;
+        int moveSpeed;
+        int armor;
+    };
+    
+    constexpr int SOLDIER_TYPE_COUNT = 5;
+    constexpr SoldierStats SOLDIER_STATS[SOLDIER_TYPE_COUNT] = {
+        {Archer::HP, Archer::ATTACK, Archer::ATTACK_RANGE, Archer::VISION_RANGE, Archer::MOVE_SPEED, Archer::ARMOR},
+        {Infantry::HP, Infantry::ATTACK, Infantry::ATTACK_RANGE, Infantry::VISION_RANGE, Infantry::MOVE_SPEED, Infantry::ARMOR},
+        {Cavalry::HP, Cavalry::ATTACK, Cavalry::ATTACK_RANGE, Cavalry::VISION_RANGE, Cavalry::MOVE_SPEED, Cavalry::ARMOR},
+        {Caster::HP, Caster::ATTACK, Caster::ATTACK_RANGE, Caster::VISION_RANGE, Caster::MOVE_SPEED, Caster::ARMOR},
+        {Doctor::HP, Doctor::ATTACK, Doctor::ATTACK_RANGE, Doctor::VISION_RANGE, Doctor::MOVE_SPEED, Doctor::ARMOR}
+    };
+    
+    constexpr const SoldierStats& getSoldierStats(SoldierType type) {
+        return SOLDIER_STATS[static_cast<int>(type)];
+    }
+    
     // 队友通信系统
     constexpr int COMMUNICATION_RANGE = 15;  // 队友间视野共享的最大距离
 }
@@ -6,12 +6,17 @@
 #include "CombatSystem.h"
 #include "GameTypes.h"
 #include "PythonAgent.h"
+#include "NativePolicy.h"
+#include "MctsPlanner.h"
 #include "TrainingLogger.h"
+#include "Observation.h"
+#include "GameState.h"
+#include "Replay.h"
 #include <thread>
+#include <mutex>
 #include <atomic>
 #include <vector>
 #include <memory>
-#include <random>
 #include <string>
 
 // 游戏控制器类
@@ -20,9 +25,9 @@ private:
     std::shared_ptr<GameModel> model;
     std::atomic<bool> running;
     std::vector<std::thread> workerThreads;
+    std::mutex turnMutex;  // 回合处理期间持有，View的购买请求需等待回合结束
     
-    // AI控制器和随机数生成器
-    std::mt19937 rng;
+    // AI控制器（随机数来自模型的随机数上下文，各队一条独立的流）
     std::unique_ptr<AIController> aiControllerTeam0;  // Team 0的AI控制器
     std::unique_ptr<AIController> aiControllerTeam1;  // Team 1的AI控制器
     
@@ -33,10 +38,21 @@ private:
     
     // Python AI代理
     std::unique_ptr<PythonAgent> pythonAgent;
+    std::string stateBuffer;  // 发给Python的状态JSON（跨回合复用）
+    
+    // 原生策略网络（AI_NATIVE）
+    std::unique_ptr<NativePolicy> nativePolicy;
+    
+    // 蒙特卡洛树搜索（AI_MCTS），两队共用一个线程池和每回合的时间预算
+    std::unique_ptr<MctsPlanner> mctsPlanner;
+    bool mctsFallbackReported;  // 快照失败、改用规则AI的提示只输出一次
     
     // 训练日志记录器
     std::unique_ptr<TrainingLogger> trainingLogger;
     
+    // 比赛录像（--record），开局和每回合结束时各记录一次
+    std::unique_ptr<ReplayRecorder> replayRecorder;
+    
     // 回合计数器
     int currentTurn;
     
@@ -44,32 +60,74 @@ private:
     int team0HealThisTurn;
     int team1HealThisTurn;
     
+    // 外部智能体（PlayerType::EXTERNAL）下一回合的动作，以及本回合发生的事件（用于计算奖励）
+    Action externalActions[2];
+    std::vector<GameEvent> turnEvents;
+    
+    // 是否输出回合状态
+    bool verbose;
+    
 public:
+    // sharedPolicy 不为空时，AI_NATIVE 复制它（共享已加载的权重），不再从 python/policy_model.bin 加载
     explicit GameController(std::shared_ptr<GameModel> model, 
                            GameMode mode = GameMode::HUMAN_VS_AI,
                            PlayerType team0 = PlayerType::HUMAN,
-                           PlayerType team1 = PlayerType::AI_RULE_BASED);
+                           PlayerType team1 = PlayerType::AI_RULE_BASED,
+                           const NativePolicy* sharedPolicy = nullptr);
     ~GameController();
     
     // 游戏控制
     void start();
     void stop();
+    
+    // 在调用线程中运行整局游戏直到结束（不创建工作线程，供多局并行训练使用）
+    void runToCompletion();
     bool isRunning() const { return running.load(); }
     
     // 游戏循环
     void gameLoop();
     
-    // 公共接口：供View调用
-    bool purchaseSoldier(Team team, SoldierType type, const Position& basePos);
+    // 购买士兵（回合处理内部使用）
+    // spawnedId 不为空时写入新士兵的ID
+    bool purchaseSoldier(Team team, SoldierType type, const Position& basePos, SoldierId* spawnedId = nullptr);
+    
+    // 公共接口：供View调用，与回合处理互斥（士兵存储在回合内不能被其他线程修改）
+    bool requestPurchase(Team team, SoldierType type, const Position& basePos);
     
     // 获取当前回合数
     int getCurrentTurn() const { return currentTurn; }
     
     // 设置游戏模式
     void setGameMode(GameMode mode, PlayerType team0, PlayerType team1);
+    
+    // 逐回合推进（VecEnv使用，不创建线程，调用方负责在 isGameOver 后停止）
+    void reset();                                         // 初始化模型，回到第0回合
+    void setExternalAction(int team, const Action& action);  // 设置外部智能体下一回合的动作（执行一次）
+    void step();                                          // 处理一个回合
+    const std::vector<GameEvent>& getTurnEvents() const { return turnEvents; }  // 仅有外部智能体时记录
+    
+    // 一次遍历士兵填充某队伍视角的观测（不分配内存）
+    void observe(int team, Observation& obs);
+    
+    // 是否输出回合状态、击杀信息和训练日志的写入提示（默认输出）
+    void setVerbose(bool value) {
+        verbose = value;
+        if (trainingLogger) trainingLogger->setVerbose(value);
+    }
+    
+    // 把本局录像写到 path（在 start 之前调用）；文件无法打开时返回 false
+    bool recordReplay(const std::string& path);
+    
+    // 快照（回合之间调用）：保存/载入模型状态以及回合数、治疗量和随机数状态
+    // saveState 不改变本局的随机序列；士兵数超出快照容量时返回 false
+    bool saveState(GameState& state) const;
+    void loadState(const GameState& state);
 
     
 private:
+    // 基准测试（bench/bench_main.cpp）直接测量回合内的各个阶段
+    friend struct BenchAccess;
+    
     // 回合处理
     void processTurn();
     
@@ -88,14 +146,28 @@ private:
     // 检查游戏结束
     void checkGameOver();
     
-    // 状态序列化为JSON（75维特征）
-    std::string getStateJson(int team);
+    // 记录游戏事件（转给训练日志，有外部智能体时同时记入 turnEvents）
+    void recordEvent(const GameEvent& event);
+    
+    // 按游戏模式创建搜索规划器（训练模式使用 MctsPlanner::trainingConfig）
+    std::unique_ptr<MctsPlanner> createMctsPlanner() const;
+    
+    // 策略网络代理（Python/原生）是否可用，以及向其查询动作
+    // 原生策略直接使用观测；Python代理在边界处序列化为JSON（复用 stateBuffer）
+    bool hasPolicyAgent(PlayerType type) const;
+    Action getPolicyAction(PlayerType type, const Observation& obs);
+    
+    // Python AI返回的动作JSON转为Action（无法解析时返回wait）
+    static Action parseActionJson(const std::string& actionJson);
+    
+    // 执行动作（出兵时扣能量并记录生成事件）
+    bool executeAction(int team, const Action& action);
     
-    // 执行Python AI的动作
-    void executeAIAction(int team, const std::string& actionJson);
+    // 执行外部智能体通过 setExternalAction 设置的动作，返回实际执行成功的动作（否则为wait）
+    Action executeExternalAction(int team);
     
-    // 解析动作JSON并执行
-    bool parseAndExecuteAction(int team, const std::string& actionJson);
+    // 执行一个动作，返回实际执行成功的动作（否则为wait）
+    Action executeSingleAction(int team, const Action& action);
     
     // 计算基地周围的士兵数量
     void countNearbySoldiers(const Position& basePos, int& allies, int& enemies, int team);
@@ -0,0 +1,73 @@
+#ifndef DATASETWRITER_H
+#define DATASETWRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+
+// 二进制列式训练数据集（分片）
+// 每个分片文件只写一次（先写临时文件再改名），各列定长、64字节对齐，可以直接 np.memmap
+//
+// 文件格式（小端）：
+//   char[4]  magic = "DSDS"
+//   uint32   version = 1
+//   uint32   feature_dim
+//   uint32   game_count
+//   uint64   row_count
+//   uint64   features_offset   float32[row_count][feature_dim]   Team 1 视角的决策前状态特征
+//   uint64   actions_offset    int8[row_count][6]                team0 (action_type, base_id, unit_type), team1 (同左)
+//   uint64   rewards_offset    float32[row_count][2]             每回合即时奖励 (team0, team1)
+//   uint64   games_offset      每局 {uint64 row_start, uint32 row_count, int32 winner}
+//   uint32   feature_version   FeatureEncoder::VERSION（0 表示早于该字段的分片，编码与 version 1 相同）
+//   uint32   reserved
+struct DatasetGame {
+    std::vector<float> features;  // [turns][FEATURE_DIM]
+    std::vector<int8_t> actions;  // [turns][ACTION_FIELDS]
+    std::vector<float> rewards;   // [turns][2]
+    int winner = -1;
+
+    size_t rows() const { return rewards.size() / 2; }
+    void clear() { features.clear(); actions.clear(); rewards.clear(); winner = -1; }
+};
+
+class DatasetWriter {
+public:
+    static constexpr char MAGIC[4] = {'D', 'S', 'D', 'S'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int ACTION_FIELDS = 6;
+    static constexpr size_t HEADER_SIZE = 64;
+    static constexpr size_t COLUMN_ALIGNMENT = 64;
+    static constexpr size_t DEFAULT_SHARD_ROWS = 65536;
+
+    explicit DatasetWriter(const std::string& directory, size_t shardRows = DEFAULT_SHARD_ROWS);
+    ~DatasetWriter();  // 写出未满的分片
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    // 追加一整局（同一局不会跨分片）；累计行数达到 shardRows 时写出分片。线程安全
+    void appendGame(const DatasetGame& game);
+
+    // 立即写出当前分片（为空时不做任何事）。线程安全
+    void flush();
+
+private:
+    std::string directory;
+    size_t shardRows;
+    std::string shardPrefix;  // 目录 + 启动时间 + 进程号，同一目录下多次运行不冲突
+    int shardSequence;        // 下一个分片的序号（成功写出后递增）
+    size_t droppedRows;       // 写失败而丢弃的行数
+
+    std::mutex mutex;
+    DatasetGame pending;                 // 当前分片的列（按局拼接）
+    std::vector<uint64_t> gameStarts;
+    std::vector<uint32_t> gameRows;
+    std::vector<int32_t> gameWinners;
+
+    void writeShard();  // 调用者持有 mutex；失败时丢弃该分片
+    void dropShard(const std::string& message);
+    void clearPending();
+};
+
+#endif // DATASETWRITER_H
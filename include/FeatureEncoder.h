@@ -0,0 +1,43 @@
+#ifndef FEATUREENCODER_H
+#define FEATUREENCODER_H
+
+#include "Observation.h"
+#include <string>
+#include <cstdint>
+
+// 特征编码器 - 79维状态特征的唯一实现
+// 原生推理、训练日志（二进制数据集）和 Python（通过 libds_features 的 C 接口）都使用这里的编码，
+// 布局改变时必须增加 VERSION，数据集分片和 python/features.py 会据此检查是否一致
+//
+// 布局（version 1）：
+//   [0, 2)   双方能量 / 1000
+//   [2, 4)   双方基地总HP / 50000
+//   [4, 6)   双方士兵数 / 100
+//   [6, 16)  双方各兵种数量 / 20（archer, infantry, cavalry, caster, doctor）
+//   [16, 37) 我方前3个基地 × (hp/15000, x/64, y/64, 附近我方/20, 附近敌方/20, 是否被攻击, 到我方最近基地距离/64)
+//   [37, 58) 敌方前3个基地，同上
+//   [58, 64) 战场分布 (my_front, my_mid, my_back, enemy_front, enemy_mid, enemy_back) / 20
+//   [64, 66) 双方治疗量 / 100
+//   [66]     游戏是否结束
+//   [67, 79) 补0
+class FeatureEncoder {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int FEATURE_DIM = 79;
+
+    // 从观测编码（游戏内使用）
+    static void encode(const Observation& obs, float* features);
+
+    // 从状态JSON编码（旧日志和Python边界使用，缺失字段的默认值与旧版 parse_state_to_features 一致）
+    // JSON无法解析时特征全为0并返回false
+    static bool encodeJson(const char* stateJson, size_t length, float* features);
+    static bool encodeJson(const std::string& stateJson, float* features) {
+        return encodeJson(stateJson.data(), stateJson.size(), features);
+    }
+
+    // 编码一局日志（game_log.jsonl 的一行）中每个回合的 state，写入 features[回合][FEATURE_DIM]
+    // 返回回合数（可能大于 capacity，此时只写前 capacity 行）；无法解析时返回-1
+    static int64_t encodeGameJson(const char* gameJson, size_t length, float* features, int64_t capacity);
+};
+
+#endif // FEATUREENCODER_H
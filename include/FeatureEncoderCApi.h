@@ -0,0 +1,38 @@
+#ifndef FEATUREENCODERCAPI_H
+#define FEATUREENCODERCAPI_H
+
+// libds_features 的 C 接口（供 python/features.py 通过 ctypes 加载）
+// 特征布局见 FeatureEncoder.h；调用方应先检查 ds_feature_version 与自己期望的版本一致
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define DS_FEATURES_API __declspec(dllexport)
+#else
+#define DS_FEATURES_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+DS_FEATURES_API uint32_t ds_feature_version(void);
+DS_FEATURES_API int32_t ds_feature_dim(void);
+
+// 编码一个状态JSON到 features[ds_feature_dim()]，成功返回1，无法解析返回0（特征全为0）
+DS_FEATURES_API int32_t ds_encode_state(const char* state_json, size_t length, float* features);
+
+// 编码一局日志中所有回合的状态到 features[capacity][ds_feature_dim()]
+// 返回回合数（大于 capacity 时只写了前 capacity 行，可按返回值重新分配后再调用）；无法解析返回-1
+DS_FEATURES_API int64_t ds_encode_game(const char* game_json, size_t length, float* features, int64_t capacity);
+
+// 用原生策略网络（NativePolicy）对 features[rows][ds_feature_dim()] 做前向传播，写入 logits[rows][10]
+// 返回 rows；权重文件无法加载返回-1（export_weights.py --check 用它核对导出结果）
+DS_FEATURES_API int64_t ds_policy_forward(const char* weights_path, const float* features, int64_t rows, float* logits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FEATUREENCODERCAPI_H
@@ -0,0 +1,55 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include "Model.h"
+#include "GameTypes.h"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// 快照中的士兵（回合之间没有死亡的士兵，不需要存活标记）
+struct SoldierState {
+    uint8_t x;
+    uint8_t y;
+    uint8_t team;  // Team 的枚举值
+    uint8_t type;  // SoldierType 的枚举值
+    int16_t hp;
+};
+
+// 快照中的基地（maxHp 固定为 BASE_HP）
+struct BaseState {
+    uint8_t x;
+    uint8_t y;
+    int32_t hp;
+};
+
+// 游戏状态快照：回合之间的完整局面，可平凡复制（克隆就是一次 memcpy），供搜索和 rollout 使用
+// - 地形开局后不再变化，只保存指向来源 GameMap 地形的指针，来源模型必须比快照活得久
+// - 士兵按组件存储的顺序保存（模拟结果与顺序有关）；士兵ID不保存，载入时重新分配
+// - 随机数上下文（各用途的计数器）整体保存，同一快照加同样的动作总能得到与原局面相同的结果；
+//   搜索需要不同的随机序列时直接替换 rng
+struct GameState {
+    // 与出兵上限相同，正常游戏中的局面总能保存
+    static constexpr int MAX_SOLDIERS = GameConstants::MAX_SOLDIERS;
+    
+    const TerrainGrid* terrain = nullptr;
+    int32_t turn = 0;
+    int32_t energy[2] = {0, 0};
+    int32_t healDone[2] = {0, 0};  // 上一回合的治疗量（观测的一部分）
+    RngContext rng;
+    int8_t gameOver = 0;
+    int8_t winner = -1;            // 结束时为获胜队伍，否则为-1
+    int16_t soldierCount = 0;
+    BaseState bases[2][BASE_COUNT_PER_TEAM] = {};
+    SoldierState soldiers[MAX_SOLDIERS];  // 只有前 soldierCount 项有效
+};
+
+static_assert(std::is_trivially_copyable_v<GameState>, "GameState must clone with a plain memcpy");
+
+// 从快照推进一回合：两队各执行 actions[team]（每回合最多出一个兵，与 PlayerType::EXTERNAL 相同），
+// 之后的移动、战斗、清理和胜负判定与正常游戏是同一份代码——每个线程复用一组
+// GameModel/GameController，先载入快照，step 一回合，再保存回快照
+// events 不为空时写入本回合的事件；快照已经结束时不做任何事；士兵数超出容量时返回 false（快照不变）
+bool simulateTurn(GameState& state, const Action (&actions)[2], std::vector<GameEvent>* events = nullptr);
+
+#endif // GAMESTATE_H
@@ -1,7 +1,9 @@
 #ifndef GAMETYPES_H
 #define GAMETYPES_H
 
+#include "Constants.h"
 #include <string>
+#include <cstdint>
 
 // 游戏模式枚举
 enum class GameMode {
@@ -14,7 +16,10 @@ enum class GameMode {
 enum class PlayerType {
     HUMAN,           // 人类玩家
     AI_PYTHON,       // Python强化学习AI
-    AI_RULE_BASED    // C++规则AI（当前的AIController）
+    AI_RULE_BASED,   // C++规则AI（当前的AIController）
+    AI_NATIVE,       // C++原生推理的策略网络（与AI_PYTHON同一模型，无需Python）
+    AI_MCTS,         // 蒙特卡洛树搜索出兵（MctsPlanner，rollout 使用规则AI）
+    EXTERNAL         // 外部智能体：每回合的动作由调用方传入（VecEnv）
 };
 
 // 游戏事件类型，用于强化学习
@@ -35,8 +40,9 @@ struct GameEvent {
     std::string description;
     
     // 可选字段
-    int soldier_id = -1;
-    int target_id = -1;
+    int soldier_id = -1;   // 事件发起士兵的ID（SoldierId）
+    int target_id = -1;    // 目标士兵的ID（SoldierId）
+    int base_id = -1;      // 相关基地在本队基地列表中的索引（如出兵基地）
     int damage = 0;
     int reward_energy = 0;
     
@@ -44,7 +50,34 @@ struct GameEvent {
         : type(t), team(tm), turn(tn), description(desc) {}
 };
 
+// 动作类型（数值与训练数据中的 action_type 一致）
+enum class ActionType : int8_t {
+    WAIT = 0,        // 本回合不出兵
+    SPAWN = 1        // 在 baseId 对应的基地生成 unit
+};
+
+// 出兵决策：规则AI、原生策略网络和Python AI 共用，只在日志和Python边界转换为JSON
+struct Action {
+    ActionType type = ActionType::WAIT;
+    int8_t baseId = -1;  // 本队基地列表中的下标
+    GameConstants::SoldierType unit = GameConstants::SoldierType::ARCHER;  // 仅 SPAWN 有效
+    
+    static Action wait() { return Action{}; }
+    static Action spawn(int baseId, GameConstants::SoldierType unit) {
+        return Action{ActionType::SPAWN, static_cast<int8_t>(baseId), unit};
+    }
+    
+    bool isWait() const { return type == ActionType::WAIT; }
+    int unitTypeId() const { return type == ActionType::SPAWN ? static_cast<int>(unit) : -1; }  // 兵种编号 0-4，WAIT 为 -1
+};
+
 // 辅助函数
+inline std::string actionToJson(const Action& action) {
+    return "{\"action_type\": " + std::to_string(static_cast<int>(action.type)) +
+           ", \"base_id\": " + std::to_string(action.baseId) +
+           ", \"unit_type\": " + std::to_string(action.unitTypeId()) + "}";
+}
+
 inline std::string gameModeToString(GameMode mode) {
     switch (mode) {
         case GameMode::TRAINING: return "training";
@@ -59,6 +92,9 @@ inline std::string playerTypeToString(PlayerType type) {
         case PlayerType::HUMAN: return "human";
         case PlayerType::AI_PYTHON: return "ai_python";
         case PlayerType::AI_RULE_BASED: return "ai_rule_based";
+        case PlayerType::AI_NATIVE: return "ai_native";
+        case PlayerType::AI_MCTS: return "ai_mcts";
+        case PlayerType::EXTERNAL: return "external";
         default: return "unknown";
     }
 }
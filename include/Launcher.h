@@ -0,0 +1,39 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include "GameTypes.h"
+#include "Controller.h"
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <string>
+
+// 命令行配置（图形界面 DS_PJ 和无界面的 ds_train 共用）
+struct GameConfig {
+    GameMode mode = GameMode::HUMAN_VS_AI;
+    PlayerType team0 = PlayerType::HUMAN;
+    PlayerType team1 = PlayerType::AI_RULE_BASED;
+    int games = 0;    // >0 时在进程内并行运行多局训练（隐含 training 模式）
+    int threads = 0;  // 0 表示使用全部CPU核心
+    uint64_t seed = 0;  // 整局（或 --games 的基础）随机种子；没有 --seed 时 parseArgs 随机选择并打印
+    std::string recordPath;  // 非空时把单局录像写到该文件（见 Replay.h）
+    std::string replayPath;  // 非空时在图形界面中回放录像，不运行游戏（只有 DS_PJ 支持）
+};
+
+// 全局标志：用于处理Ctrl+C中断
+extern std::atomic<bool> g_interrupted;
+
+// 解析命令行参数，未指定的选项取 defaults 中的值；--help 时打印用法并退出
+GameConfig parseArgs(int argc, char* argv[], const GameConfig& defaults = GameConfig());
+
+// 切换到项目根目录（可执行文件的上一级目录），这样相对路径 python/infer.py 就能正确找到
+void changeToProjectRoot();
+
+// 注册Ctrl+C处理函数；controller 非空时中断会停止它，触发保存
+void installInterruptHandler();
+void setInterruptTarget(std::shared_ptr<GameController> controller);
+
+// 无界面运行：--games > 0 时多局并行，否则在当前进程中运行单局（不创建View）
+int runHeadless(const GameConfig& config);
+
+#endif // LAUNCHER_H
@@ -0,0 +1,77 @@
+#ifndef MCTSPLANNER_H
+#define MCTSPLANNER_H
+
+#include "GameState.h"
+#include "GameTypes.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// 蒙特卡洛树搜索配置
+struct MctsConfig {
+    int budgetMs = 100;        // 每回合的搜索时间，两队都搜索时共用（限制在 MctsPlanner::MAX_BUDGET_MS 以内）
+    int threads = 0;           // 根并行的线程数，0 表示使用全部CPU核心
+    int maxIterations = 0;     // >0 时每个线程固定迭代次数、不看时间（相同种子结果可复现）
+    int horizon = 8;           // 每次迭代从根开始模拟的回合数（树内 + rollout）
+    double exploration = 1.0;  // UCB1 探索系数
+};
+
+// 出兵决策的蒙特卡洛树搜索（PlayerType::AI_MCTS）
+// - 动作：等待，或在某个基地出某种兵（每回合最多一个，与外部智能体相同）
+// - 开环树：节点只记录本方的动作序列，每次迭代从根快照重新模拟（每次换一个随机种子），
+//   对手以及 rollout 中的双方都按规则AI的出兵规则行动（AIController::rolloutPurchase）
+// - 已知限制：simulateTurn 每队每回合只执行一个动作，rollout 中的规则AI因此每回合最多出一个兵，
+//   而真实的规则AI每回合最多购买 MAX_PURCHASES_PER_TURN（3）次——开局（初始能量充足）和击杀奖励之后
+//   搜索会低估对手的出兵；AI_MCTS 一方在实际对局中同样每回合最多出一个兵，能量多时会积压
+// - 根并行：每个线程独立建树，最后把根节点各动作的访问次数相加，选访问最多的动作
+// - 两队都是 AI_MCTS 时同时搜索，线程池按队伍平分，整个回合只花一份时间预算
+// - 评估：已结束的局面按胜负记 1/0，否则按双方基地HP差和兵力（含能量）差映射到 [0, 1]
+class MctsPlanner {
+public:
+    static constexpr int MAX_BUDGET_MS = TURN_DURATION_MS * 4 / 5;  // 留出回合内移动和战斗的时间
+    static constexpr int ACTION_COUNT = 1 + BASE_COUNT_PER_TEAM * SOLDIER_TYPE_COUNT;
+    static constexpr int TRAINING_ITERATIONS = 16;  // 训练模式未指定 --mcts-iterations 时每线程的迭代次数
+    
+    explicit MctsPlanner(const MctsConfig& config = defaultConfig());
+    
+    MctsPlanner(const MctsPlanner&) = delete;
+    MctsPlanner& operator=(const MctsPlanner&) = delete;
+    
+    // 在回合开始前的快照 root 上为 searching[t] 为真的队伍选择本回合的动作（其余队伍为等待），
+    // seeds[t] 派生该队各线程的随机种子
+    void plan(const GameState& root, const bool (&searching)[2], const uint64_t (&seeds)[2], Action (&actions)[2]);
+    
+    // 命令行设置的默认配置（之后创建的规划器使用）
+    static void setDefaultConfig(const MctsConfig& config);
+    static MctsConfig defaultConfig();
+    
+    // 训练模式（无回合计时、多局并行）使用的配置：未指定迭代次数时改为每线程 TRAINING_ITERATIONS 次
+    // （不按墙钟时间，结果可复现），未指定线程数时单线程
+    static MctsConfig trainingConfig(MctsConfig config);
+    
+    // 动作编号 -> Action：0 为等待，其余为 基地 * SOLDIER_TYPE_COUNT + 兵种 + 1
+    static Action actionAt(int index);
+    
+private:
+    // 一个线程搜索结束后根节点各动作的统计
+    struct RootStats {
+        int visits[ACTION_COUNT];
+        double value[ACTION_COUNT];
+    };
+    
+    MctsConfig config;
+    ThreadPool pool;
+    std::vector<RootStats> results;  // 每个搜索任务一份（按队伍分组）
+    
+    // budget 从任务开始执行时计时
+    void search(const GameState& root, int team, uint64_t seed,
+                std::chrono::milliseconds budget, RootStats& stats) const;
+    static bool needsSearch(const GameState& root, int team);
+    static int bestAction(const RootStats* stats, size_t count);
+    
+    static double evaluate(const GameState& state, int team);
+};
+
+#endif // MCTSPLANNER_H
@@ -2,11 +2,16 @@
 #define MODEL_H
 
 #include "Constants.h"
+#include "SlotMap.h"
+#include "RngContext.h"
 #include <vector>
 #include <memory>
 #include <mutex>
 #include <atomic>
-#include <set>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <array>
 
 using namespace GameConstants;
 
@@ -32,45 +37,59 @@ struct Position {
     }
 };
 
+// 距离度量
+enum class DistanceMetric {
+    MANHATTAN,  // 曼哈顿距离（移动、治疗、法师溅射）
+    CHEBYSHEV   // 切比雪夫距离（攻击、视野）
+};
+
+inline int metricDistance(DistanceMetric metric, int dx, int dy) {
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return metric == DistanceMetric::MANHATTAN ? dx + dy : std::max(dx, dy);
+}
+
+// 士兵ID：GameModel 中槽位映射的句柄，跨回合稳定，士兵被移除后失效
+using SoldierId = int32_t;
+constexpr SoldierId INVALID_SOLDIER_ID = -1;
+
+class GameModel;
+struct GameState;
+
 // 士兵类
+// 兵种属性来自 SOLDIER_STATS 表；位置和生命值的修改会同步到所属 GameModel 的组件存储
+// 士兵数据只由游戏循环线程修改，读取不加锁（渲染线程读取 GameModel 发布的 RenderSnapshot）
 class Soldier {
 protected:
     Position position;
     SoldierType type;
     Team team;
     int hp;
-    int maxHp;
-    int attack;
-    int attackRange;
-    int visionRange;
-    int moveSpeed;
-    int armor;
     std::atomic<bool> alive;
-    mutable std::mutex mutex;
-    
-    // 视野共享系统
-    std::set<int> lastTurnVisibleEnemies;  // 上一回合可见的敌人ID列表
-    std::set<int> sharedVisibleEnemies;     // 本回合队友共享的敌人ID列表
-    mutable std::mutex visionMutex;         // 视野数据的互斥锁
+    SoldierId id;       // 加入GameModel时分配
+    GameModel* owner;   // 所属GameModel（未加入时为nullptr）
     
 public:
     Soldier(Position pos, SoldierType type, Team team);
     virtual ~Soldier() = default;
     
     // Getters
-    Position getPosition() const;
+    Position getPosition() const { return position; }
     SoldierType getType() const { return type; }
     Team getTeam() const { return team; }
     int getHp() const { return hp; }
-    int getMaxHp() const { return maxHp; }
-    int getAttack() const { return attack; }
-    int getAttackRange() const { return attackRange; }
-    int getVisionRange() const { return visionRange; }
-    int getMoveSpeed() const { return moveSpeed; }
-    int getArmor() const { return armor; }
-    bool isAlive() const { return alive.load(); }
+    int getMaxHp() const { return getSoldierStats(type).hp; }
+    int getAttack() const { return getSoldierStats(type).attack; }
+    int getAttackRange() const { return getSoldierStats(type).attackRange; }
+    int getVisionRange() const { return getSoldierStats(type).visionRange; }
+    int getMoveSpeed() const { return getSoldierStats(type).moveSpeed; }
+    int getArmor() const { return getSoldierStats(type).armor; }
+    bool isAlive() const { return alive.load(std::memory_order_relaxed); }
+    SoldierId getId() const { return id; }
     
     // Setters
+    void attach(GameModel* model, SoldierId newId) { owner = model; id = newId; }
+    void detach() { owner = nullptr; }
     void setPosition(const Position& pos);
     void setHp(int newHp);  // 设置生命值（用于治疗）
     
@@ -78,12 +97,183 @@ public:
     void takeDamage(int damage);
     bool canAttack(const Position& target) const;
     bool canSee(const Position& target) const;
+};
+
+// 士兵组件存储（SoA）
+// 第i个元素对应 GameModel::soldiers[i]（两者按相同的交换删除规则同步），
+// 战斗、视野和AI扫描直接按列连续读取，不经过指针和锁
+struct SoldierColumns {
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> hp;
+    std::vector<uint8_t> team;        // Team 的枚举值
+    std::vector<uint8_t> type;        // SoldierType 的枚举值
+    std::vector<int32_t> visionGroup; // 共享视野组（回合开始时计算，之后新加入的士兵为-1）
+    std::vector<uint64_t> aliveBits;  // 存活位图，每64个士兵一个字
+    
+    size_t size() const { return x.size(); }
+    bool isAlive(size_t i) const { return (aliveBits[i >> 6] >> (i & 63)) & 1u; }
+    Position positionAt(size_t i) const { return Position(x[i], y[i]); }
+    Team teamAt(size_t i) const { return static_cast<Team>(team[i]); }
+    SoldierType typeAt(size_t i) const { return static_cast<SoldierType>(type[i]); }
+    const SoldierStats& statsAt(size_t i) const { return getSoldierStats(typeAt(i)); }
+    
+    void push(const Soldier& soldier);
+    void swapRemove(size_t i);  // 末尾元素换到位置i，与 SlotMap::erase 一致
+    void setAlive(size_t i, bool value);
+    void clear();
+};
+
+// 视野位图：每行一个 uint64_t，第x行的第y位表示格子(x, y)
+static_assert(MAP_SIZE <= 64, "VisionBoard stores one map row per uint64_t");
+
+struct VisionBoard {
+    uint64_t rows[MAP_SIZE];
+    
+    VisionBoard() { clear(); }
+    void clear() { std::fill(std::begin(rows), std::end(rows), uint64_t(0)); }
+    bool test(int x, int y) const {
+        return x >= 0 && x < MAP_SIZE && y >= 0 && y < MAP_SIZE && ((rows[x] >> y) & 1u);
+    }
+    void orSquare(int cx, int cy, SoldierType type);  // 并上该兵种以(cx, cy)为中心的视野方块
+    void orWith(const VisionBoard& other) {
+        for (int x = 0; x < MAP_SIZE; x++) rows[x] |= other.rows[x];
+    }
+};
+
+// 空间哈希：按队伍把存活士兵分到 8x8 格的桶里，存储的是组件存储中的下标
+// 由 GameModel 在士兵加入、移动、死亡和移除时增量维护
+// 查询回调中不能修改士兵的位置或存活状态（会改变桶的内容），需要时先收集下标再处理
+class SpatialHash {
+public:
+    static constexpr int BUCKET_SIZE = 8;
+    static constexpr int BUCKETS_PER_SIDE = (MAP_SIZE + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    
+private:
+    const SoldierColumns& cols;
+    std::vector<uint32_t> buckets[2][BUCKETS_PER_SIDE * BUCKETS_PER_SIDE];
+    
+    static int bucketCoord(int v) { return std::clamp(v / BUCKET_SIZE, 0, BUCKETS_PER_SIDE - 1); }
+    static int bucketOf(int x, int y) { return bucketCoord(x) * BUCKETS_PER_SIDE + bucketCoord(y); }
+    std::vector<uint32_t>& bucketFor(size_t index) {
+        return buckets[cols.team[index]][bucketOf(cols.x[index], cols.y[index])];
+    }
+    
+public:
+    explicit SpatialHash(const SoldierColumns& columns) : cols(columns) {}
+    
+    // 增量维护（均在组件存储修改之前调用，按当前列中的位置定位桶）
+    void insert(size_t index);
+    void remove(size_t index);
+    void move(size_t index, int newX, int newY);
+    void reindex(size_t from, size_t to);  // 交换删除时末尾元素的下标从 from 变为 to
+    void clear();
+    
+    // 对 team 中与 pos 距离 <= radius 的每个存活士兵调用 fn(下标)，顺序不定
+    template <typename Fn>
+    void forEachInRadius(const Position& pos, int radius, Team team, DistanceMetric metric, Fn&& fn) const {
+        int r = std::min(radius, 2 * MAP_SIZE);
+        int bx0 = bucketCoord(pos.x - r), bx1 = bucketCoord(pos.x + r);
+        int by0 = bucketCoord(pos.y - r), by1 = bucketCoord(pos.y + r);
+        const auto& teamBuckets = buckets[static_cast<int>(team)];
+        for (int bx = bx0; bx <= bx1; bx++) {
+            for (int by = by0; by <= by1; by++) {
+                for (uint32_t i : teamBuckets[bx * BUCKETS_PER_SIDE + by]) {
+                    if (metricDistance(metric, cols.x[i] - pos.x, cols.y[i] - pos.y) <= radius) {
+                        fn(static_cast<size_t>(i));
+                    }
+                }
+            }
+        }
+    }
+    
+    // team 中满足 pred(下标) 且距离 <= maxDistance 的最近士兵，距离相同时取下标最小的（与顺序扫描一致）
+    // 从 pos 所在的桶向外逐圈搜索，找不到时返回 -1
+    template <typename Pred>
+    int nearest(const Position& pos, Team team, DistanceMetric metric, Pred&& pred, int maxDistance = INT_MAX) const {
+        int cx = bucketCoord(pos.x), cy = bucketCoord(pos.y);
+        const auto& teamBuckets = buckets[static_cast<int>(team)];
+        int best = -1;
+        int bestDistance = INT_MAX;
+        
+        for (int ring = 0; ring < BUCKETS_PER_SIDE; ring++) {
+            // 第 ring 圈的桶到 pos 至少相隔 (ring-1) 个整桶
+            int lowerBound = ring == 0 ? 0 : (ring - 1) * BUCKET_SIZE + 1;
+            if (lowerBound > bestDistance || lowerBound > maxDistance) break;
+            
+            for (int bx = std::max(0, cx - ring); bx <= std::min(BUCKETS_PER_SIDE - 1, cx + ring); bx++) {
+                for (int by = std::max(0, cy - ring); by <= std::min(BUCKETS_PER_SIDE - 1, cy + ring); by++) {
+                    if (std::max(std::abs(bx - cx), std::abs(by - cy)) != ring) continue;
+                    for (uint32_t i : teamBuckets[bx * BUCKETS_PER_SIDE + by]) {
+                        int distance = metricDistance(metric, cols.x[i] - pos.x, cols.y[i] - pos.y);
+                        if (distance > maxDistance || distance > bestDistance) continue;
+                        if (distance == bestDistance && static_cast<int>(i) > best) continue;
+                        if (!pred(static_cast<size_t>(i))) continue;
+                        best = static_cast<int>(i);
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+};
+
+// 影响力图
+// - 密度：曼哈顿距离 DENSITY_RADIUS 内的己方存活士兵数（即 AI 的"拥挤度"）
+//   每回合开始时用菱形滤波整体重建，回合内随士兵移动/出生/死亡增量更新，因此任何时刻都是准确的
+//   网格四周各扩展 DENSITY_RADIUS 格，地图外相邻格子的查询同样有效
+// - 威胁：能攻击到该格的敌方士兵攻击力之和（按攻击范围分组做可分离的方框滤波），每回合开始时重建
+struct InfluenceMap {
+    static constexpr int DENSITY_RADIUS = 2;
+    static constexpr int PADDED_SIZE = MAP_SIZE + 2 * DENSITY_RADIUS;
+    static constexpr int MAX_ATTACK_RANGE = [] {
+        int range = 0;
+        for (const auto& stats : SOLDIER_STATS) range = std::max(range, stats.attackRange);
+        return range;
+    }();
+    
+    std::vector<int16_t> density[2];  // [(x + R) * PADDED_SIZE + (y + R)]
+    std::vector<int32_t> threat[2];   // threat[t] 是队伍t受到的威胁，[x * MAP_SIZE + y]
+    
+    // 重建时使用的临时缓冲区（避免每回合分配）
+    // 密度计算在 PADDED_SIZE 外再留 DENSITY_RADIUS 格保护边，滤波时不需要判断边界
+    static constexpr int GUARDED_SIZE = PADDED_SIZE + 2 * DENSITY_RADIUS;
+    std::vector<int16_t> cellCounts;                           // [GUARDED_SIZE * GUARDED_SIZE]
+    std::vector<int16_t> rowWindows[DENSITY_RADIUS + 1];       // rowWindows[w]：横向半宽w的窗口和
+    std::vector<int32_t> attackByRange[MAX_ATTACK_RANGE + 1];  // 按攻击范围累计的敌方攻击力
+    std::vector<int32_t> boxRows;
     
-    // 视野共享相关方法
-    void updateLastTurnVision(const std::set<int>& enemyIds);
-    void updateSharedVision(const std::set<int>& sharedEnemyIds);
-    std::set<int> getLastTurnVisibleEnemies() const;
-    std::set<int> getSharedVisibleEnemies() const;
+    InfluenceMap();
+    
+    int densityAt(Team team, const Position& pos) const {
+        int px = pos.x + DENSITY_RADIUS, py = pos.y + DENSITY_RADIUS;
+        if (px < 0 || px >= PADDED_SIZE || py < 0 || py >= PADDED_SIZE) return 0;
+        return density[static_cast<int>(team)][px * PADDED_SIZE + py];
+    }
+    int threatAt(Team team, const Position& pos) const {
+        if (pos.x < 0 || pos.x >= MAP_SIZE || pos.y < 0 || pos.y >= MAP_SIZE) return 0;
+        return threat[static_cast<int>(team)][pos.x * MAP_SIZE + pos.y];
+    }
+    
+    void addSoldier(Team team, int x, int y, int delta);  // 增量更新密度（delta = +1 / -1）
+    void rebuild(const SoldierColumns& cols);
+};
+
+// 占位网格：记录每个格子上存活士兵的数量和其中一个士兵的ID
+// 出兵位置不足时会在基地格上叠放士兵，因此按数量而不是单个ID判断占用
+struct OccupancyGrid {
+    std::vector<uint16_t> count;     // [x * MAP_SIZE + y]
+    std::vector<SoldierId> occupant; // 格子上的一个存活士兵（count为0时无意义）
+    
+    OccupancyGrid() : count(MAP_SIZE * MAP_SIZE, 0), occupant(MAP_SIZE * MAP_SIZE, INVALID_SOLDIER_ID) {}
+    
+    static bool inBounds(int x, int y) { return x >= 0 && x < MAP_SIZE && y >= 0 && y < MAP_SIZE; }
+    int countAt(int x, int y) const { return inBounds(x, y) ? count[x * MAP_SIZE + y] : 0; }
+    
+    void enter(int x, int y, SoldierId id);
+    void leave(int x, int y, SoldierId id, const SoldierColumns& cols, const SlotMap<std::shared_ptr<Soldier>>& soldiers);
+    void clear();
 };
 
 // 基地类
@@ -107,27 +297,72 @@ public:
     
     // 行为
     void takeDamage(int damage);
+    void setHp(int newHp) { hp.store(newHp); }  // 恢复快照时使用
 };
 
+// 地形网格：[x * MAP_SIZE + y]，开局生成后不再变化
+using TerrainGrid = std::array<TerrainType, MAP_SIZE * MAP_SIZE>;
+
 // 地图类
 class GameMap {
 private:
-    std::vector<std::vector<TerrainType>> terrain;
+    TerrainGrid terrain;
     mutable std::mutex mutex;
+    std::atomic<uint64_t> revision;  // 地形版本（调用者持有 mutex 时更新）
     
 public:
     GameMap();
     
-    void initialize(); // 生成地形和障碍
+    void initialize(RngStream& rng); // 生成地形和障碍（随机数来自所属GameModel的地图流）
     bool isWalkable(const Position& pos) const; // 判断是否可通行
     bool isValidPosition(const Position& pos) const; // 是否在地图内
     TerrainType getTerrainAt(const Position& pos) const;
     void setTerrainAt(const Position& pos, TerrainType type);
     
+    // 整张地形（开局后只读，GameState 通过指针引用它）
+    const TerrainGrid& getTerrain() const { return terrain; }
+    bool assignTerrain(const TerrainGrid& grid);  // 返回地形是否发生变化
+    
+    // 地形每次变化时换成一个全局唯一的新版本号（不同的地图对象也不会相同），渲染缓存据此判断是否重建
+    uint64_t getRevision() const { return revision.load(std::memory_order_acquire); }
+    
     int getSize() const { return MAP_SIZE; }
     
 private:
-    void generateObstacles();  // 生成障碍物
+    void generateObstacles(RngStream& rng);  // 生成障碍物
+    void bumpRevision();
+};
+
+// 流场：每个格子到目标（敌方存活基地）的最少移动步数
+// 8方向移动、每步代价为1，与士兵的移动规则一致；不可达或不可通行的格子为 UNREACHABLE
+struct FlowField {
+    static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+    std::vector<uint16_t> distance;  // [x * MAP_SIZE + y]
+    
+    FlowField() : distance(MAP_SIZE * MAP_SIZE, UNREACHABLE) {}
+    
+    uint16_t at(const Position& pos) const {
+        if (pos.x < 0 || pos.x >= MAP_SIZE || pos.y < 0 || pos.y >= MAP_SIZE) return UNREACHABLE;
+        return distance[pos.x * MAP_SIZE + pos.y];
+    }
+    void build(const GameMap& map, const std::vector<Position>& targets);  // 多源BFS
+};
+
+// 渲染快照中的一个存活士兵
+struct SoldierSnapshot {
+    Position position;
+    SoldierType type;
+    Team team;
+    int hp;
+    
+    int getMaxHp() const { return getSoldierStats(type).hp; }
+};
+
+// 渲染快照：士兵数据只由游戏线程修改且读取不加锁，渲染线程不能直接遍历士兵，
+// 而是读取游戏线程在回合之间从组件存储复制出的这份副本
+struct RenderSnapshot {
+    int turn = 0;
+    std::vector<SoldierSnapshot> soldiers;
 };
 
 // 队伍数据结构
@@ -143,6 +378,19 @@ private:
     std::vector<std::unique_ptr<Base>> basesTeamA;
     std::vector<std::unique_ptr<Base>> basesTeamB;
     mutable std::mutex soldiersMutex;
+    RenderSnapshot renderSnapshot;  // 由 soldiersMutex 保护
+    SoldierColumns soldierColumns;  // 与 soldiers 对齐的组件存储
+    OccupancyGrid occupancy;        // 存活士兵的占位网格
+    SpatialHash spatialIndex;       // 存活士兵的空间哈希（按队伍分桶）
+    InfluenceMap influence;         // 密度/威胁影响力图
+    
+    // 视野（回合开始时由 updateSharedVision 计算）
+    VisionBoard teamVision[2];               // 每个队伍所有存活士兵视野的并集
+    std::vector<VisionBoard> visionGroups;   // 每个共享视野组的视野并集
+    
+    // 寻路流场：flowFields[t] 是队伍t到敌方存活基地的距离场
+    FlowField flowFields[2];
+    uint32_t flowFieldBaseMask;  // 计算流场时的存活基地位掩码（变化时重算）
     std::atomic<bool> gameOver;
     std::atomic<Team> winner;
     int turnCount;
@@ -152,36 +400,84 @@ private:
     std::atomic<int> energyTeamB;
     mutable std::mutex energyMutex;
     
+    // 每局独立的随机数上下文（不使用全局状态，多局游戏可以在不同线程并行）
+    // 地图、AI、移动等用途各取一条独立的流，相同种子加相同动作总是得到同一局游戏
+    RngContext rng;
+    
 public:
     // 公开的队伍数据和基地访问
     TeamData teams[2];  // Team 0 和 Team 1
     std::vector<std::shared_ptr<Base>> bases;  // 所有基地的统一列表
-    std::vector<std::shared_ptr<Soldier>> soldiers;  // 所有士兵列表（公开以便AI访问）
+    SlotMap<std::shared_ptr<Soldier>> soldiers;  // 所有士兵（槽位映射，连续遍历，公开以便AI访问）
     
-    GameModel();
+    GameModel();                        // 随机种子
+    explicit GameModel(uint64_t seed);  // 指定随机种子（整局可复现）
     
     // Getters
     GameMap* getMap() const { return gameMap.get(); }
+    RngContext& getRng() { return rng; }  // 只在回合处理线程中使用
+    uint64_t getSeed() const { return rng.getSeed(); }
     const std::vector<std::unique_ptr<Base>>& getBasesTeamA() const { return basesTeamA; }
     const std::vector<std::unique_ptr<Base>>& getBasesTeamB() const { return basesTeamB; }
     std::vector<std::shared_ptr<Soldier>> getSoldiers() const;
+    std::shared_ptr<Soldier> getSoldier(SoldierId id) const;  // ID失效时返回nullptr
+    const SoldierColumns& getSoldierColumns() const { return soldierColumns; }
+    
+    // 占位查询 O(1)：格子上是否有（除 excludeId 外的）存活士兵
+    bool isOccupied(const Position& pos, SoldierId excludeId = INVALID_SOLDIER_ID) const;
+    SoldierId getSoldierIdAt(const Position& pos) const;  // 无存活士兵时返回 INVALID_SOLDIER_ID
+    
+    // 范围查询（返回组件存储中的下标）
+    const SpatialHash& getSpatialIndex() const { return spatialIndex; }
+    
+    // 视野查询
+    const VisionBoard& getTeamVision(Team team) const { return teamVision[static_cast<int>(team)]; }
+    const VisionBoard* getSharedVision(SoldierId id) const;  // 士兵所在共享视野组的视野，没有时返回nullptr
+    
+    // 影响力图（密度随士兵状态实时更新，威胁在每回合开始时更新）
+    const InfluenceMap& getInfluence() const { return influence; }
+    void updateInfluenceMaps();
+    
+    // 寻路流场（队伍team前往敌方基地）
+    const FlowField& getFlowField(Team team) const { return flowFields[static_cast<int>(team)]; }
     bool isGameOver() const { return gameOver.load(); }
     Team getWinner() const { return winner.load(); }
     int getTurnCount() const { return turnCount; }
     int getEnergy(Team team) const;
     
     // 行为
-    void addSoldier(std::shared_ptr<Soldier> soldier);
-    void removeSoldier(std::shared_ptr<Soldier> soldier);
+    SoldierId addSoldier(std::shared_ptr<Soldier> soldier);  // 返回分配的士兵ID
+    void removeSoldier(SoldierId id);  // O(1)
     void incrementTurn() { turnCount++; }
+    
+    // 渲染快照：修改士兵的线程在回合之间发布（开局、每回合结束、回合外的购买、回放载入），
+    // 渲染线程复制一份使用（复用 out 的容量）
+    void publishRenderSnapshot();
+    void copyRenderSnapshot(RenderSnapshot& out) const;
     void setGameOver(Team winningTeam);
     void addEnergy(Team team, int amount);
     bool spendEnergy(Team team, int amount);  // 返回是否成功消费
     
     void initialize();
     
+    // 快照（见 GameState.h）：保存基地、存活士兵（按组件存储顺序）、能量、回合数、胜负和随机数上下文
+    // saveState 在士兵数超过 GameState::MAX_SOLDIERS 时返回 false（出兵有同样的上限，只有直接 addSoldier 才会超出）
+    // loadState 复用已有的地图和基地对象，地形或存活基地变化时才重算流场
+    bool saveState(GameState& state) const;
+    void loadState(const GameState& state);
+    
     // 视野共享系统
-    void updateSharedVision();  // 更新所有士兵的共享视野
+    // 通信距离（COMMUNICATION_RANGE）内的队友连成一个共享视野组（可经由中间队友传递），组内共用一张视野位图
+    void updateSharedVision();
+    
+    // 有基地被摧毁时重算流场（基地未变化时直接返回）
+    void updateFlowFields(bool force = false);
+    
+private:
+    // Soldier 状态变化时同步组件存储
+    friend class Soldier;
+    void onSoldierMoved(SoldierId id, const Position& pos);
+    void onSoldierHpChanged(SoldierId id, int hp, bool alive);
 };
 
 #endif // MODEL_H
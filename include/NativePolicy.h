@@ -0,0 +1,55 @@
+#ifndef NATIVEPOLICY_H
+#define NATIVEPOLICY_H
+
+#include "GameTypes.h"
+#include "FeatureEncoder.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// 原生策略网络 - 在C++内直接运行 infer.py 中的 PolicyNetwork
+// 权重由 python/export_weights.py 导出（BatchNorm 已折叠进 Linear 层）
+// 网络结构：79 -> 768 -> 512 -> 256 -> 10（Mish 激活，10 = 2 action + 3 base + 5 unit）
+// 复制一个已加载的 NativePolicy 只复制缓冲区、共享权重：多个线程各用一个副本，权重只加载一次
+class NativePolicy {
+public:
+    static constexpr int FEATURE_DIM = FeatureEncoder::FEATURE_DIM;
+    static constexpr int ACTION_TYPE_COUNT = 2;
+    static constexpr int BASE_ID_COUNT = 3;
+    static constexpr int UNIT_TYPE_COUNT = 5;
+    static constexpr int OUTPUT_DIM = ACTION_TYPE_COUNT + BASE_ID_COUNT + UNIT_TYPE_COUNT;
+
+private:
+    struct Layer {
+        int inFeatures;
+        int outFeatures;
+        int stride;                  // 每行权重的实际长度（补齐到SIMD宽度）
+        bool mish;                   // 输出是否经过 Mish 激活
+        std::vector<float> weights;  // [outFeatures][stride]，行主序，补齐部分为0
+        std::vector<float> bias;
+    };
+
+    std::shared_ptr<const std::vector<Layer>> layers;  // 加载后只读，复制 NativePolicy 时共享
+    std::vector<float> bufferA;  // 前向传播的乒乓缓冲区（每个副本各自一份）
+    std::vector<float> bufferB;
+    bool loaded;
+
+    // 由特征前向传播并按能量调整后选出动作
+    Action decide(const float* features, int myEnergy, int myBaseCount);
+
+public:
+    NativePolicy();
+
+    // 加载导出的二进制权重文件
+    bool load(const std::string& path);
+    bool isLoaded() const { return loaded; }
+
+    // 前向传播：79维特征 -> 10个logits
+    void forward(const float* features, float* logits);
+
+    // 获取AI决策（决策规则与 infer.py 的 model_policy 一致）
+    Action getAction(const Observation& obs);
+};
+
+#endif // NATIVEPOLICY_H
@@ -0,0 +1,57 @@
+#ifndef OBSERVATION_H
+#define OBSERVATION_H
+
+#include "Constants.h"
+#include <string>
+
+using namespace GameConstants;
+
+// 基地观测
+struct BaseObservation {
+    int hp = 0;
+    int maxHp = 0;
+    int x = 0;
+    int y = 0;
+    int nearbyAllies = 0;              // 仅我方基地：3格内（曼哈顿）双方士兵数
+    int nearbyEnemies = 0;
+    int distanceToNearestMyBase = 0;   // 仅敌方基地：到我方最近基地的曼哈顿距离
+};
+
+// 某一队伍视角的局面观测（定长POD，可以直接拷贝/放进队列）
+// 字段与状态JSON一一对应，JSON只在日志和Python边界由 writeObservationJson 生成，特征由 FeatureEncoder 直接编码
+struct Observation {
+    static constexpr int MAX_BASES = 5;  // 每方最多记录的基地数（按HP降序）
+
+    int turn = 0;
+    int myTeam = 0;
+    int myEnergy = 0;
+    int enemyEnergy = 0;
+    int myTotalBaseHp = 0;
+    int enemyTotalBaseHp = 0;
+    int myBaseCount = 0;
+    int enemyBaseCount = 0;
+    int myHealDone = 0;
+    int enemyHealDone = 0;
+    int mySoldierCount = 0;
+    int enemySoldierCount = 0;
+    int myTypeCounts[SOLDIER_TYPE_COUNT] = {};     // 按 SoldierType 顺序
+    int enemyTypeCounts[SOLDIER_TYPE_COUNT] = {};
+    float myAvgX = 0.0f;
+    float myAvgY = 0.0f;
+    float enemyAvgX = 0.0f;
+    float enemyAvgY = 0.0f;
+    int myFrontCount = 0;
+    int enemyFrontCount = 0;
+    int myBaseEntries = 0;                         // myBases 中的有效条目数
+    int enemyBaseEntries = 0;
+    BaseObservation myBases[MAX_BASES];
+    BaseObservation enemyBases[MAX_BASES];
+    bool gameOver = false;
+    int winner = -1;
+};
+
+// 追加观测的JSON到 out（键按字母序、无空白，与 nlohmann::json::dump() 的输出逐字节一致）
+void writeObservationJson(const Observation& obs, std::string& out);
+std::string observationToJson(const Observation& obs);
+
+#endif // OBSERVATION_H
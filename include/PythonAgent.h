@@ -4,31 +4,42 @@
 #include <string>
 #include <memory>
 #include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
 
 // 简化的JSON类型
 using JsonString = std::string;
 
 // Python代理类 - 通过进程通信与Python脚本交互
+// 常驻模式：infer.py 以 --server 启动一次，模型只加载一次，
+// 之后通过 stdin/stdout 管道交换帧（4字节大端长度 + UTF-8 JSON）
 class PythonAgent {
 private:
-    FILE* pythonProcess;
-    FILE* pythonInput;
+    pid_t pythonPid;
+    int toPython;      // 写端：发送状态帧到Python的stdin
+    int fromPython;    // 读端：从Python的stdout读取动作帧
     std::string scriptPath;
     bool initialized;
-    
+
+    // 帧读写辅助
+    bool writeFrame(const std::string& payload);
+    bool readFrame(std::string& payload, int timeoutMs);
+    bool writeAll(const void* data, size_t size);
+    bool readAll(void* data, size_t size, int timeoutMs);
+
 public:
     PythonAgent();
     ~PythonAgent();
-    
-    // 初始化Python进程
+
+    // 初始化Python进程（启动常驻推理服务并等待模型加载完成）
     bool initialize(const std::string& scriptPath);
-    
+
     // 获取AI决策（发送状态JSON，接收动作JSON）
     JsonString getAction(const JsonString& stateJson);
-    
+
     // 关闭Python进程
     void shutdown();
-    
+
     bool isInitialized() const { return initialized; }
 };
 
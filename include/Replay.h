@@ -0,0 +1,138 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "Model.h"
+#include "GameTypes.h"
+#include "GameState.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+
+// 比赛录像：开局种子和地形 + 每回合的动作和士兵变化（增量、varint 压缩），每 K 回合一个完整关键帧
+// 地形直接保存（4KB），回放不依赖标准库随机分布的实现重新生成地图；一局通常只有几十KB
+//
+// 文件格式（varint 为 LEB128，zigzag 为有符号数的 zigzag 编码）：
+//   char[4]  magic = "DSRP"
+//   uint32   version = 2
+//   uint64   seed                 GameModel 的随机种子（只作记录，回放使用下面保存的地形）
+//   uint32   keyframe_interval
+//   uint8    team_type[2]         PlayerType
+//   uint8    base_pos[2][BASE_COUNT_PER_TEAM][2]
+//   uint8    terrain[MAP_SIZE * MAP_SIZE]  TerrainType，下标 x * MAP_SIZE + y（与 TerrainGrid 相同）
+//   之后每回合一条记录直到文件结束（第0条是开局局面，第i条是第i回合结束后的局面）：
+//     varint body_length
+//     uint8  flags                bit0 关键帧，bit1 游戏结束
+//     uint8  actions[2]           0 = 等待，否则 1 + base_id * SOLDIER_TYPE_COUNT + unit_type
+//     varint energy[2]
+//     关键帧：varint base_hp[2][BASE_COUNT_PER_TEAM]，varint n，n 个士兵
+//     增量帧：zigzag base_hp 变化[2][BASE_COUNT_PER_TEAM]，
+//             varint n，n 个 varint id差（死亡的士兵），
+//             varint n，n 个 {varint id差, uint8 mask(bit0 x, bit1 y, bit2 hp), 对应字段的 zigzag 变化}，
+//             varint n，n 个士兵（新出现的士兵）
+//     游戏结束时：uint8 winner
+//   士兵 = {varint id差, uint8 x, uint8 y, uint8 team << 4 | type, varint hp}
+//   士兵ID是录像内按出现顺序分配的编号，每个列表内按ID递增，id差相对于列表中的上一个ID（第一个相对于0）
+struct ReplaySoldier {
+    uint32_t id;
+    uint8_t x;
+    uint8_t y;
+    uint8_t team;
+    uint8_t type;
+    int32_t hp;
+};
+
+// 录像中的一个局面
+struct ReplayFrame {
+    int32_t energy[2] = {0, 0};
+    int32_t baseHp[2][BASE_COUNT_PER_TEAM] = {};
+    uint8_t actions[2] = {0, 0};
+    bool gameOver = false;
+    int winner = -1;
+    std::vector<ReplaySoldier> soldiers;  // 按ID递增
+};
+
+class ReplayRecorder {
+public:
+    static constexpr char MAGIC[4] = {'D', 'S', 'R', 'P'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr int DEFAULT_KEYFRAME_INTERVAL = 50;
+
+    ReplayRecorder(const std::string& path, PlayerType team0, PlayerType team1,
+                   int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    bool isOpen() const { return out.is_open(); }
+    int frameCount() const { return frames; }
+
+    // 记录当前局面（第一次调用时写文件头）；actions 是本回合双方最后一次成功执行的动作
+    void record(const GameModel& model, const Action& team0Action, const Action& team1Action);
+    void flush() { out.flush(); }
+
+    // 动作 <-> 录像中的一个字节
+    static uint8_t encodeAction(const Action& action);
+    static Action decodeAction(uint8_t code);
+
+private:
+    std::ofstream out;
+    PlayerType teamTypes[2];
+    int keyframeInterval;
+    int frames;
+
+    std::unordered_map<SoldierId, uint32_t> replayIds;  // 士兵ID -> 录像内编号
+    uint32_t nextReplayId;
+    ReplayFrame previous;
+    ReplayFrame current;
+    std::string buffer;  // 当前记录（跨回合复用）
+
+    void writeHeader(const GameModel& model);
+    void capture(const GameModel& model, ReplayFrame& frame);
+};
+
+class ReplayPlayer {
+public:
+    // 读入整个录像并建立记录索引；失败时返回 false 并设置 getError()
+    bool load(const std::string& path);
+    const std::string& getError() const { return error; }
+
+    uint64_t getSeed() const { return seed; }
+    PlayerType getTeamType(int team) const { return teamTypes[team]; }
+    int frameCount() const { return static_cast<int>(records.size()); }  // 开局 + 回合数
+
+    // 定位到第 index 条记录：向前相邻时只解码一条，否则从不晚于它的最近关键帧开始解码
+    // 记录损坏、或局面放不进 GameState（士兵超过 MAX_SOLDIERS、HP 超出 int16）时返回 false 并设置 getError()
+    bool seek(int index);
+    int position() const { return currentIndex; }
+    const ReplayFrame& frame() const { return current; }
+
+    // 当前局面 -> 快照（地形指向录像中保存的地形，快照不能比播放器活得久）；只能在 seek 成功之后调用
+    void toState(GameState& state) const;
+
+private:
+    struct Record {
+        size_t offset;
+        size_t length;
+        bool keyframe;
+    };
+
+    std::string data;
+    std::string error;
+    uint64_t seed = 0;
+    PlayerType teamTypes[2] = {PlayerType::AI_RULE_BASED, PlayerType::AI_RULE_BASED};
+    uint8_t basePositions[2][BASE_COUNT_PER_TEAM][2] = {};
+    TerrainGrid terrain{};
+    std::vector<Record> records;
+    std::vector<int> keyframes;  // 关键帧的记录下标（递增）
+
+    int currentIndex = -1;
+    ReplayFrame current;
+    std::vector<ReplaySoldier> scratch;
+
+    bool apply(const Record& record);
+    bool fitsState(int index);  // 当前局面能否放进 GameState，不能时设置 error
+};
+
+#endif // REPLAY_H
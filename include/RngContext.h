@@ -0,0 +1,82 @@
+#ifndef RNG_CONTEXT_H
+#define RNG_CONTEXT_H
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// 随机数流的用途：每个用途一条独立的流，一处多取或少取随机数不会改变其他用途的序列
+enum class RngStreamId : int {
+    MAP = 0,       // 地图生成
+    AI_TEAM0,      // Team 0 规则AI（购买队列、出兵基地、移动扰动）
+    AI_TEAM1,      // Team 1 规则AI
+    MOVEMENT,      // 控制器中移动候选的打乱和出兵位置的选择
+    COMBAT,        // 战斗（目前的战斗结算没有随机性，预留）
+    SEARCH,        // 蒙特卡洛树搜索每回合的种子
+    COUNT
+};
+
+constexpr int RNG_STREAM_COUNT = static_cast<int>(RngStreamId::COUNT);
+
+// 基于计数器的随机数流：第 n 个输出只由 (key, n) 决定（SplitMix64 的混合函数），
+// 状态只有两个整数，可以平凡复制，保存到快照后能精确恢复
+// 满足 UniformRandomBitGenerator，可直接用于 std::uniform_int_distribution 和 std::shuffle
+class RngStream {
+public:
+    using result_type = uint64_t;
+
+    RngStream() = default;
+    explicit RngStream(uint64_t key, uint64_t counter = 0) : key(key), counter(counter) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() { return mix(key + ++counter * GOLDEN_GAMMA); }
+
+    uint64_t getKey() const { return key; }
+    uint64_t getCounter() const { return counter; }  // 已经取出的随机数个数
+
+    // SplitMix64 的输出混合函数（双射）
+    static constexpr uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+    uint64_t key = 0;
+    uint64_t counter = 0;
+};
+
+// 一局游戏的随机数上下文：由一个种子派生出各用途的独立流（GameModel 持有，控制器和AI从中取流）
+// 可平凡复制，GameState 整体保存它，载入快照后的随机序列与原局面完全相同
+class RngContext {
+public:
+    explicit RngContext(uint64_t seed = 0) : seed(seed) {
+        for (int i = 0; i < RNG_STREAM_COUNT; i++) {
+            streams[i] = RngStream(RngStream::mix(seed ^ RngStream::mix(static_cast<uint64_t>(i) + 1)));
+        }
+    }
+
+    uint64_t getSeed() const { return seed; }
+    RngStream& stream(RngStreamId id) { return streams[static_cast<int>(id)]; }
+
+    // 由基础种子和序号派生第 index 局的种子（多局并行训练、批量环境）
+    static uint64_t deriveSeed(uint64_t baseSeed, uint64_t index) {
+        return RngStream::mix(RngStream::mix(baseSeed) + index);
+    }
+
+    // 没有指定 --seed 时使用的随机种子
+    static uint64_t randomSeed() {
+        std::random_device device;
+        return (static_cast<uint64_t>(device()) << 32) | device();
+    }
+
+private:
+    uint64_t seed;
+    RngStream streams[RNG_STREAM_COUNT];
+};
+
+#endif // RNG_CONTEXT_H
@@ -0,0 +1,144 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// 槽位映射（slot map）
+// - 插入/删除 O(1)：删除时把末尾元素换到空位（swap-remove）
+// - 值连续存储，遍历只经过存活元素
+// - 句柄 = 槽位索引 + 代数，元素删除后槽位代数加一，旧句柄自动失效，不会指向新元素
+template <typename T>
+class SlotMap {
+public:
+    // 打包句柄：低16位为槽位索引，高15位为代数（保证非负，-1表示无效）
+    using Handle = int32_t;
+    static constexpr Handle INVALID_HANDLE = -1;
+    static constexpr uint32_t INDEX_BITS = 16;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = 0x7FFF;
+    static constexpr size_t MAX_SLOTS = size_t(1) << INDEX_BITS;
+
+private:
+    struct Slot {
+        uint32_t denseIndex;   // 元素在连续数组中的位置
+        uint32_t generation;   // 当前代数
+    };
+
+    std::vector<T> values;          // 连续存储的存活元素
+    std::vector<Handle> handles;    // handles[i] 是 values[i] 的句柄
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    static Handle makeHandle(uint32_t slotIndex, uint32_t generation) {
+        return static_cast<Handle>(((generation & GENERATION_MASK) << INDEX_BITS) | slotIndex);
+    }
+
+    // 句柄有效时返回槽位，否则返回 nullptr
+    const Slot* findSlot(Handle handle) const {
+        if (handle < 0) return nullptr;
+        uint32_t slotIndex = static_cast<uint32_t>(handle) & INDEX_MASK;
+        uint32_t generation = static_cast<uint32_t>(handle) >> INDEX_BITS;
+        if (slotIndex >= slots.size()) return nullptr;
+        const Slot& slot = slots[slotIndex];
+        if (slot.generation != generation || slot.denseIndex >= values.size()) return nullptr;
+        return &slot;
+    }
+
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    // 插入元素，返回句柄（槽位用尽时返回 INVALID_HANDLE）
+    Handle insert(T value) {
+        uint32_t slotIndex;
+        if (!freeSlots.empty()) {
+            slotIndex = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            if (slots.size() >= MAX_SLOTS) return INVALID_HANDLE;
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.push_back({0, 0});
+        }
+
+        Slot& slot = slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(values.size());
+        Handle handle = makeHandle(slotIndex, slot.generation);
+        values.push_back(std::move(value));
+        handles.push_back(handle);
+        return handle;
+    }
+
+    // 删除元素，返回是否删除成功
+    bool erase(Handle handle) {
+        const Slot* found = findSlot(handle);
+        if (!found) return false;
+
+        uint32_t slotIndex = static_cast<uint32_t>(handle) & INDEX_MASK;
+        uint32_t denseIndex = found->denseIndex;
+        uint32_t lastIndex = static_cast<uint32_t>(values.size() - 1);
+
+        // 末尾元素换到被删除的位置
+        if (denseIndex != lastIndex) {
+            values[denseIndex] = std::move(values[lastIndex]);
+            handles[denseIndex] = handles[lastIndex];
+            slots[static_cast<uint32_t>(handles[denseIndex]) & INDEX_MASK].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        handles.pop_back();
+
+        // 槽位代数加一，使旧句柄失效
+        Slot& slot = slots[slotIndex];
+        slot.generation = (slot.generation + 1) & GENERATION_MASK;
+        slot.denseIndex = UINT32_MAX;
+        freeSlots.push_back(slotIndex);
+        return true;
+    }
+
+    bool contains(Handle handle) const { return findSlot(handle) != nullptr; }
+
+    // 按句柄查找，句柄失效时返回 nullptr
+    T* get(Handle handle) {
+        const Slot* slot = findSlot(handle);
+        return slot ? &values[slot->denseIndex] : nullptr;
+    }
+    const T* get(Handle handle) const {
+        const Slot* slot = findSlot(handle);
+        return slot ? &values[slot->denseIndex] : nullptr;
+    }
+
+    // 连续数组中的位置（句柄失效时返回 -1）
+    int denseIndexOf(Handle handle) const {
+        const Slot* slot = findSlot(handle);
+        return slot ? static_cast<int>(slot->denseIndex) : -1;
+    }
+
+    Handle handleAt(size_t denseIndex) const { return handles[denseIndex]; }
+
+    void clear() {
+        // 清空后所有旧句柄都要失效，因此保留槽位并递增代数
+        for (Handle handle : handles) {
+            uint32_t slotIndex = static_cast<uint32_t>(handle) & INDEX_MASK;
+            slots[slotIndex].generation = (slots[slotIndex].generation + 1) & GENERATION_MASK;
+            slots[slotIndex].denseIndex = UINT32_MAX;
+            freeSlots.push_back(slotIndex);
+        }
+        values.clear();
+        handles.clear();
+    }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    // 连续遍历存活元素
+    T& operator[](size_t denseIndex) { return values[denseIndex]; }
+    const T& operator[](size_t denseIndex) const { return values[denseIndex]; }
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+};
+
+#endif // SLOTMAP_H
@@ -0,0 +1,78 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// 单生产者单消费者无锁环形队列
+// - 容量取2的幂，head/tail 单调递增，下标取模
+// - tryPush/tryPop 不阻塞；push/pop 在队列满/空时用 std::atomic::wait 休眠，不忙等
+// - 只能有一个线程调用 push 系列、一个线程调用 pop 系列
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity) capacity <<= 1;
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // 成功时 value 被移走；失败（队列满）时 value 保持不变
+    bool tryPush(T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead >= slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead >= slots.size()) return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    void push(T value) {
+        while (!tryPush(value)) {
+            // 队列满：等待消费者推进 head
+            head.wait(cachedHead, std::memory_order_acquire);
+        }
+    }
+
+    bool tryPop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    void pop(T& out) {
+        while (!tryPop(out)) {
+            // 队列空：等待生产者推进 tail
+            tail.wait(cachedTail, std::memory_order_acquire);
+        }
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // 生产者和消费者各自写的变量放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head{0};  // 消费者写
+    alignas(64) size_t cachedTail = 0;        // 消费者缓存的 tail
+    alignas(64) std::atomic<size_t> tail{0};  // 生产者写
+    alignas(64) size_t cachedHead = 0;        // 生产者缓存的 head
+};
+
+#endif // SPSCQUEUE_H
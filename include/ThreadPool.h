@@ -0,0 +1,87 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// 固定大小的线程池
+// - 任务按提交顺序由空闲线程取出执行，任务之间不保证完成顺序
+// - wait() 阻塞到队列为空且没有正在执行的任务
+// - 析构时执行完剩余任务后回收线程
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount) {
+        if (threadCount == 0) threadCount = 1;
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskAvailable.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        taskAvailable.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        allDone.wait(lock, [this]() { return tasks.empty() && activeTasks == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    size_t activeTasks = 0;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;  // stopping 且没有剩余任务
+                task = std::move(tasks.front());
+                tasks.pop();
+                activeTasks++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                activeTasks--;
+                if (tasks.empty() && activeTasks == 0) allDone.notify_all();
+            }
+        }
+    }
+};
+
+#endif // THREADPOOL_H
@@ -3,51 +3,119 @@
 
 #include "GameTypes.h"
 #include "Model.h"
+#include "DatasetWriter.h"
+#include "Observation.h"
+#include "SpscQueue.h"
 #include <string>
 #include <vector>
 #include <fstream>
 #include <chrono>
 #include <memory>
+#include <thread>
+#include <atomic>
+
+// 日志落盘（fsync）策略
+enum class LogSyncPolicy {
+    NEVER,       // 只写入页缓存，由操作系统决定何时落盘
+    EVERY_GAME,  // 每局写入后 fsync
+    INTERVAL     // 每N局 fsync 一次（进程内所有对局共同计数）
+};
+
+// 日志记录：游戏线程生成后移交给写入线程（观测按值拷贝，事件列表整体移动）
+struct LogRecord {
+    enum class Kind : uint8_t { BEGIN, TURN, END, STOP };
+    Kind kind = Kind::TURN;
+    int turn = 0;                 // TURN: 回合号；END: 总回合数
+    int winner = -1;              // END
+    float reward[2] = {0.0f, 0.0f};
+    double durationSeconds = 0.0; // END
+    GameMode mode = GameMode::TRAINING;                // BEGIN
+    PlayerType team0Type = PlayerType::AI_RULE_BASED;  // BEGIN
+    PlayerType team1Type = PlayerType::AI_RULE_BASED;  // BEGIN
+    Action team0Action;           // TURN
+    Action team1Action;           // TURN
+    Observation state;            // TURN: Team 1 的决策前观测
+    std::vector<GameEvent> events;
+};
 
 // 训练日志记录器
+// - JSON Lines 日志：每局一行 {"metadata", "episodes", "summary"}，以追加方式写入
+// - 二进制数据集：特征/动作/奖励按列写入分片文件（格式见 DatasetWriter.h），供训练时 memmap
+// 游戏线程只计算奖励并把记录放入SPSC队列；序列化、特征编码和文件写入都在写入线程完成
 class TrainingLogger {
 private:
-    std::string logData;  // 存储JSON格式的日志
+    // 游戏线程使用
     std::vector<GameEvent> currentTurnEvents;
     int totalTurns;
     std::chrono::steady_clock::time_point startTime;
-    GameMode mode;
-    PlayerType team0Type;
-    PlayerType team1Type;
     bool gameStarted;
+    uint64_t pushedRecords;
     
     // 为了支持更复杂的奖励计算，持有Model指针
     std::shared_ptr<GameModel> model;
     
+    // 写入线程使用
+    std::string logData;      // 本局的JSON行
+    DatasetGame datasetGame;  // 本局的二进制数据集行
+    std::string logFilePath;
+    
+    SpscQueue<LogRecord> queue;
+    std::atomic<uint64_t> processedRecords;
+    std::atomic<bool> verbose;  // 每局写入后是否打印提示（写入线程读取）
+    std::thread writerThread;
+    
 public:
+    static constexpr const char* DEFAULT_LOG_FILE = "game_log.jsonl";
+    static constexpr const char* DEFAULT_DATASET_DIR = "dataset";
+    
+    static constexpr size_t QUEUE_CAPACITY = 1024;
+    
     TrainingLogger();
+    ~TrainingLogger();  // 写完队列中的所有记录后结束写入线程
     
     // 开始游戏记录
     void startGame(GameMode mode, PlayerType team0, PlayerType team1);
     
-    // 记录一个回合
-    void recordTurn(int turn, const std::string& stateJson,
-                    const std::string& team0Action, const std::string& team1Action);
+    // 记录一个回合（JSON序列化和特征编码在写入线程完成）
+    void recordTurn(int turn, const Observation& state, const Action& team0Action, const Action& team1Action);
     
     // 添加事件到当前回合
     void addEvent(const GameEvent& event);
     
-    // 结束游戏，保存日志
+    // 结束游戏，保存日志（异步，flush 后保证已写入）
     void endGame(int winner);
     
-    // 计算奖励
-    float calculateReward(int team, const std::vector<GameEvent>& events);
+    // 等待写入线程处理完已提交的全部记录
+    void flush();
+    
+    // 计算奖励（静态版本供 VecEnv 使用，model 为空时只计算事件奖励）
+    float calculateReward(int team, const std::vector<GameEvent>& events) { return calculateReward(model.get(), team, events); }
+    static float calculateReward(const GameModel* model, int team, const std::vector<GameEvent>& events);
     
     void setModel(std::shared_ptr<GameModel> m) { model = m; }
+    void setLogFile(const std::string& path) { flush(); logFilePath = path; }
+    void setVerbose(bool value) { verbose.store(value, std::memory_order_relaxed); }
+    
+    // 设置落盘策略（进程全局，默认每100局 fsync 一次）
+    static void setSyncPolicy(LogSyncPolicy policy, int intervalGames = 1);
+    
+    // 设置输出格式（进程全局，默认两种都输出）
+    static void setOutputFormats(bool jsonl, bool binary, const std::string& datasetDir = DEFAULT_DATASET_DIR);
+    
+    // 写出二进制数据集中未满的分片（进程退出前调用）
+    static void flushDataset();
     
 private:
+    void submit(LogRecord&& record);
+    
+    // 写入线程
+    void writerLoop();
+    void writeBegin(const LogRecord& record);
+    void writeTurn(const LogRecord& record);
+    void writeEnd(const LogRecord& record);
+    
     std::string getCurrentTimestamp();
-    void saveToFile(const std::string& filename);
+    void appendToFile(const std::string& filename);
 };
 
 #endif // TRAININGLOGGER_H
@@ -0,0 +1,53 @@
+#ifndef TRAININGRUNNER_H
+#define TRAININGRUNNER_H
+
+#include "GameTypes.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 多局并行训练配置
+struct TrainingConfig {
+    PlayerType team0 = PlayerType::AI_RULE_BASED;
+    PlayerType team1 = PlayerType::AI_RULE_BASED;
+    int games = 1;
+    int threads = 1;
+    uint64_t baseSeed = 0;  // 第i局的随机种子由 (baseSeed, i) 派生，相同配置可复现
+};
+
+// 单局结果
+struct GameResult {
+    bool finished = false;  // 是否完整结束（出错或被中断时为false）
+    int winner = -1;        // 0 = Team A, 1 = Team B
+    int turns = 0;
+    double seconds = 0.0;
+};
+
+// 汇总结果
+struct TrainingSummary {
+    int gamesPlayed = 0;
+    int wins[2] = {0, 0};
+    long long totalTurns = 0;
+    int minTurns = 0;
+    int maxTurns = 0;
+    double elapsedSeconds = 0.0;
+};
+
+// 多局并行训练：每局拥有独立的 GameModel/GameController（各自的随机数生成器），
+// 在线程池上运行，结束后汇总胜负和回合数
+class TrainingRunner {
+public:
+    explicit TrainingRunner(const TrainingConfig& config);
+
+    // 运行全部对局；interrupted 置位后不再开始新的对局（进行中的对局会正常结束并保存日志）
+    TrainingSummary run(const std::atomic<bool>& interrupted);
+
+    static void printSummary(const TrainingSummary& summary);
+
+private:
+    TrainingConfig config;
+
+    GameResult runGame(int index);
+};
+
+#endif // TRAININGRUNNER_H
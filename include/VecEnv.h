@@ -0,0 +1,72 @@
+#ifndef VECENV_H
+#define VECENV_H
+
+#include "Model.h"
+#include "Controller.h"
+#include "FeatureEncoder.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+// 批量环境配置
+struct VecEnvConfig {
+    int numEnvs = 1;
+    int threads = 1;
+    PlayerType opponent = PlayerType::AI_RULE_BASED;  // Team 0 的对手（规则AI或原生策略）
+    std::string policyPath;                           // 对手为原生策略时的权重文件
+};
+
+// 批量强化学习环境：N局游戏同时推进，智能体控制 Team 1（与训练日志的视角一致）
+// - 所有输入输出都是连续缓冲区：obs[N][OBS_DIM]、actions[N][ACTION_FIELDS]、rewards[N]、dones[N]
+// - step 时各环境在线程池中并行推进一回合；结束的环境自动开始下一局，
+//   此时返回的 obs 是新一局的初始观测，reward 和 done 属于刚结束的一局
+// - 动作格式与数据集相同 (action_type, base_id, unit_type)，智能体每回合最多出一个兵
+class VecEnv {
+public:
+    static constexpr int OBS_DIM = FeatureEncoder::FEATURE_DIM;
+    static constexpr int ACTION_FIELDS = 3;
+    static constexpr int AGENT_TEAM = 1;
+
+    // 对手为原生策略时只加载一次权重，所有环境共享；无法加载时抛出 std::runtime_error
+    // （否则对手永远不出兵，智能体会对着一个不动的敌人训练）
+    explicit VecEnv(const VecEnvConfig& config);
+
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    int size() const { return static_cast<int>(envs.size()); }
+
+    // 用 seeds[N] 重新开始所有环境，写出初始观测
+    void reset(const uint32_t* seeds, float* obs);
+
+    // 执行 actions[N][3] 并推进一回合
+    void step(const int8_t* actions, float* obs, float* rewards, uint8_t* dones);
+
+    // 动作字段 -> Action（无法识别时为等待）
+    static Action decodeAction(const int8_t* fields);
+
+private:
+    struct Env {
+        std::shared_ptr<GameModel> model;
+        std::unique_ptr<GameController> controller;
+        uint32_t seed = 0;      // reset 时传入的种子
+        uint32_t episode = 0;   // 自 reset 以来的局数，与 seed 一起派生每局的种子
+        Observation observation;
+    };
+
+    VecEnvConfig config;
+    NativePolicy opponentPolicy;  // 只读共享，各环境的控制器持有共享权重的副本
+    std::vector<Env> envs;
+    ThreadPool pool;
+
+    void startEpisode(Env& env, float* obs);
+    void stepEnv(Env& env, const Action& action, float* obs, float* reward, uint8_t* done);
+
+    // 把 [0, N) 切成线程数个连续区间并行执行
+    template <typename Fn>
+    void parallelFor(Fn fn);
+};
+
+#endif // VECENV_H
@@ -0,0 +1,46 @@
+#ifndef VECENVCAPI_H
+#define VECENVCAPI_H
+
+// libds_vecenv 的 C 接口（供 python/vec_env.py 通过 ctypes + numpy 调用）
+// 缓冲区布局见 VecEnv.h；所有缓冲区由调用方分配，step/reset 期间不得被其他线程访问
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define DS_VECENV_API __declspec(dllexport)
+#else
+#define DS_VECENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DsVecEnv DsVecEnv;
+
+// 对手类型
+#define DS_VECENV_OPPONENT_RULE 0    // 规则AI
+#define DS_VECENV_OPPONENT_NATIVE 1  // 原生策略网络（权重文件由 policy_path 指定）
+
+// policy_path：对手为原生策略时的权重文件（export_weights.py 导出，相对路径相对于调用进程的工作目录），
+// 所有环境共享一份；规则AI对手时可以为 NULL
+// 创建失败（包括权重无法加载）时返回 NULL
+DS_VECENV_API DsVecEnv* ds_vecenv_create(int32_t num_envs, int32_t threads, int32_t opponent, const char* policy_path);
+DS_VECENV_API void ds_vecenv_destroy(DsVecEnv* env);
+
+DS_VECENV_API int32_t ds_vecenv_size(const DsVecEnv* env);
+DS_VECENV_API int32_t ds_vecenv_obs_dim(void);
+DS_VECENV_API uint32_t ds_vecenv_feature_version(void);
+
+// seeds[N] -> obs[N][obs_dim]
+DS_VECENV_API void ds_vecenv_reset(DsVecEnv* env, const uint32_t* seeds, float* obs);
+
+// actions[N][3] (action_type, base_id, unit_type) -> obs[N][obs_dim], rewards[N], dones[N]
+DS_VECENV_API void ds_vecenv_step(DsVecEnv* env, const int8_t* actions, float* obs, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VECENVCAPI_H
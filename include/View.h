@@ -3,6 +3,7 @@
 
 #include "Model.h"
 #include "Controller.h"
+#include "Replay.h"
 #include <SFML/Graphics.hpp>
 #include <memory>
 #include <string>
@@ -16,18 +17,34 @@ private:
     sf::Font font;
     bool fontLoaded;
     
-    // 图片资源
-    sf::Texture texBaseBlue, texBaseRed;
-    sf::Texture texArcherBlue, texArcherRed;
-    sf::Texture texSaberBlue, texSaberRed;
-    sf::Texture texRiderBlue, texRiderRed;
-    sf::Texture texCasterBlue, texCasterRed;
-    sf::Texture texDoctorBlue, texDoctorRed;
+    // 贴图集：启动时把 image/*.png 缩小后拼成一张纹理
+    // 图块依次为 兵种×队伍（10个）、两队基地、一块纯白（HP条等纯色矩形）
+    static constexpr int ATLAS_TILE_COUNT = SOLDIER_TYPE_COUNT * 2 + 3;
+    sf::Texture atlas;
+    bool tileLoaded[ATLAS_TILE_COUNT];  // 图片加载失败的图块用队伍颜色的纯色方块代替
     bool texturesLoaded;
     
+    // 每帧开始时从模型复制的渲染快照（士兵和回合数只从这里读取，不与游戏线程竞争）
+    RenderSnapshot snapshot;
+    
+    // 基地、HP条和士兵每帧写入同一个顶点数组（跨帧复用），用贴图集一次绘制
+    sf::VertexArray unitVertices;
+    
+    // 地形缓存：整张地形（含格线）烘焙成一个顶点数组，一次绘制；地形版本变化时才重建
+    sf::VertexArray terrainVertices;
+    uint64_t terrainRevision;
+    
     // UI状态
     int selectedBaseIndex;  // 当前选中的基地索引（-1表示未选中）
     
+    // 录像回放：不运行控制器，按播放速度把录像的局面逐回合载入模型
+    std::unique_ptr<ReplayPlayer> replay;
+    GameState replayState;
+    sf::Clock replayClock;
+    double replaySpeed;     // 每秒回合数
+    double replayProgress;  // 距离下一回合已经累计的回合数
+    bool replayPaused;
+    
 public:
     GameView(std::shared_ptr<GameModel> model, std::shared_ptr<GameController> controller);
     
@@ -35,16 +52,26 @@ public:
     void handleEvents();
     void render();
     
+    // 进入回放模式（controller 可以为空，此时不能购买）
+    // 空格暂停/继续，左右方向键逐回合，上下方向键调整速度，Home/End 跳到开头/结尾，点击进度条跳转
+    void playReplay(std::unique_ptr<ReplayPlayer> player);
+    
 private:
     // 渲染组件
     void renderMap();
-    void renderTerrain(int x, int y, TerrainType type);
-    void renderSoldiers();
-    void renderSoldier(const Soldier& soldier);
-    void renderBases();
-    void renderBase(const Base* base);
+    void rebuildTerrain(const GameMap& map);
+    void renderUnits();
+    void appendSoldier(const SoldierSnapshot& soldier);
+    void appendBase(const Base& base);
+    void appendQuad(const sf::Vector2f& position, const sf::Vector2f& size, int tile, sf::Color color);
     void renderUI();
     void renderPurchasePanel();  // 渲染购买面板
+    void renderReplayBar();      // 回放进度条和状态
+    
+    // 回放
+    void updateReplay();
+    void showReplayFrame(int index);
+    void handleReplayKey(sf::Keyboard::Key key);
     
     // 事件处理
     void handleMouseClick(int mouseX, int mouseY);
@@ -56,7 +83,7 @@ private:
     // 颜色选择
     sf::Color getTerrainColor(TerrainType type);
     sf::Color getTeamColor(Team team);
-    sf::Color getSoldierColor(const Soldier& soldier);
+    sf::Color getSoldierColor(const SoldierSnapshot& soldier);
     
     // 辅助函数
     sf::Vector2f gridToScreen(const Position& pos);
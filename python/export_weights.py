@@ -0,0 +1,163 @@
+"""
+导出脚本 - 把 policy_model.pth 转成 C++ 原生推理使用的扁平二进制权重文件
+
+BatchNorm 在导出时折叠进相邻的 Linear 层（推理时 BN 只是逐通道仿射变换）：
+  - input_norm 折叠进第一个 Linear 的输入侧
+  - Mish 之后的 BN 折叠进下一个 Linear 的输入侧
+  - 三个输出头拼接成一个 256 -> 10 的 Linear（2 action + 3 base + 5 unit）
+
+文件格式（小端）：
+  char[4]  magic = "DSPN"
+  uint32   version = 1
+  uint32   layer_count
+  每层：uint32 in_features, uint32 out_features, uint32 activation(0=无, 1=Mish)
+  每层：float32 weight[out][in]（行主序），float32 bias[out]
+
+用法：python3 export_weights.py [--check] [policy_model.pth] [policy_model.bin]
+  --check  导出后用同一批输入对比 infer.py 的 PolicyNetwork 和导出的网络，logits 超出容差时返回非0
+           （优先通过 libds_features 调用 C++ 的 NativePolicy，找不到共享库时用 numpy 按同样的格式计算）
+"""
+
+import struct
+import sys
+from pathlib import Path
+
+import numpy as np
+import torch
+
+SCRIPT_DIR = Path(__file__).parent
+MAGIC = b"DSPN"
+VERSION = 1
+ACT_NONE = 0
+ACT_MISH = 1
+
+# --check 的输入行数和容差（|native - torch| <= ATOL + RTOL * |torch|）
+CHECK_ROWS = 256
+CHECK_ATOL = 1e-3
+CHECK_RTOL = 1e-3
+
+
+def bn_affine(state, prefix, eps=1e-5):
+    """把 BN 的推理形式写成 y = scale * x + shift"""
+    gamma = state[prefix + ".weight"].double().numpy()
+    beta = state[prefix + ".bias"].double().numpy()
+    mean = state[prefix + ".running_mean"].double().numpy()
+    var = state[prefix + ".running_var"].double().numpy()
+    scale = gamma / np.sqrt(var + eps)
+    shift = beta - mean * scale
+    return scale, shift
+
+
+def linear(state, prefix):
+    return (state[prefix + ".weight"].double().numpy(),
+            state[prefix + ".bias"].double().numpy())
+
+
+def fold_input_affine(weight, bias, scale, shift):
+    """Linear(scale * x + shift) = (W * scale) x + (W @ shift + b)"""
+    return weight * scale[np.newaxis, :], bias + weight @ shift
+
+
+def build_layers(state):
+    w1, b1 = fold_input_affine(*linear(state, "shared.0"), *bn_affine(state, "input_norm"))
+    w2, b2 = fold_input_affine(*linear(state, "shared.4"), *bn_affine(state, "shared.2"))
+    w3, b3 = fold_input_affine(*linear(state, "shared.8"), *bn_affine(state, "shared.6"))
+
+    heads = [linear(state, name) for name in ("action_type_head", "base_id_head", "unit_type_head")]
+    w4 = np.concatenate([w for w, _ in heads], axis=0)
+    b4 = np.concatenate([b for _, b in heads], axis=0)
+
+    return [(w1, b1, ACT_MISH), (w2, b2, ACT_MISH), (w3, b3, ACT_MISH), (w4, b4, ACT_NONE)]
+
+
+def export(model_path, out_path):
+    state = torch.load(model_path, map_location="cpu")
+    layers = build_layers(state)
+
+    with open(out_path, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<II", VERSION, len(layers)))
+        for weight, _, act in layers:
+            out_features, in_features = weight.shape
+            f.write(struct.pack("<III", in_features, out_features, act))
+        for weight, bias, _ in layers:
+            f.write(np.ascontiguousarray(weight, dtype="<f4").tobytes())
+            f.write(np.ascontiguousarray(bias, dtype="<f4").tobytes())
+
+    shapes = " -> ".join([str(layers[0][0].shape[1])] + [str(w.shape[0]) for w, _, _ in layers])
+    print(f"Exported {model_path} to {out_path} ({shapes})")
+
+
+def numpy_forward(weights_path, inputs):
+    """按导出的文件格式用 numpy 做前向传播（没有 libds_features 时的对照实现）"""
+    data = Path(weights_path).read_bytes()
+    _, layer_count = struct.unpack_from("<II", data, 4)
+    offset = 12
+    shapes = []
+    for _ in range(layer_count):
+        shapes.append(struct.unpack_from("<III", data, offset))
+        offset += 12
+
+    x = inputs.astype(np.float32)
+    for in_features, out_features, act in shapes:
+        weight = np.frombuffer(data, dtype="<f4", count=in_features * out_features, offset=offset)
+        offset += 4 * in_features * out_features
+        bias = np.frombuffer(data, dtype="<f4", count=out_features, offset=offset)
+        offset += 4 * out_features
+        x = x @ weight.reshape(out_features, in_features).T + bias
+        if act == ACT_MISH:
+            x = x * np.tanh(np.logaddexp(0.0, x))
+    return x
+
+
+def native_forward(weights_path, inputs):
+    """通过 libds_features 调用 C++ 的 NativePolicy；共享库不可用时返回 None"""
+    import ctypes
+    import features
+    lib = features._lib
+    if lib is None or not hasattr(lib, "ds_policy_forward"):
+        return None
+    lib.ds_policy_forward.argtypes = [ctypes.c_char_p, ctypes.c_void_p, ctypes.c_int64, ctypes.c_void_p]
+    lib.ds_policy_forward.restype = ctypes.c_int64
+
+    inputs = np.ascontiguousarray(inputs, dtype=np.float32)
+    logits = np.zeros((inputs.shape[0], 10), dtype=np.float32)
+    if lib.ds_policy_forward(str(weights_path).encode(), inputs.ctypes.data, inputs.shape[0], logits.ctypes.data) < 0:
+        raise RuntimeError(f"native policy failed to load {weights_path}")
+    return logits
+
+
+def check(model_path, out_path):
+    """同一批输入分别经过 infer.py 的 PolicyNetwork（eval 模式）和导出的网络，比较 logits"""
+    from infer import PolicyNetwork
+
+    model = PolicyNetwork()
+    model.load_state_dict(torch.load(model_path, map_location="cpu"))
+    model.eval()
+
+    # 特征大多归一化到 [0, 1]，取稍宽的范围覆盖超出的取值
+    rng = np.random.default_rng(0)
+    inputs = rng.uniform(-0.5, 1.5, size=(CHECK_ROWS, 79)).astype(np.float32)
+    with torch.no_grad():
+        expected = torch.cat(model(torch.from_numpy(inputs)), dim=1).numpy()
+
+    actual = native_forward(out_path, inputs)
+    backend = "NativePolicy"
+    if actual is None:
+        actual = numpy_forward(out_path, inputs)
+        backend = "numpy (libds_features not found)"
+
+    error = np.abs(actual - expected)
+    passed = bool(np.all(error <= CHECK_ATOL + CHECK_RTOL * np.abs(expected)))
+    print(f"Parity check against infer.py via {backend}: max abs error {error.max():.2e} "
+          f"over {CHECK_ROWS} inputs: {'OK' if passed else 'FAILED'}")
+    return passed
+
+
+if __name__ == "__main__":
+    args = [arg for arg in sys.argv[1:] if arg != "--check"]
+    model_path = Path(args[0]) if len(args) > 0 else SCRIPT_DIR / "policy_model.pth"
+    out_path = Path(args[1]) if len(args) > 1 else model_path.with_suffix(".bin")
+    export(model_path, out_path)
+    if "--check" in sys.argv[1:] and not check(model_path, out_path):
+        sys.exit(1)
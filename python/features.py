@@ -0,0 +1,183 @@
+"""
+状态特征编码（79维）- infer.py 和 train.py 共用的唯一入口
+
+优先通过 ctypes 加载 C++ 的 libds_features（include/FeatureEncoder.h，与游戏内原生推理、
+二进制数据集使用同一份编码）；找不到共享库时退回到下面的纯 Python 实现（布局相同，只是慢）。
+
+共享库的查找顺序：环境变量 DS_FEATURES_LIB，然后 python/ 目录和项目根目录下常见的构建目录。
+"""
+
+import ctypes
+import json
+import os
+import sys
+from pathlib import Path
+
+import numpy as np
+
+FEATURE_VERSION = 1
+FEATURE_DIM = 79
+
+SCRIPT_DIR = Path(__file__).resolve().parent
+LIBRARY_DIRS = (
+    SCRIPT_DIR,
+    SCRIPT_DIR.parent,
+    SCRIPT_DIR.parent / "cmake-build-release",
+    SCRIPT_DIR.parent / "cmake-build-debug",
+    SCRIPT_DIR.parent / "build",
+)
+
+
+def library_candidates(name, env_var):
+    """共享库的候选路径：环境变量指定的路径优先，然后是常见构建目录（name 不带前缀和扩展名）"""
+    candidates = []
+    if os.environ.get(env_var):
+        candidates.append(Path(os.environ[env_var]))
+    file_names = (f"lib{name}.dylib", f"lib{name}.so", f"{name}.dll")
+    candidates += [d / file_name for d in LIBRARY_DIRS for file_name in file_names]
+    return [path for path in candidates if path.is_file()]
+
+
+def _load_library():
+    for path in library_candidates("ds_features", "DS_FEATURES_LIB"):
+        try:
+            lib = ctypes.CDLL(str(path))
+        except OSError as e:
+            print(f"Warning: failed to load {path}: {e}", file=sys.stderr)
+            continue
+
+        lib.ds_feature_version.restype = ctypes.c_uint32
+        lib.ds_feature_dim.restype = ctypes.c_int32
+        lib.ds_encode_state.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_void_p]
+        lib.ds_encode_state.restype = ctypes.c_int32
+        lib.ds_encode_game.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_int64]
+        lib.ds_encode_game.restype = ctypes.c_int64
+
+        version, dim = lib.ds_feature_version(), lib.ds_feature_dim()
+        if version != FEATURE_VERSION or dim != FEATURE_DIM:
+            print(f"Warning: {path} encodes feature version {version} ({dim} dims), "
+                  f"expected {FEATURE_VERSION} ({FEATURE_DIM} dims); using Python encoder", file=sys.stderr)
+            continue
+        return lib
+    return None
+
+
+_lib = _load_library()
+
+
+def native_available():
+    return _lib is not None
+
+
+def _as_bytes(state):
+    if isinstance(state, bytes):
+        return state
+    if isinstance(state, str):
+        return state.encode("utf-8")
+    return json.dumps(state, separators=(",", ":")).encode("utf-8")
+
+
+def _encode_state_py(state, out):
+    """纯 Python 实现，布局与 FeatureEncoder.cpp 中的 encodeState 一致"""
+    features = []
+
+    # 1. 能量 (2)
+    features.append(state.get("my_energy", 0) / 1000.0)
+    features.append(state.get("enemy_energy", 0) / 1000.0)
+
+    # 2. 基地总HP (2)
+    features.append(state.get("my_total_base_hp", 0) / 50000.0)
+    features.append(state.get("enemy_total_base_hp", 0) / 50000.0)
+
+    # 3. 士兵总数 (2)
+    features.append(state.get("my_soldier_count", 0) / 100.0)
+    features.append(state.get("enemy_soldier_count", 0) / 100.0)
+
+    # 4-5. 双方各兵种数量 (5 + 5)
+    for group in ("my_soldier_types", "enemy_soldier_types"):
+        types = state.get(group, {})
+        for key in ("archer_count", "infantry_count", "cavalry_count", "caster_count", "doctor_count"):
+            features.append(types.get(key, 0) / 20.0)
+
+    # 6-7. 双方基地信息 (3 * 7 + 3 * 7)
+    for group in ("my_bases", "enemy_bases"):
+        bases = state.get(group, [])
+        for i in range(3):
+            if i >= len(bases):
+                features.extend([0.0] * 7)
+                continue
+            base = bases[i]
+            nearby_enemies = base.get("nearby_enemies", 0)
+            features.append(base.get("hp", 0) / 15000.0)
+            features.append(base.get("position_x", base.get("x", 32)) / 64.0)  # 支持两种字段名
+            features.append(base.get("position_y", base.get("y", 32)) / 64.0)
+            features.append(base.get("nearby_allies", 0) / 20.0)
+            features.append(nearby_enemies / 20.0)
+            if "is_under_attack" in base:
+                features.append(float(base["is_under_attack"]))
+            else:
+                features.append(1.0 if group == "my_bases" and nearby_enemies > 0 else 0.0)
+            distance = base.get("distance_to_nearest_my_base", base.get("distance_to_nearest_enemy_base", 64))
+            features.append(distance / 64.0)
+
+    # 8. 战场分布 (6) - 检查字段兼容性
+    dist = state.get("soldier_distribution", {})
+    if "my_front_soldier_count" in dist:
+        keys = ("my_front_soldier_count", "my_mid_soldier_count", "my_back_soldier_count",
+                "enemy_front_soldier_count", "enemy_mid_soldier_count", "enemy_back_soldier_count")
+    else:
+        keys = ("my_front_soldier_count", "my_avg_x", "my_avg_y",
+                "enemy_front_soldier_count", "enemy_avg_x", "enemy_avg_y")
+    for key in keys:
+        features.append(dist.get(key, 0) / 20.0)
+
+    # 9. 治疗量 (2)
+    features.append(state.get("my_heal_done", 0) / 100.0)
+    features.append(state.get("enemy_heal_done", 0) / 100.0)
+
+    # 10. 游戏状态 (1)
+    features.append(1.0 if state.get("game_over", False) is True else 0.0)
+
+    out[:] = 0.0
+    out[:len(features)] = features
+
+
+def encode_state(state):
+    """编码一个状态（dict 或 JSON 字符串），返回 float32[79]"""
+    out = np.zeros(FEATURE_DIM, dtype=np.float32)
+    if _lib is not None:
+        data = _as_bytes(state)
+        _lib.ds_encode_state(data, len(data), out.ctypes.data)
+    else:
+        _encode_state_py(json.loads(state) if isinstance(state, (str, bytes)) else state, out)
+    return out
+
+
+def encode_game(game):
+    """
+    编码一局中所有回合的状态，返回 float32[回合数][79]
+    game 可以是 game_log.jsonl 的一行（字符串，C++端一次解析完成），也可以是已解析的 dict
+    """
+    if _lib is not None and isinstance(game, (str, bytes)):
+        data = _as_bytes(game)
+        capacity = 1024
+        while True:
+            out = np.zeros((capacity, FEATURE_DIM), dtype=np.float32)
+            rows = _lib.ds_encode_game(data, len(data), out.ctypes.data, capacity)
+            if rows < 0:
+                raise ValueError("cannot parse game record")
+            if rows <= capacity:
+                return out[:rows]
+            capacity = rows
+
+    if isinstance(game, (str, bytes)):
+        game = json.loads(game)
+    episodes = game.get("episodes", [])
+    out = np.zeros((len(episodes), FEATURE_DIM), dtype=np.float32)
+    for row, episode in enumerate(episodes):
+        if _lib is not None:
+            data = _as_bytes(episode.get("state", {}))
+            _lib.ds_encode_state(data, len(data), out[row].ctypes.data)
+        else:
+            _encode_state_py(episode.get("state", {}), out[row])
+    return out
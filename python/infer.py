@@ -1,13 +1,24 @@
 """
 推理脚本 - 用于游戏运行时的AI决策
 读取游戏状态JSON，使用训练好的模型进行推理，返回动作JSON
+
+两种运行方式：
+  python3 infer.py state.json   单次推理（读取文件，输出一行动作JSON）
+  python3 infer.py --server     常驻服务（模型只加载一次，stdin/stdout 上交换帧）
+
+常驻服务的帧格式：4字节大端长度 + UTF-8 JSON。
+启动后先发送一个就绪帧，之后每收到一个状态帧回复一个动作帧，stdin 关闭时退出。
 """
 
 import sys
 import json
+import struct
 import numpy as np
 import os
 
+# 特征编码与 C++ 端共用（libds_features，见 features.py）
+from features import encode_state as parse_state_to_features
+
 # 尝试导入PyTorch，如果没有安装则使用随机策略
 try:
     import torch
@@ -25,6 +36,14 @@ HIDDEN_SIZE_3 = 256
 DROPOUT_RATE_1 = 0.2
 DROPOUT_RATE_2 = 0.1
 
+# 调试输出（常驻服务默认关闭，可通过 DS_PJ_DEBUG=1 打开）
+DEBUG = True
+
+
+def debug(msg):
+    if DEBUG:
+        print(msg, file=sys.stderr)
+
 
 class PolicyNetwork(nn.Module):
     """策略网络 - 多头输出（与train.py完全一致）"""
@@ -63,101 +82,6 @@ class PolicyNetwork(nn.Module):
         return action_type_logits, base_id_logits, unit_type_logits
 
 
-def parse_state_to_features(state_json):
-    """从 state 字典提取 79 维特征向量（与 train.py 完全一致）"""
-    features = []
-
-    # 1. 能量 (2)
-    features.append(state_json.get("my_energy", 0) / 1000.0)
-    features.append(state_json.get("enemy_energy", 0) / 1000.0)
-
-    # 2. 基地总HP (2)
-    features.append(state_json.get("my_total_base_hp", 0) / 50000.0)
-    features.append(state_json.get("enemy_total_base_hp", 0) / 50000.0)
-
-    # 3. 士兵总数 (2)
-    features.append(state_json.get("my_soldier_count", 0) / 100.0)
-    features.append(state_json.get("enemy_soldier_count", 0) / 100.0)
-
-    # 4. 我方各兵种数量 (5维：只有5种兵)
-    my_types = state_json.get("my_soldier_types", {})
-    features.append(my_types.get("archer_count", 0) / 20.0)
-    features.append(my_types.get("infantry_count", 0) / 20.0)
-    features.append(my_types.get("cavalry_count", 0) / 20.0)
-    features.append(my_types.get("caster_count", 0) / 20.0)
-    features.append(my_types.get("doctor_count", 0) / 20.0)
-
-    # 5. 敌方各兵种数量 (5维)
-    enemy_types = state_json.get("enemy_soldier_types", {})
-    features.append(enemy_types.get("archer_count", 0) / 20.0)
-    features.append(enemy_types.get("infantry_count", 0) / 20.0)
-    features.append(enemy_types.get("cavalry_count", 0) / 20.0)
-    features.append(enemy_types.get("caster_count", 0) / 20.0)
-    features.append(enemy_types.get("doctor_count", 0) / 20.0)
-
-    # 6. 我方基地信息 (3 * 7 = 21)
-    my_bases = state_json.get("my_bases", [])
-    for i in range(3):
-        if i < len(my_bases):
-            base = my_bases[i]
-            features.append(base.get("hp", 0) / 15000.0)
-            features.append(base.get("position_x", base.get("x", 32)) / 64.0)  # 支持两种字段名
-            features.append(base.get("position_y", base.get("y", 32)) / 64.0)
-            features.append(base.get("nearby_allies", 0) / 20.0)
-            features.append(base.get("nearby_enemies", 0) / 20.0)
-            features.append(base.get("is_under_attack", base.get("nearby_enemies", 0) > 0))
-            distance = base.get("distance_to_nearest_my_base", base.get("distance_to_nearest_enemy_base", 64))
-            features.append(distance / 64.0)
-        else:
-            features.extend([0.0] * 7)
-
-    # 7. 敌方基地信息 (3 * 7 = 21)
-    enemy_bases = state_json.get("enemy_bases", [])
-    for i in range(3):
-        if i < len(enemy_bases):
-            base = enemy_bases[i]
-            features.append(base.get("hp", 0) / 15000.0)
-            features.append(base.get("position_x", base.get("x", 32)) / 64.0)
-            features.append(base.get("position_y", base.get("y", 32)) / 64.0)
-            features.append(base.get("nearby_allies", 0) / 20.0)
-            features.append(base.get("nearby_enemies", 0) / 20.0)
-            features.append(base.get("is_under_attack", 0))
-            distance = base.get("distance_to_nearest_my_base", base.get("distance_to_nearest_enemy_base", 64))
-            features.append(distance / 64.0)
-        else:
-            features.extend([0.0] * 7)
-
-    # 8. 战场分布 (6) - 检查字段兼容性
-    dist = state_json.get("soldier_distribution", {})
-    if "my_front_soldier_count" in dist:
-        features.append(dist.get("my_front_soldier_count", 0) / 20.0)
-        features.append(dist.get("my_mid_soldier_count", 0) / 20.0)
-        features.append(dist.get("my_back_soldier_count", 0) / 20.0)
-        features.append(dist.get("enemy_front_soldier_count", 0) / 20.0)
-        features.append(dist.get("enemy_mid_soldier_count", 0) / 20.0)
-        features.append(dist.get("enemy_back_soldier_count", 0) / 20.0)
-    else:
-        features.append(dist.get("my_front_soldier_count", 0) / 20.0)
-        features.append(dist.get("my_avg_x", 0) / 20.0)
-        features.append(dist.get("my_avg_y", 0) / 20.0)
-        features.append(dist.get("enemy_front_soldier_count", 0) / 20.0)
-        features.append(dist.get("enemy_avg_x", 0) / 20.0)
-        features.append(dist.get("enemy_avg_y", 0) / 20.0)
-
-    # 9. 治疗量 (2)
-    features.append(state_json.get("my_heal_done", 0) / 100.0)
-    features.append(state_json.get("enemy_heal_done", 0) / 100.0)
-
-    # 10. 游戏状态 (1)
-    features.append(1.0 if state_json.get("game_over", False) else 0.0)
-
-    # 补充到 79 维
-    while len(features) < 79:
-        features.append(0.0)
-
-    return np.array(features[:79], dtype=np.float32)  # 确保正好 79 维
-
-
 def random_policy(state_json):
     """随机策略（PyTorch未安装或模型未训练时使用）"""
     my_base_count = state_json.get("my_base_count", 1)
@@ -200,20 +124,20 @@ def model_policy(state_json, model, device):
             # 直接在原始tensor上修改
             action_type_logits = action_type_logits.clone()  # 创建副本避免修改原始输出
             action_type_logits[0, 0] -= bias  # 降低"等待"的logits
-            print(f"[DEBUG] Energy={my_energy}, adjusted wait logit by {-bias:.2f}", file=sys.stderr)
+            debug(f"[DEBUG] Energy={my_energy}, adjusted wait logit by {-bias:.2f}")
 
         # 如果能量超过300，大幅降低wait倾向（强制出兵）
         if my_energy > 300:
             action_type_logits[0, 0] -= 100.0  # 大幅降低wait分数（总共最多-150）
-            print(f"[DEBUG] High energy = {my_energy}, strongly encouraging spawn", file=sys.stderr)
+            debug(f"[DEBUG] High energy = {my_energy}, strongly encouraging spawn")
 
         # 调试输出 调整后 的logits 和 softmax 概率
-        print(f"[DEBUG] adjusted action_logits: {action_type_logits[0].tolist()}", file=sys.stderr)
+        debug(f"[DEBUG] adjusted action_logits: {action_type_logits[0].tolist()}")
 
         action_type_probs = torch.softmax(action_type_logits, dim=-1)
-        print(f"[DEBUG] action_probs: {action_type_probs[0].tolist()}", file=sys.stderr)
-        print(f"[DEBUG] base_logits: {base_id_logits[0].tolist()}", file=sys.stderr)
-        print(f"[DEBUG] unit_logits: {unit_type_logits[0].tolist()}", file=sys.stderr)
+        debug(f"[DEBUG] action_probs: {action_type_probs[0].tolist()}")
+        debug(f"[DEBUG] base_logits: {base_id_logits[0].tolist()}")
+        debug(f"[DEBUG] unit_logits: {unit_type_logits[0].tolist()}")
 
         # 使用 argmax 获取最可能的动作
         action_type = torch.argmax(action_type_logits, dim=-1).item()
@@ -222,7 +146,7 @@ def model_policy(state_json, model, device):
 
     # 如果选择wait，返回wait动作
     if action_type == 0:
-        print(f"[DEBUG] Model chose WAIT.", file=sys.stderr)
+        debug(f"[DEBUG] Model chose WAIT.")
         return {
             "action_type": 0,
             "base_id": -1,
@@ -236,9 +160,9 @@ def model_policy(state_json, model, device):
 
     if base_id >= my_base_count:
         base_id = 0  # 降级到第一个基地
-        print(f"[DEBUG] Corrected base_id to 0 (out of range).", file=sys.stderr)
+        debug(f"[DEBUG] Corrected base_id to 0 (out of range).")
 
-    print(f"[DEBUG] Model chose SPAWN: base={base_id}, unit={unit_type}.", file=sys.stderr)
+    debug(f"[DEBUG] Model chose SPAWN: base={base_id}, unit={unit_type}.")
     return {
         "action_type": 1,
         "base_id": base_id,
@@ -246,8 +170,8 @@ def model_policy(state_json, model, device):
     }
 
 
-def main():
-    # 加载模型（如果存在）
+def load_model():
+    """加载模型（如果存在），返回 (model, device)，失败时 model 为 None"""
     model = None
     device = torch.device('cpu')  # 默认设备
 
@@ -273,7 +197,65 @@ def main():
             print(f"Model file not found: {model_path}, using random policy", file=sys.stderr)
         except Exception as e:
             print(f"Error loading model: {e}, using random policy", file=sys.stderr)
-    
+
+    return model, device
+
+
+def decide(state_json, model, device):
+    if model is not None:
+        return model_policy(state_json, model, device)
+    return random_policy(state_json)
+
+
+def read_frame(stream):
+    """读取一帧，stdin 关闭时返回 None"""
+    header = stream.read(4)
+    if len(header) < 4:
+        return None
+    (size,) = struct.unpack(">I", header)
+    payload = stream.read(size)
+    if len(payload) < size:
+        return None
+    return payload
+
+
+def write_frame(stream, obj):
+    payload = json.dumps(obj).encode("utf-8")
+    stream.write(struct.pack(">I", len(payload)))
+    stream.write(payload)
+    stream.flush()
+
+
+def serve(model, device):
+    """常驻推理服务：循环读取状态帧并回复动作帧"""
+    stdin = sys.stdin.buffer
+    stdout = sys.stdout.buffer
+
+    write_frame(stdout, {"status": "ready", "model_loaded": model is not None})
+
+    while True:
+        payload = read_frame(stdin)
+        if payload is None:
+            break
+        try:
+            action = decide(json.loads(payload), model, device)
+        except Exception as e:
+            print(f"Inference error: {e}", file=sys.stderr)
+            action = {"action_type": 0, "base_id": -1, "unit_type": -1}
+        write_frame(stdout, action)
+
+
+def main():
+    global DEBUG
+
+    if "--server" in sys.argv[1:]:
+        DEBUG = os.environ.get("DS_PJ_DEBUG") == "1"
+        model, device = load_model()
+        serve(model, device)
+        return
+
+    model, device = load_model()
+
     # 从stdin读取状态JSON，或从命令行参数读取文件
     if len(sys.argv) > 1:
         # 从文件读取
@@ -287,11 +269,8 @@ def main():
         state_json = json.loads(line)
     
     # 推理
-    if model is not None:
-        action = model_policy(state_json, model, device)
-    else:
-        action = random_policy(state_json)
-    
+    action = decide(state_json, model, device)
+
     # 输出动作JSON
     print(json.dumps(action))
     sys.stdout.flush()
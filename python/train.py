@@ -40,15 +40,25 @@ SAMPLING_POWER = 2.0  # 采样权重指数，越大越倾向于高奖励样本
 import os
 import time
 import sys
+import json
+import struct
 from pathlib import Path
 import torch
 import torch.nn as nn
 import torch.optim as optim
 import numpy as np
 
+from features import FEATURE_DIM, FEATURE_VERSION, encode_game
+
 SCRIPT_DIR = Path(__file__).parent
 MODEL_PATH = SCRIPT_DIR / "policy_model.pth"
 
+# 二进制数据集分片格式（与 DatasetWriter.h 保持一致）
+DATASET_MAGIC = b"DSDS"
+DATASET_VERSION = 1
+DATASET_HEADER_SIZE = 64
+GAME_INDEX_DTYPE = np.dtype([('row_start', '<u8'), ('row_count', '<u4'), ('winner', '<i4')])
+
 class PolicyNetwork(nn.Module):
     """
     策略网络 - 包含输入归一化层 (Input Normalization)
@@ -122,24 +132,8 @@ def compute_discounted_rewards(episodes, winner, gamma=GAMMA):
     return discounted_rewards
 
 
-def sample_by_rewards(states, action_types, base_ids, unit_types, rewards, power=SAMPLING_POWER):
-    """
-    根据折扣累积奖励进行重采样
-    奖励越高的样本被采样的次数越多
-    
-    Args:
-        states, action_types, base_ids, unit_types: 原始数据
-        rewards: 折扣累积奖励列表
-        power: 采样权重指数，越大越倾向于高奖励样本
-    
-    Returns:
-        重采样后的数据
-    """
-    if len(rewards) == 0:
-        return states, action_types, base_ids, unit_types, rewards
-    
-    # 将奖励转为非负权重 (平移+缩放)
-    rewards_array = np.array(rewards)
+def reward_sampling_indices(rewards_array, power=SAMPLING_POWER):
+    """根据折扣累积奖励计算重采样下标（奖励越高被采样的次数越多，总数扩充50%）"""
     min_reward = rewards_array.min()
     
     # 平移到非负区间
@@ -152,16 +146,40 @@ def sample_by_rewards(states, action_types, base_ids, unit_types, rewards, power
     weights = weights / weights.sum()
     
     # 计算采样次数（基于权重比例）
-    num_samples = len(states)
+    num_samples = len(rewards_array)
     target_samples = int(num_samples * 1.5)  # 扩充50%样本
     
+    print(f"   Reward range: [{rewards_array.min():.3f}, {rewards_array.max():.3f}]")
+    print(f"   Weight range: [{weights.min():.6f}, {weights.max():.6f}]")
+    
     # 根据权重重采样索引
-    sampled_indices = np.random.choice(
+    return np.random.choice(
         num_samples,
         size=target_samples,
         replace=True,
         p=weights
     )
+
+
+def sample_by_rewards(states, action_types, base_ids, unit_types, rewards, power=SAMPLING_POWER):
+    """
+    根据折扣累积奖励进行重采样
+    奖励越高的样本被采样的次数越多
+    
+    Args:
+        states, action_types, base_ids, unit_types: 原始数据
+        rewards: 折扣累积奖励列表
+        power: 采样权重指数，越大越倾向于高奖励样本
+    
+    Returns:
+        重采样后的数据
+    """
+    if len(rewards) == 0:
+        return states, action_types, base_ids, unit_types, rewards
+    
+    num_samples = len(states)
+    sampled_indices = reward_sampling_indices(np.asarray(rewards), power)
+    target_samples = len(sampled_indices)
     
     # 重采样数据
     sampled_states = [states[i] for i in sampled_indices]
@@ -173,17 +191,135 @@ def sample_by_rewards(states, action_types, base_ids, unit_types, rewards, power
     print(f"   Sampling stats:")
     print(f"   Original samples: {num_samples}")
     print(f"   Resampled: {target_samples}")
-    print(f"   Reward range: [{rewards_array.min():.3f}, {rewards_array.max():.3f}]")
-    print(f"   Weight range: [{weights.min():.6f}, {weights.max():.6f}]")
     
     return sampled_states, sampled_action_types, sampled_base_ids, sampled_unit_types, sampled_rewards
 
 
+def iter_games(log_path):
+    """
+    逐局读取训练日志（生成器），不把整个文件载入内存，产出 (game, line)
+    - game_log.jsonl：每行一局（C++端追加写入）；最后一行不完整（写入中被中断）时跳过
+      line 为原始文本，特征可以交给 C++ 编码器一次解析完成
+    - game_log.json：旧格式 {"games": [...]}，只能整体解析，line 为 None
+    """
+    with open(log_path, 'r') as f:
+        first_line = f.readline()
+        f.seek(0)
+        try:
+            first = json.loads(first_line) if first_line.strip() else None
+        except json.JSONDecodeError:
+            first = None
+
+        if isinstance(first, dict) and 'episodes' in first:
+            for line_no, line in enumerate(f, 1):
+                if not line.strip():
+                    continue
+                try:
+                    game = json.loads(line)
+                except json.JSONDecodeError:
+                    print(f" Skipping malformed record at line {line_no}")
+                    continue
+                yield game, line
+            return
+
+        data = json.load(f)
+        if 'games' in data:
+            for game in data['games']:
+                yield game, None
+        else:
+            # 单局格式：没有games结构，假设是胜利局（向后兼容）
+            data.setdefault('summary', {}).setdefault('winner', 1)
+            yield data, None
+
+
+def open_dataset_shard(path):
+    """以 memmap 方式打开一个数据集分片（不读取数据本身）"""
+    with open(path, 'rb') as f:
+        header = f.read(DATASET_HEADER_SIZE)
+    if len(header) < DATASET_HEADER_SIZE or header[:4] != DATASET_MAGIC:
+        raise ValueError(f"{path} is not a dataset shard")
+    (version, feature_dim, game_count, row_count,
+     features_offset, actions_offset, rewards_offset, games_offset,
+     feature_version, _) = struct.unpack_from('<IIIQQQQQII', header, 4)
+    if version != DATASET_VERSION:
+        raise ValueError(f"{path}: unsupported dataset version {version}")
+    # feature_version 为 0 的分片早于该字段，编码与 version 1 相同
+    if (feature_version or 1) != FEATURE_VERSION or feature_dim != FEATURE_DIM:
+        raise ValueError(f"{path}: features are version {feature_version or 1} ({feature_dim} dims), "
+                         f"expected version {FEATURE_VERSION} ({FEATURE_DIM} dims)")
+
+    def column(dtype, offset, shape):
+        return np.memmap(path, dtype=dtype, mode='r', offset=offset, shape=shape)
+
+    return {
+        'features': column('<f4', features_offset, (row_count, feature_dim)),
+        'actions': column('<i1', actions_offset, (row_count, 6)),  # team0 (type, base, unit), team1 (type, base, unit)
+        'rewards': column('<f4', rewards_offset, (row_count, 2)),
+        'games': column(GAME_INDEX_DTYPE, games_offset, (game_count,)),
+    }
+
+
+def load_binary_dataset(dataset_dir):
+    """
+    从二进制分片加载训练数据：特征已在C++端编码，这里只按下标取行
+    只有重采样选中的行会被读入内存，数据集可以大于内存
+    """
+    shard_paths = sorted(Path(dataset_dir).glob('*.dsds'))
+    print(f" Loading {len(shard_paths)} dataset shards from {dataset_dir}...")
+
+    shards = []
+    rows_per_shard = []
+    rewards = []
+    skipped_games = 0
+    kept_games = 0
+    for path in shard_paths:
+        shard = open_dataset_shard(path)
+        rows = []
+        for row_start, row_count, winner in shard['games']:
+            if FILTER_WINNING_ONLY and winner != 1:
+                skipped_games += 1
+                continue
+            kept_games += 1
+            # 折扣累积奖励：最后一回合为终局奖励，往前逐回合乘以 gamma
+            final_reward = REWARD_WIN if winner == 1 else REWARD_LOSS
+            rewards.append(final_reward * GAMMA ** np.arange(row_count - 1, -1, -1, dtype=np.float64))
+            rows.append(np.arange(row_start, row_start + row_count, dtype=np.int64))
+        shards.append(shard)
+        rows_per_shard.append(np.concatenate(rows) if rows else np.empty(0, dtype=np.int64))
+
+    print(f" Filtered games: Kept {kept_games}, Skipped {skipped_games} (Winning only: {FILTER_WINNING_ONLY})")
+    num_samples = sum(len(rows) for rows in rows_per_shard)
+    if num_samples == 0:
+        print(" No samples found in dataset")
+        return None
+
+    # 基于折扣累积奖励进行重采样（全局下标 -> (分片, 行)）
+    sampled = np.sort(reward_sampling_indices(np.concatenate(rewards), SAMPLING_POWER))
+    boundaries = np.cumsum([0] + [len(rows) for rows in rows_per_shard])
+
+    features, actions = [], []
+    for i, shard in enumerate(shards):
+        lo, hi = np.searchsorted(sampled, [boundaries[i], boundaries[i + 1]])
+        selected = rows_per_shard[i][sampled[lo:hi] - boundaries[i]]
+        features.append(np.asarray(shard['features'][selected], dtype=np.float32))
+        actions.append(np.asarray(shard['actions'][selected, 3:6], dtype=np.int64))  # my_team = team1
+    features = np.concatenate(features)
+    actions = np.concatenate(actions)
+
+    print(f" Processed {len(features)} samples from {num_samples} rows (after resampling).")
+    return torch.from_numpy(features), \
+           torch.from_numpy(actions[:, 0].copy()), \
+           torch.from_numpy(actions[:, 1].copy()), \
+           torch.from_numpy(actions[:, 2].copy())
+
+
 def load_or_process_data(log_file, device):
-    # 解析JSON文件
+    # 流式解析日志：逐局读取并提取特征，内存只与样本数有关
     log_path = Path(log_file)
     if not log_path.exists():
         log_path = SCRIPT_DIR.parent / log_file
+    if not log_path.exists() and log_path.suffix == '.jsonl':
+        log_path = log_path.with_suffix('.json')  # 兼容旧格式日志
 
     print(f" Parsing {log_path}...")
     states = []
@@ -197,141 +333,38 @@ def load_or_process_data(log_file, device):
         return None
 
     try:
-        import json
-        with open(log_path, 'r') as f:
-            data = json.load(f)
+        skipped_games = 0
+        kept_games = 0
+        total_episodes = 0
+        for game, line in iter_games(log_path):
+            winner = game.get('summary', {}).get('winner', -1)
 
-        episodes = []
-        if 'games' in data:
-            skipped_games = 0
-            kept_games = 0
-            for game in data['games']:
-                winner = game.get('summary', {}).get('winner', -1)
-                
-                if FILTER_WINNING_ONLY:
-                    # 假设我们只学习 my_team (team1) 的胜利数据
-                    if winner != 1: 
-                        skipped_games += 1
-                        continue
-                
-                kept_games += 1
-                
-                # 计算这局游戏中每个turn的折扣累积奖励
-                game_episodes = game['episodes']
-                game_rewards = compute_discounted_rewards(game_episodes, winner, GAMMA)
-                
-                # 将这局游戏的episodes和对应的奖励添加到总列表
-                episodes.extend(game_episodes)
-                rewards.extend(game_rewards)
-            
-            print(f" Filtered games: Kept {kept_games}, Skipped {skipped_games} (Winning only: {FILTER_WINNING_ONLY})")
-        else:
-            episodes = data.get('episodes', [])
-            # 如果没有games结构，假设全部是胜利局（向后兼容）
-            rewards = compute_discounted_rewards(episodes, winner=1, gamma=GAMMA)
-
-        print(f"️  Found {len(episodes)} total episodes across {len(data.get('games', []))} games")
-
-        for idx, episode in enumerate(episodes):
-            # 提取我方状态（假设my_team=1）
-            state_json = episode['state']
-
-            # 提取状态特征（79维）
-            features = []
-
-            # 1. 能量 (2)
-            features.append(state_json.get("my_energy", 0) / 1000.0)
-            features.append(state_json.get("enemy_energy", 0) / 1000.0)
-
-            # 2. 基地总HP (2)
-            features.append(state_json.get("my_total_base_hp", 0) / 50000.0)
-            features.append(state_json.get("enemy_total_base_hp", 0) / 50000.0)
-
-            # 3. 士兵总数 (2)
-            features.append(state_json.get("my_soldier_count", 0) / 100.0)
-            features.append(state_json.get("enemy_soldier_count", 0) / 100.0)
-
-            # 4. 我方各兵种数量 (5维：只有5种兵)
-            my_types = state_json.get("my_soldier_types", {})
-            features.append(my_types.get("archer_count", 0) / 20.0)
-            features.append(my_types.get("infantry_count", 0) / 20.0)
-            features.append(my_types.get("cavalry_count", 0) / 20.0)
-            features.append(my_types.get("caster_count", 0) / 20.0)
-            features.append(my_types.get("doctor_count", 0) / 20.0)
-
-            # 5. 敌方各兵种数量 (5维)
-            enemy_types = state_json.get("enemy_soldier_types", {})
-            features.append(enemy_types.get("archer_count", 0) / 20.0)
-            features.append(enemy_types.get("infantry_count", 0) / 20.0)
-            features.append(enemy_types.get("cavalry_count", 0) / 20.0)
-            features.append(enemy_types.get("caster_count", 0) / 20.0)
-            features.append(enemy_types.get("doctor_count", 0) / 20.0)
-
-            # 6. 我方基地信息 (3 * 7 = 21)
-            my_bases = state_json.get("my_bases", [])
-            for i in range(3):
-                if i < len(my_bases):
-                    base = my_bases[i]
-                    features.append(base.get("hp", 0) / 15000.0)
-                    features.append(base.get("position_x", base.get("x", 32)) / 64.0)
-                    features.append(base.get("position_y", base.get("y", 32)) / 64.0)
-                    features.append(base.get("nearby_allies", 0) / 20.0)
-                    features.append(base.get("nearby_enemies", 0) / 20.0)
-                    features.append(base.get("is_under_attack", base.get("nearby_enemies", 0) > 0))
-                    distance = base.get("distance_to_nearest_my_base", base.get("distance_to_nearest_enemy_base", 64))
-                    features.append(distance / 64.0)
-                else:
-                    features.extend([0.0] * 7)
-
-            # 7. 敌方基地信息 (3 * 7 = 21)
-            enemy_bases = state_json.get("enemy_bases", [])
-            for i in range(3):
-                if i < len(enemy_bases):
-                    base = enemy_bases[i]
-                    features.append(base.get("hp", 0) / 15000.0)
-                    features.append(base.get("position_x", base.get("x", 32)) / 64.0)
-                    features.append(base.get("position_y", base.get("y", 32)) / 64.0)
-                    features.append(base.get("nearby_allies", 0) / 20.0)
-                    features.append(base.get("nearby_enemies", 0) / 20.0)
-                    features.append(base.get("is_under_attack", 0))
-                    distance = base.get("distance_to_nearest_my_base", base.get("distance_to_nearest_enemy_base", 64))
-                    features.append(distance / 64.0)
-                else:
-                    features.extend([0.0] * 7)
-
-            # 8. 战场分布 (6)
-            dist = state_json.get("soldier_distribution", {})
-            features.append(dist.get("my_front_soldier_count", 0) / 20.0)
-            features.append(dist.get("my_avg_x", 10.0) / 20.0)
-            features.append(dist.get("my_avg_y", 10.0) / 20.0)
-            features.append(dist.get("enemy_front_soldier_count", 0) / 20.0)
-            features.append(dist.get("enemy_avg_x", 10.0) / 20.0)
-            features.append(dist.get("enemy_avg_y", 10.0) / 20.0)
-
-            # 9. 治疗量 (2)
-            features.append(state_json.get("my_heal_done", 0) / 100.0)
-            features.append(state_json.get("enemy_heal_done", 0) / 100.0)
-
-            # 10. 游戏状态 (1)
-            features.append(1.0 if state_json.get("game_over", False) else 0.0)
-
-            # 补充到 79 维
-            while len(features) < 79:
-                features.append(0.0)
-
-            state_tensor = torch.FloatTensor(features[:79])
-
-            # 提取我方动作（my_team=1）
-            action = episode['team1_action']
-            action_type = action['action_type']
-            base_id = action['base_id']
-            unit_type = action['unit_type']
-
-            # 保留所有动作（包括防御）
-            states.append(state_tensor)
-            action_types.append(action_type)
-            base_ids.append(base_id)
-            unit_types.append(unit_type)
+            if FILTER_WINNING_ONLY:
+                # 假设我们只学习 my_team (team1) 的胜利数据
+                if winner != 1:
+                    skipped_games += 1
+                    continue
+
+            kept_games += 1
+
+            # 计算这局游戏中每个turn的折扣累积奖励
+            game_episodes = game['episodes']
+            rewards.extend(compute_discounted_rewards(game_episodes, winner, GAMMA))
+            total_episodes += len(game_episodes)
+
+            # 提取我方状态（假设my_team=1），整局一次编码
+            states.extend(torch.from_numpy(encode_game(line if line is not None else game)))
+
+            for episode in game_episodes:
+
+                # 提取我方动作（my_team=1），保留所有动作（包括防御）
+                action = episode['team1_action']
+                action_types.append(action['action_type'])
+                base_ids.append(action['base_id'])
+                unit_types.append(action['unit_type'])
+
+        print(f" Filtered games: Kept {kept_games}, Skipped {skipped_games} (Winning only: {FILTER_WINNING_ONLY})")
+        print(f"️  Found {total_episodes} total episodes across {kept_games + skipped_games} games")
 
         print(f" Parsed {len(states)} samples before resampling.")
         
@@ -353,7 +386,7 @@ def load_or_process_data(log_file, device):
         traceback.print_exc()
         return None
 
-def train_with_game_log(log_file="game_log.json", epochs=200):
+def train_with_game_log(log_file="game_log.jsonl", epochs=200, dataset_dir="dataset"):
     # 设备选择：MPS优先，否则CPU
     if torch.backends.mps.is_available():
         device = torch.device("mps")
@@ -362,8 +395,14 @@ def train_with_game_log(log_file="game_log.json", epochs=200):
         device = torch.device("cpu")
         print(" Using CPU")
 
-    # 加载数据
-    data = load_or_process_data(log_file, 'cpu')
+    # 加载数据：优先使用二进制数据集分片，没有时解析JSON日志
+    dataset_path = Path(dataset_dir)
+    if not dataset_path.exists():
+        dataset_path = SCRIPT_DIR.parent / dataset_dir
+    if any(dataset_path.glob('*.dsds')):
+        data = load_binary_dataset(dataset_path)
+    else:
+        data = load_or_process_data(log_file, 'cpu')
     if not data: return
     states_tensor, action_types_tensor, base_ids_tensor, unit_types_tensor = data
 
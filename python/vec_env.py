@@ -0,0 +1,120 @@
+"""
+批量强化学习环境 - 通过 ctypes 调用 C++ 的 libds_vecenv（include/VecEnv.h）
+
+N 局游戏在 C++ 线程池中同时推进一回合，观测/动作/奖励都是连续的 numpy 数组，
+每一步只需要对 obs[N][79] 做一次批量前向传播。接口与 gymnasium 的向量环境一致：
+
+    env = VecEnv(num_envs=64, threads=8)
+    obs, info = env.reset(seed=0)
+    obs, rewards, terminated, truncated, info = env.step(actions)  # actions: int8[N][3]
+
+智能体控制 Team 1（与训练日志视角一致），对手为规则AI或原生策略网络（policy_path，默认 python/policy_model.bin，
+无法加载时构造失败，而不是让对手一直不出兵）。
+动作为 (action_type, base_id, unit_type)，每回合最多出一个兵；结束的环境自动开始下一局，
+此时返回的观测是新一局的初始观测。
+"""
+
+import ctypes
+import os
+from pathlib import Path
+
+import numpy as np
+
+from features import FEATURE_VERSION, SCRIPT_DIR, library_candidates
+
+# 击杀信息等逐事件输出在训练模式下静默（与 run_training.sh 相同）
+os.environ.setdefault("TRAINING_MODE", "1")
+
+try:
+    import gymnasium
+    from gymnasium import spaces
+except ImportError:
+    gymnasium = None
+
+OPPONENT_RULE = 0
+OPPONENT_NATIVE = 1
+DEFAULT_POLICY_PATH = SCRIPT_DIR / "policy_model.bin"  # export_weights.py 的默认输出
+
+ACTION_FIELDS = 3
+ACTION_NVEC = (2, 3, 5)  # action_type, base_id, unit_type
+
+
+def _load_library():
+    for path in library_candidates("ds_vecenv", "DS_VECENV_LIB"):
+        lib = ctypes.CDLL(str(path))
+        lib.ds_vecenv_create.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_char_p]
+        lib.ds_vecenv_create.restype = ctypes.c_void_p
+        lib.ds_vecenv_destroy.argtypes = [ctypes.c_void_p]
+        lib.ds_vecenv_size.argtypes = [ctypes.c_void_p]
+        lib.ds_vecenv_size.restype = ctypes.c_int32
+        lib.ds_vecenv_obs_dim.restype = ctypes.c_int32
+        lib.ds_vecenv_feature_version.restype = ctypes.c_uint32
+        lib.ds_vecenv_reset.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p]
+        lib.ds_vecenv_step.argtypes = [ctypes.c_void_p] + [ctypes.c_void_p] * 4
+        return lib
+    raise OSError("libds_vecenv not found (build the ds_vecenv CMake target or set DS_VECENV_LIB)")
+
+
+class VecEnv:
+    def __init__(self, num_envs, threads=None, opponent=OPPONENT_RULE, policy_path=DEFAULT_POLICY_PATH):
+        self._lib = _load_library()
+        if self._lib.ds_vecenv_feature_version() != FEATURE_VERSION:
+            raise RuntimeError("libds_vecenv was built with a different feature version")
+
+        threads = threads or os.cpu_count() or 1
+        # 权重路径转为绝对路径（C++ 端相对于进程工作目录解析），所有环境共享一份
+        path = str(Path(policy_path).resolve()).encode() if opponent == OPPONENT_NATIVE else None
+        self._handle = self._lib.ds_vecenv_create(num_envs, threads, opponent, path)
+        if not self._handle:
+            if opponent == OPPONENT_NATIVE:
+                raise RuntimeError(f"ds_vecenv_create failed (cannot load opponent policy {policy_path}?)")
+            raise RuntimeError("ds_vecenv_create failed")
+
+        self.num_envs = self._lib.ds_vecenv_size(self._handle)
+        self.obs_dim = self._lib.ds_vecenv_obs_dim()
+
+        # 输出缓冲区在各步之间复用，返回的是副本
+        self._obs = np.zeros((self.num_envs, self.obs_dim), dtype=np.float32)
+        self._rewards = np.zeros(self.num_envs, dtype=np.float32)
+        self._dones = np.zeros(self.num_envs, dtype=np.uint8)
+        self._actions = np.zeros((self.num_envs, ACTION_FIELDS), dtype=np.int8)
+
+        if gymnasium is not None:
+            self.single_observation_space = spaces.Box(-np.inf, np.inf, (self.obs_dim,), dtype=np.float32)
+            self.single_action_space = spaces.MultiDiscrete(ACTION_NVEC)
+            self.observation_space = spaces.Box(-np.inf, np.inf, (self.num_envs, self.obs_dim), dtype=np.float32)
+            self.action_space = spaces.MultiDiscrete(np.tile(ACTION_NVEC, (self.num_envs, 1)))
+
+    def reset(self, seed=None):
+        if seed is None:
+            seeds = np.random.randint(0, 2**32, size=self.num_envs, dtype=np.uint64).astype(np.uint32)
+        elif np.isscalar(seed):
+            seeds = (np.arange(self.num_envs, dtype=np.uint64) + seed).astype(np.uint32)
+        else:
+            seeds = np.asarray(seed, dtype=np.uint32)
+            assert seeds.shape == (self.num_envs,)
+        seeds = np.ascontiguousarray(seeds)
+        self._lib.ds_vecenv_reset(self._handle, seeds.ctypes.data, self._obs.ctypes.data)
+        return self._obs.copy(), {}
+
+    def step(self, actions):
+        np.copyto(self._actions, np.asarray(actions).reshape(self.num_envs, ACTION_FIELDS), casting='unsafe')
+        self._lib.ds_vecenv_step(self._handle, self._actions.ctypes.data, self._obs.ctypes.data,
+                                 self._rewards.ctypes.data, self._dones.ctypes.data)
+        terminated = self._dones.astype(bool)
+        truncated = np.zeros(self.num_envs, dtype=bool)  # 回合上限在C++端判定胜负，视为正常结束
+        return self._obs.copy(), self._rewards.copy(), terminated, truncated, {}
+
+    def close(self):
+        if getattr(self, "_handle", None):
+            self._lib.ds_vecenv_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
@@ -1,7 +1,8 @@
 #!/bin/bash
 
-# 默认运行8000局，可通过参数调整
-NUM_GAMES=${1:8000}
+# 默认运行8000局，可通过参数调整；第二个参数为并行线程数（默认使用全部CPU核心）
+NUM_GAMES=${1:-8000}
+NUM_THREADS=${2:-0}
 
 echo "模式: 规则AI（蓝色）vs 规则AI（红色）"
 echo "游戏局数: $NUM_GAMES"
@@ -17,26 +18,15 @@ fi
 # 记录开始时间
 START_TIME=$(date +%s)
 
-# 循环运行多局游戏
-for i in $(seq 1 $NUM_GAMES); do
+# 在同一进程内并行运行多局游戏（每局独立的随机种子，结束后汇总胜负）
+# 设置环境变量以禁用详细输出
+TRAINING_MODE=1 ./cmake-build-release/ds_train --games "$NUM_GAMES" --threads "$NUM_THREADS" \
+    --team0 ai_rule --team1 ai_rule
+
+if [ $? -ne 0 ]; then
     echo ""
-    echo "========================================="
-    echo "  第 $i/$NUM_GAMES 局游戏开始"
-    echo "========================================="
-    
-    # 使用双规则AI进行极速训练
-    # 设置环境变量以禁用详细输出
-    TRAINING_MODE=1 ./cmake-build-release/DS_PJ --mode training --team0 ai_rule --team1 ai_rule
-    
-    # 检查是否被中断
-    if [ $? -ne 0 ]; then
-        echo ""
-        echo "游戏异常退出"
-        break
-    fi
-    
-    echo "第 $i 局完成"
-done
+    echo "游戏异常退出"
+fi
 
 # 计算总用时
 END_TIME=$(date +%s)
@@ -48,7 +38,7 @@ echo ""
 echo "========================================="
 echo "  训练完成！"
 echo "========================================="
-echo "总局数: $i 局"
+echo "总局数: $NUM_GAMES 局"
 echo "总用时: ${MINUTES}分${SECONDS}秒"
-echo "日志文件: game_log.json"
+echo "日志文件: game_log.jsonl"
 echo ""
@@ -6,9 +6,8 @@
 #include <random>
 #include <algorithm>
 #include <iostream>
-#include <sstream>
 
-AIController::AIController(std::mt19937& rng) : rng(rng) {
+AIController::AIController(RngStream& rng) : rng(rng) {
     // 初始化AI购买队列，包含所有5种兵种
     std::uniform_int_distribution<> typeDis(0, 4);  // 0-4: 包括Caster和Doctor
     for (int i = 0; i < 5; ++i) {
@@ -26,9 +25,9 @@ AIController::AIController(std::mt19937& rng) : rng(rng) {
     }
 }
 
-std::string AIController::tryPurchaseOnce(std::shared_ptr<GameModel> model, GameController* controller, int turnCount, Team team) {
+Action AIController::tryPurchaseOnce(std::shared_ptr<GameModel> model, GameController* controller, int turnCount, Team team) {
     // 默认返回 wait 动作
-    std::string defaultAction = "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
+    const Action defaultAction = Action::wait();
     
     // 改进：不使用固定间隔，而是每回合都尝试购买（如果有足够能量）
     // 这样在游戏初期有初始能量时会连续出兵
@@ -87,55 +86,18 @@ std::string AIController::tryPurchaseOnce(std::shared_ptr<GameModel> model, Game
         }
         purchaseQueue.push_back(newType);
         
-        // 返回实际执行的动作 JSON（映射所有5种兵种）
-        int unitTypeInt = (type == SoldierType::ARCHER) ? 0 : 
-                          (type == SoldierType::INFANTRY) ? 1 :
-                          (type == SoldierType::CAVALRY) ? 2 :
-                          (type == SoldierType::CASTER) ? 3 : 4;  // Doctor
-        
-        std::ostringstream oss;
-        oss << "{\"action_type\": 1, \"base_id\": " << selectedBaseIdx 
-            << ", \"unit_type\": " << unitTypeInt << "}";
-        return oss.str();
+        // 返回实际执行的动作
+        return Action::spawn(selectedBaseIdx, type);
     }
     
     return defaultAction;
 }
 
-std::vector<Position> AIController::getMoveCandidates(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier) {
+std::vector<Position> AIController::getMoveCandidates(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier,
+                                                     RngStream& moveRng) {
     Position currentPos = soldier->getPosition();
     Team team = soldier->getTeam();
     
-    // 查找目标位置
-    Position targetPos;
-    auto nearestEnemy = findNearestEnemy(model, soldier);
-    
-    if (nearestEnemy) {
-        targetPos = nearestEnemy->getPosition();
-    } else {
-        targetPos = findEnemyBase(model, soldier->getTeam(), currentPos);
-    }
-    
-    // 计算移动方向
-    int dx = 0, dy = 0;
-    if (targetPos.x > currentPos.x) dx = 1;
-    else if (targetPos.x < currentPos.x) dx = -1;
-    
-    if (targetPos.y > currentPos.y) dy = 1;
-    else if (targetPos.y < currentPos.y) dy = -1;
-    
-    // 添加随机偏移避免完全一致的路径（30%概率）
-    std::uniform_int_distribution<> randomDis(0, 9);
-    if (randomDis(rng) < 3) {
-        // 随机选择侧向移动
-        std::uniform_int_distribution<> sideDis(0, 1);
-        if (sideDis(rng) == 0) {
-            if (dx != 0) dy = (dy == 0) ? (sideDis(rng) == 0 ? 1 : -1) : -dy;
-        } else {
-            if (dy != 0) dx = (dx == 0) ? (sideDis(rng) == 0 ? 1 : -1) : -dx;
-        }
-    }
-    
     // 收集所有可能的移动位置及其拥挤度
     struct CandidateMove {
         Position pos;
@@ -145,38 +107,90 @@ std::vector<Position> AIController::getMoveCandidates(std::shared_ptr<GameModel>
     
     std::vector<CandidateMove> candidateMoves;
     
-    // 优先级1：斜向目标（同时x和y方向移动）
-    if (dx != 0 && dy != 0) {
-        Position pos(currentPos.x + dx, currentPos.y + dy);
-        candidateMoves.push_back({pos, 1, getCrowdednessAtPosition(model, pos, team, 2)});
-    }
+    // 查找目标位置
+    Position targetPos;
+    auto nearestEnemy = findNearestEnemy(model, soldier);
     
-    // 优先级2：单方向向目标
-    if (dx != 0) {
-        Position pos(currentPos.x + dx, currentPos.y);
-        candidateMoves.push_back({pos, 2, getCrowdednessAtPosition(model, pos, team, 2)});
-    }
-    if (dy != 0) {
-        Position pos(currentPos.x, currentPos.y + dy);
-        candidateMoves.push_back({pos, 2, getCrowdednessAtPosition(model, pos, team, 2)});
+    if (nearestEnemy) {
+        targetPos = nearestEnemy->getPosition();
+    } else {
+        // 没有可见敌人时沿流场下降前往敌方基地（可以绕过山脉和河流）
+        const FlowField& field = model->getFlowField(team);
+        uint16_t here = field.at(currentPos);
+        if (here != FlowField::UNREACHABLE && here > 0) {
+            for (int i = -1; i <= 1; i++) {
+                for (int j = -1; j <= 1; j++) {
+                    if (i == 0 && j == 0) continue;
+                    Position newPos(currentPos.x + i, currentPos.y + j);
+                    uint16_t distance = field.at(newPos);
+                    if (distance == FlowField::UNREACHABLE) continue;  // 不可通行
+                    
+                    // 优先级：下坡 > 等高（绕行） > 上坡
+                    int priority = (distance < here) ? 1 : (distance == here ? 2 : 3);
+                    candidateMoves.push_back({newPos, priority, getCrowdednessAtPosition(model, newPos, team, 2)});
+                }
+            }
+            // 打乱后稳定排序：同优先级、同拥挤度的格子随机选择，避免所有士兵走同一条路
+            std::shuffle(candidateMoves.begin(), candidateMoves.end(), moveRng);
+        }
+        targetPos = findEnemyBase(model, soldier->getTeam(), currentPos);
     }
     
-    // 优先级3：其他方向
-    for (int i = -1; i <= 1; i++) {
-        for (int j = -1; j <= 1; j++) {
-            if (i == 0 && j == 0) continue;
-            Position newPos(currentPos.x + i, currentPos.y + j);
-            
-            // 检查是否已在候选列表中
-            bool alreadyAdded = false;
-            for (const auto& c : candidateMoves) {
-                if (c.pos == newPos) {
-                    alreadyAdded = true;
-                    break;
-                }
+    // 贪心朝目标方向移动（追击可见敌人，或当前位置无法沿流场前进时）
+    if (candidateMoves.empty()) {
+        // 计算移动方向
+        int dx = 0, dy = 0;
+        if (targetPos.x > currentPos.x) dx = 1;
+        else if (targetPos.x < currentPos.x) dx = -1;
+        
+        if (targetPos.y > currentPos.y) dy = 1;
+        else if (targetPos.y < currentPos.y) dy = -1;
+        
+        // 添加随机偏移避免完全一致的路径（30%概率）
+        std::uniform_int_distribution<> randomDis(0, 9);
+        if (randomDis(moveRng) < 3) {
+            // 随机选择侧向移动
+            std::uniform_int_distribution<> sideDis(0, 1);
+            if (sideDis(moveRng) == 0) {
+                if (dx != 0) dy = (dy == 0) ? (sideDis(moveRng) == 0 ? 1 : -1) : -dy;
+            } else {
+                if (dy != 0) dx = (dx == 0) ? (sideDis(moveRng) == 0 ? 1 : -1) : -dx;
             }
-            if (!alreadyAdded) {
-                candidateMoves.push_back({newPos, 3, getCrowdednessAtPosition(model, newPos, team, 2)});
+        }
+        
+        // 优先级1：斜向目标（同时x和y方向移动）
+        if (dx != 0 && dy != 0) {
+            Position pos(currentPos.x + dx, currentPos.y + dy);
+            candidateMoves.push_back({pos, 1, getCrowdednessAtPosition(model, pos, team, 2)});
+        }
+        
+        // 优先级2：单方向向目标
+        if (dx != 0) {
+            Position pos(currentPos.x + dx, currentPos.y);
+            candidateMoves.push_back({pos, 2, getCrowdednessAtPosition(model, pos, team, 2)});
+        }
+        if (dy != 0) {
+            Position pos(currentPos.x, currentPos.y + dy);
+            candidateMoves.push_back({pos, 2, getCrowdednessAtPosition(model, pos, team, 2)});
+        }
+        
+        // 优先级3：其他方向
+        for (int i = -1; i <= 1; i++) {
+            for (int j = -1; j <= 1; j++) {
+                if (i == 0 && j == 0) continue;
+                Position newPos(currentPos.x + i, currentPos.y + j);
+                
+                // 检查是否已在候选列表中
+                bool alreadyAdded = false;
+                for (const auto& c : candidateMoves) {
+                    if (c.pos == newPos) {
+                        alreadyAdded = true;
+                        break;
+                    }
+                }
+                if (!alreadyAdded) {
+                    candidateMoves.push_back({newPos, 3, getCrowdednessAtPosition(model, newPos, team, 2)});
+                }
             }
         }
     }
@@ -186,7 +200,7 @@ std::vector<Position> AIController::getMoveCandidates(std::shared_ptr<GameModel>
     // 2. 如果当前位置拥挤度很高（>=5），大幅降低向拥挤处移动的意愿
     int currentCrowdedness = getCrowdednessAtPosition(model, currentPos, team, 2);
     
-    std::sort(candidateMoves.begin(), candidateMoves.end(), 
+    std::stable_sort(candidateMoves.begin(), candidateMoves.end(), 
         [currentCrowdedness](const CandidateMove& a, const CandidateMove& b) {
             // 先按优先级排序
             if (a.priority != b.priority) {
@@ -256,37 +270,21 @@ std::vector<Position> AIController::getRetreatPositions(const Position& currentP
 }
 
 std::shared_ptr<Soldier> AIController::findNearestEnemy(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier) {
-    auto soldiers = model->getSoldiers();
-    std::shared_ptr<Soldier> nearest = nullptr;
-    int minDistance = 999999;
-    
+    const SoldierColumns& cols = model->getSoldierColumns();
     Position myPos = soldier->getPosition();
-    Team myTeam = soldier->getTeam();
+    Team enemyTeam = (soldier->getTeam() == Team::TEAM_A) ? Team::TEAM_B : Team::TEAM_A;
+    int vision = soldier->getVisionRange();
     
-    // 获取队友共享的敌人ID列表
-    std::set<int> sharedEnemyIds = soldier->getSharedVisibleEnemies();
+    // 所在共享视野组的视野位图
+    const VisionBoard* sharedVision = model->getSharedVision(soldier->getId());
     
-    for (size_t i = 0; i < soldiers.size(); ++i) {
-        const auto& other = soldiers[i];
-        if (!other->isAlive()) continue;
-        if (other->getTeam() == myTeam) continue;
-        
-        Position otherPos = other->getPosition();
-        
-        // 检查是否在直接视野内，或在队友共享的视野中
-        bool canDetect = soldier->canSee(otherPos) || 
-                        (sharedEnemyIds.find(static_cast<int>(i)) != sharedEnemyIds.end());
-        
-        if (!canDetect) continue;
-        
-        int distance = myPos.distanceTo(otherPos);
-        if (distance < minDistance) {
-            minDistance = distance;
-            nearest = other;
-        }
-    }
+    // 最近的可探测敌人：在直接视野内，或在共享视野覆盖的格子上
+    int nearest = model->getSpatialIndex().nearest(myPos, enemyTeam, DistanceMetric::MANHATTAN, [&](size_t i) {
+        return myPos.chebyshevDistanceTo(cols.positionAt(i)) <= vision ||
+               (sharedVision && sharedVision->test(cols.x[i], cols.y[i]));
+    });
     
-    return nearest;
+    return nearest >= 0 ? model->soldiers[nearest] : nullptr;
 }
 
 Position AIController::findEnemyBase(std::shared_ptr<GameModel> model, Team team, const Position& fromPos) {
@@ -315,43 +313,50 @@ Position AIController::findEnemyBase(std::shared_ptr<GameModel> model, Team team
 }
 
 bool AIController::isPositionOccupied(std::shared_ptr<GameModel> model, const Position& pos, std::shared_ptr<Soldier> excludeSoldier) {
-    auto soldiers = model->getSoldiers();
-    for (const auto& s : soldiers) {
-        if (s != excludeSoldier && s->isAlive() && s->getPosition() == pos) {
-            return true;
-        }
-    }
-    return false;
+    return model->isOccupied(pos, excludeSoldier ? excludeSoldier->getId() : INVALID_SOLDIER_ID);
 }
 
 int AIController::countNearbyAllies(std::shared_ptr<GameModel> model, std::shared_ptr<Soldier> soldier, int radius) {
     int count = 0;
-    Position pos = soldier->getPosition();
-    Team team = soldier->getTeam();
+    int self = model->soldiers.denseIndexOf(soldier->getId());
     
-    auto soldiers = model->getSoldiers();
-    for (const auto& s : soldiers) {
-        if (s != soldier && s->isAlive() && s->getTeam() == team) {
-            int dist = abs(s->getPosition().x - pos.x) + abs(s->getPosition().y - pos.y);
-            if (dist <= radius) {
-                count++;
-            }
-        }
-    }
+    model->getSpatialIndex().forEachInRadius(soldier->getPosition(), radius, soldier->getTeam(),
+                                             DistanceMetric::MANHATTAN, [&](size_t i) {
+        if (static_cast<int>(i) != self) count++;
+    });
     return count;
 }
 
 int AIController::getCrowdednessAtPosition(std::shared_ptr<GameModel> model, const Position& pos, Team team, int radius) {
+    // 常用半径直接查影响力图
+    if (radius == InfluenceMap::DENSITY_RADIUS) {
+        return model->getInfluence().densityAt(team, pos);
+    }
+    
     int count = 0;
+    model->getSpatialIndex().forEachInRadius(pos, radius, team, DistanceMetric::MANHATTAN, [&](size_t) {
+        count++;
+    });
+    return count;
+}
+
+Action AIController::rolloutPurchase(const GameState& state, int team, SoldierType& queueHead, RngStream& rng) {
+    // 快照在回合开始前，动作在本回合产出能量之后执行
+    if (state.energy[team] + ENERGY_PER_TURN < CombatSystem::getSoldierCost(queueHead)) {
+        return Action::wait();
+    }
     
-    auto soldiers = model->getSoldiers();
-    for (const auto& s : soldiers) {
-        if (s->isAlive() && s->getTeam() == team) {
-            int dist = abs(s->getPosition().x - pos.x) + abs(s->getPosition().y - pos.y);
-            if (dist <= radius) {
-                count++;
-            }
-        }
+    int aliveBases[BASE_COUNT_PER_TEAM];
+    int aliveCount = 0;
+    for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+        if (state.bases[team][i].hp > 0) aliveBases[aliveCount++] = i;
     }
-    return count;
+    if (aliveCount == 0) return Action::wait();
+    
+    std::uniform_int_distribution<> baseDis(0, aliveCount - 1);
+    Action action = Action::spawn(aliveBases[baseDis(rng)], queueHead);
+    
+    std::uniform_int_distribution<> typeDis(0, SOLDIER_TYPE_COUNT - 1);
+    queueHead = static_cast<SoldierType>(typeDis(rng));
+    return action;
 }
@@ -4,9 +4,16 @@
 #include <iostream>
 #include <cstdlib>
 #include <map>
+#include <algorithm>
 
-std::map<int, int> CombatSystem::processCombat(std::shared_ptr<GameModel> model, std::vector<GameEvent>& events, int currentTurn) {
-    auto soldiers = model->getSoldiers();
+std::map<int, int> CombatSystem::processCombat(std::shared_ptr<GameModel> model, std::vector<GameEvent>& events, int currentTurn,
+                                            bool verbose) {
+    // 战斗阶段不增删士兵，按组件存储的连续下标处理；生命值和存活状态随攻击实时更新
+    // 目标通过空间哈希查找，多个候选时取下标最小的（与按顺序扫描的结果一致）
+    const SoldierColumns& cols = model->getSoldierColumns();
+    const SpatialHash& spatial = model->getSpatialIndex();
+    auto& soldiers = model->soldiers;
+    size_t count = cols.size();
     
     // 初始化治疗量统计 (team 0 和 team 1)
     std::map<int, int> healStats;
@@ -14,117 +21,110 @@ std::map<int, int> CombatSystem::processCombat(std::shared_ptr<GameModel> model,
     healStats[1] = 0;
     
     // 第1步：医疗兵治疗友军
-    for (auto& doctor : soldiers) {
-        if (!doctor->isAlive()) continue;
-        if (doctor->getType() != SoldierType::DOCTOR) continue;
+    for (size_t d = 0; d < count; d++) {
+        if (!cols.isAlive(d)) continue;
+        if (cols.typeAt(d) != SoldierType::DOCTOR) continue;
         
-        // 查找治疗范围内的友军
-        for (auto& ally : soldiers) {
-            if (!ally->isAlive()) continue;
-            if (ally->getTeam() != doctor->getTeam()) continue;
-            if (ally == doctor) continue;  // 不治疗自己
+        // 查找治疗范围内的友军（治疗不会改变存活状态，可以在查询回调中直接修改）
+        spatial.forEachInRadius(cols.positionAt(d), Doctor::HEAL_RANGE, cols.teamAt(d),
+                                DistanceMetric::MANHATTAN, [&](size_t a) {
+            if (a == d) return;  // 不治疗自己
             
-            int dx = ally->getPosition().x - doctor->getPosition().x;
-            int dy = ally->getPosition().y - doctor->getPosition().y;
-            int distance = std::abs(dx) + std::abs(dy);
+            // 治疗：恢复生命值，不超过最大值
+            int currentHp = cols.hp[a];
+            int maxHp = cols.statsAt(a).hp;
+            int healAmount = Doctor::HEAL_AMOUNT;
+            int newHp = std::min(maxHp, currentHp + healAmount);
+            int actualHeal = newHp - currentHp;  // 实际治疗量
+            soldiers[a]->setHp(newHp);
             
-            if (distance <= Doctor::HEAL_RANGE) {
-                // 治疗：恢复生命值，不超过最大值
-                int currentHp = ally->getHp();
-                int maxHp = ally->getMaxHp();
-                int healAmount = Doctor::HEAL_AMOUNT;
-                int newHp = std::min(maxHp, currentHp + healAmount);
-                int actualHeal = newHp - currentHp;  // 实际治疗量
-                ally->setHp(newHp);
-                
-                // 统计治疗量
-                healStats[static_cast<int>(doctor->getTeam())] += actualHeal;
-            }
-        }
+            // 统计治疗量
+            healStats[cols.team[d]] += actualHeal;
+        });
     }
     
+    // 攻击范围内下标最小的敌人
+    auto firstTargetInRange = [&](size_t i) {
+        int first = -1;
+        Team enemyTeam = (cols.teamAt(i) == Team::TEAM_A) ? Team::TEAM_B : Team::TEAM_A;
+        spatial.forEachInRadius(cols.positionAt(i), cols.statsAt(i).attackRange, enemyTeam,
+                                DistanceMetric::CHEBYSHEV, [&](size_t j) {
+            if (first < 0 || static_cast<int>(j) < first) first = static_cast<int>(j);
+        });
+        return first;
+    };
+    std::vector<size_t> splashTargets;
+    
     // 第2步：处理士兵对士兵的攻击
-    for (auto& attacker : soldiers) {
-        if (!attacker->isAlive()) continue;
+    for (size_t i = 0; i < count; i++) {
+        if (!cols.isAlive(i)) continue;
+        
+        const auto& attacker = soldiers[i];
         
         // 法师：范围伤害
-        if (attacker->getType() == SoldierType::CASTER) {
+        if (cols.typeAt(i) == SoldierType::CASTER) {
             // 查找攻击范围内的主要目标
-            std::shared_ptr<Soldier> mainTarget = nullptr;
-            for (auto& target : soldiers) {
-                if (!target->isAlive()) continue;
-                if (attacker->getTeam() == target->getTeam()) continue;
-                
-                if (attacker->canAttack(target->getPosition())) {
-                    mainTarget = target;
-                    break;
-                }
-            }
+            int mainTarget = firstTargetInRange(i);
             
-            if (mainTarget) {
-                // 对主要目标及其周围敌人造成伤害
-                for (auto& target : soldiers) {
-                    if (!target->isAlive()) continue;
-                    if (attacker->getTeam() == target->getTeam()) continue;
-                    
-                    int dx = target->getPosition().x - mainTarget->getPosition().x;
-                    int dy = target->getPosition().y - mainTarget->getPosition().y;
-                    int distance = std::abs(dx) + std::abs(dy);
-                    
-                    if (distance <= Caster::AOE_RANGE) {
-                        bool killed = attackTarget(attacker, target, model, events, currentTurn);
-                        if (killed) {
-                            int cost = getSoldierCost(target->getType());
-                            int reward = static_cast<int>(cost * 0.5);
-                            model->addEnergy(attacker->getTeam(), reward);
-                        }
+            if (mainTarget >= 0) {
+                // 对主要目标及其周围敌人造成伤害（先收集再攻击，击杀会修改空间哈希）
+                Team enemyTeam = cols.teamAt(mainTarget);
+                splashTargets.clear();
+                spatial.forEachInRadius(cols.positionAt(mainTarget), Caster::AOE_RANGE, enemyTeam,
+                                        DistanceMetric::MANHATTAN, [&](size_t j) {
+                    splashTargets.push_back(j);
+                });
+                std::sort(splashTargets.begin(), splashTargets.end());
+                
+                for (size_t j : splashTargets) {
+                    bool killed = attackTarget(attacker, soldiers[j], model, events, currentTurn);
+                    if (killed) {
+                        int cost = getSoldierCost(cols.typeAt(j));
+                        int reward = static_cast<int>(cost * 0.5);
+                        model->addEnergy(cols.teamAt(i), reward);
                     }
                 }
             }
         } 
-        // 其他兵种：单体攻击
+        // 其他兵种：单体攻击（每回合只攻击一次）
         else {
-            for (auto& target : soldiers) {
-                if (!target->isAlive()) continue;
-                if (attacker->getTeam() == target->getTeam()) continue;
+            int j = firstTargetInRange(i);
+            if (j >= 0) {
+                bool killed = attackTarget(attacker, soldiers[j], model, events, currentTurn);
                 
-                if (attacker->canAttack(target->getPosition())) {
-                    bool killed = attackTarget(attacker, target, model, events, currentTurn);
+                // 如果击杀了敌人，给予能量奖励（80%成本）
+                if (killed) {
+                    int cost = getSoldierCost(cols.typeAt(j));
+                    int reward = static_cast<int>(cost * 0.5);
+                    model->addEnergy(cols.teamAt(i), reward);
                     
-                    // 如果击杀了敌人，给予能量奖励（80%成本）
-                    if (killed) {
-                        int cost = getSoldierCost(target->getType());
-                        int reward = static_cast<int>(cost * 0.5);
-                        model->addEnergy(attacker->getTeam(), reward);
-                        
-                        // 输出击杀信息（训练模式下静默）
-                        const char* trainingMode = std::getenv("TRAINING_MODE");
-                        if (!trainingMode || std::string(trainingMode) != "1") {
-                            std::string attackerTeam = (attacker->getTeam() == Team::TEAM_A) ? "Team A" : "Team B";
-                            std::string targetType = getSoldierTypeName(target->getType());
-                            std::cout << "[Kill] " << attackerTeam << " killed enemy " << targetType 
-                                      << " | Energy reward: " << reward << std::endl;
-                        }
+                    // 输出击杀信息（训练模式下静默）
+                    const char* trainingMode = verbose ? std::getenv("TRAINING_MODE") : nullptr;
+                    if (verbose && (!trainingMode || std::string(trainingMode) != "1")) {
+                        std::string attackerTeam = (cols.teamAt(i) == Team::TEAM_A) ? "Team A" : "Team B";
+                        std::string targetType = getSoldierTypeName(cols.typeAt(j));
+                        std::cout << "[Kill] " << attackerTeam << " killed enemy " << targetType 
+                                  << " | Energy reward: " << reward << std::endl;
                     }
-                    
-                    break;  // 每回合只攻击一次
                 }
             }
         }
     }
     
     // 处理士兵对基地的攻击
-    for (auto& attacker : soldiers) {
-        if (!attacker->isAlive()) continue;
+    for (size_t i = 0; i < count; i++) {
+        if (!cols.isAlive(i)) continue;
         
         // 攻击所有范围内的敌方基地
-        const auto& enemyBases = (attacker->getTeam() == Team::TEAM_A) ? 
+        const auto& enemyBases = (cols.teamAt(i) == Team::TEAM_A) ? 
                                  model->getBasesTeamB() : model->getBasesTeamA();
+        int attackRange = cols.statsAt(i).attackRange;
         
         for (const auto& enemyBase : enemyBases) {
-            if (enemyBase->isAlive() && 
-                attacker->canAttack(enemyBase->getPosition())) {
-                attackBase(attacker, enemyBase.get(), model, events, currentTurn);
+            if (!enemyBase->isAlive()) continue;
+            Position basePos = enemyBase->getPosition();
+            if (std::max(std::abs(cols.x[i] - basePos.x), std::abs(cols.y[i] - basePos.y)) <= attackRange) {
+                attackBase(soldiers[i], enemyBase.get(), model, events, currentTurn);
             }
         }
     }
@@ -170,6 +170,8 @@ bool CombatSystem::attackTarget(std::shared_ptr<Soldier> attacker,
     if (!target->isAlive()) {
         GameEvent evt(EventType::KILL, static_cast<int>(attacker->getTeam()), currentTurn, "Kill");
         evt.damage = 0; // 击杀事件不记录伤害值，除非有需求
+        evt.soldier_id = attacker->getId();
+        evt.target_id = target->getId();
         events.push_back(evt);
     }
     
@@ -210,6 +212,7 @@ void CombatSystem::attackBase(std::shared_ptr<Soldier> attacker, Base* base, std
     // 生成基地受损事件
     GameEvent evt(EventType::BASE_DAMAGED, static_cast<int>(base->getTeam()), currentTurn, "Base Damaged");
     evt.damage = damage;
+    evt.soldier_id = attacker->getId();
     events.push_back(evt);
 }
 
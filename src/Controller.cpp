@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include <random>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <thread>
 #include <cmath>
@@ -14,13 +15,14 @@ using json = nlohmann::json;
 GameController::GameController(std::shared_ptr<GameModel> model,
                                GameMode mode,
                                PlayerType team0,
-                               PlayerType team1)
-    : model(model), running(false), rng(std::random_device{}()),
-      gameMode(mode), team0Type(team0), team1Type(team1), currentTurn(0),
-      team0HealThisTurn(0), team1HealThisTurn(0) {
+                               PlayerType team1,
+                               const NativePolicy* sharedPolicy)
+    : model(model), running(false),
+      gameMode(mode), team0Type(team0), team1Type(team1), mctsFallbackReported(false), currentTurn(0),
+      team0HealThisTurn(0), team1HealThisTurn(0), verbose(true) {
     // 为两个队伍创建独立的AI控制器
-    aiControllerTeam0 = std::make_unique<AIController>(rng);
-    aiControllerTeam1 = std::make_unique<AIController>(rng);
+    aiControllerTeam0 = std::make_unique<AIController>(model->getRng().stream(RngStreamId::AI_TEAM0));
+    aiControllerTeam1 = std::make_unique<AIController>(model->getRng().stream(RngStreamId::AI_TEAM1));
     
     // 如果使用Python AI，初始化Python代理
     if (team0Type == PlayerType::AI_PYTHON || team1Type == PlayerType::AI_PYTHON) {
@@ -28,6 +30,21 @@ GameController::GameController(std::shared_ptr<GameModel> model,
         pythonAgent->initialize("python/infer.py");
     }
     
+    // 如果使用原生策略网络，加载导出的权重
+    if (team0Type == PlayerType::AI_NATIVE || team1Type == PlayerType::AI_NATIVE) {
+        if (sharedPolicy) {
+            nativePolicy = std::make_unique<NativePolicy>(*sharedPolicy);
+        } else {
+            nativePolicy = std::make_unique<NativePolicy>();
+            nativePolicy->load("python/policy_model.bin");
+        }
+    }
+    
+    // 如果使用蒙特卡洛树搜索，创建规划器（配置来自命令行）
+    if (team0Type == PlayerType::AI_MCTS || team1Type == PlayerType::AI_MCTS) {
+        mctsPlanner = createMctsPlanner();
+    }
+    
     // 如果是训练模式，初始化日志记录器
     if (gameMode == GameMode::TRAINING) {
         trainingLogger = std::make_unique<TrainingLogger>();
@@ -60,6 +77,15 @@ void GameController::start() {
     workerThreads.emplace_back([this]() { gameLoop(); });
 }
 
+void GameController::runToCompletion() {
+    if (running.load()) return;
+    
+    running.store(true);
+    model->initialize();
+    gameLoop();
+    running.store(false);
+}
+
 void GameController::stop() {
     running.store(false);
     
@@ -70,6 +96,62 @@ void GameController::stop() {
         }
     }
     workerThreads.clear();
+    
+    // 等待日志写入线程处理完已提交的记录（Ctrl+C 中断时也能完整保存）
+    if (trainingLogger) {
+        trainingLogger->flush();
+    }
+    if (replayRecorder) {
+        replayRecorder->flush();
+    }
+}
+
+bool GameController::recordReplay(const std::string& path) {
+    replayRecorder = std::make_unique<ReplayRecorder>(path, team0Type, team1Type);
+    if (!replayRecorder->isOpen()) {
+        replayRecorder.reset();
+        return false;
+    }
+    return true;
+}
+
+void GameController::reset() {
+    model->initialize();
+    currentTurn = 0;
+    team0HealThisTurn = 0;
+    team1HealThisTurn = 0;
+    externalActions[0] = Action::wait();
+    externalActions[1] = Action::wait();
+    turnEvents.clear();
+}
+
+void GameController::setExternalAction(int team, const Action& action) {
+    externalActions[team] = action;
+}
+
+void GameController::step() {
+    std::lock_guard<std::mutex> lock(turnMutex);
+    processTurn();
+    currentTurn++;
+    model->incrementTurn();
+}
+
+bool GameController::saveState(GameState& state) const {
+    if (!model->saveState(state)) return false;
+    state.turn = currentTurn;
+    state.healDone[0] = team0HealThisTurn;
+    state.healDone[1] = team1HealThisTurn;
+    return true;
+}
+
+void GameController::loadState(const GameState& state) {
+    model->loadState(state);
+    currentTurn = state.turn;
+    team0HealThisTurn = state.healDone[0];
+    team1HealThisTurn = state.healDone[1];
+    externalActions[0] = Action::wait();
+    externalActions[1] = Action::wait();
+    turnEvents.clear();
 }
 
 void GameController::gameLoop() {
@@ -80,12 +162,16 @@ void GameController::gameLoop() {
         auto turnStart = std::chrono::steady_clock::now();
         
         // 处理一个回合
-        processTurn();
+        {
+            std::lock_guard<std::mutex> lock(turnMutex);
+            processTurn();
+        }
         
         // 训练模式：跳过渲染和时间等待，直接下一回合
         if (gameMode == GameMode::TRAINING) {
             currentTurn++;
             model->incrementTurn();
+            model->publishRenderSnapshot();
             
             // 每1000回合报告速度
             if (currentTurn % 1000 == 0) {
@@ -109,6 +195,7 @@ void GameController::gameLoop() {
         
         currentTurn++;
         model->incrementTurn();
+        model->publishRenderSnapshot();
     }
     
     // 游戏结束，保存日志
@@ -118,106 +205,147 @@ void GameController::gameLoop() {
 }
 
 void GameController::processTurn() {
+    turnEvents.clear();
+    
+    // 录像的第一条记录是开局局面
+    if (replayRecorder && replayRecorder->frameCount() == 0) {
+        replayRecorder->record(*model, Action::wait(), Action::wait());
+    }
+    
+    // 0. 蒙特卡洛树搜索在本回合开始前的快照上进行（快照的下一回合模拟包含本回合的能量产出）
+    // 两队的搜索同时进行；快照保存失败时本回合改用规则AI出兵
+    Action searchedActions[2];
+    bool searched[2] = {false, false};
+    if (mctsPlanner) {
+        searched[0] = team0Type == PlayerType::AI_MCTS;
+        searched[1] = team1Type == PlayerType::AI_MCTS;
+        GameState root;
+        if (!saveState(root)) {
+            if (!mctsFallbackReported) {
+                std::cerr << "MCTS: cannot snapshot the game state, using the rule AI for turns that cannot be saved" << std::endl;
+                mctsFallbackReported = true;
+            }
+            searched[0] = searched[1] = false;
+        } else {
+            uint64_t seeds[2] = {0, 0};
+            for (int team = 0; team < 2; team++) {
+                if (searched[team]) seeds[team] = model->getRng().stream(RngStreamId::SEARCH)();
+            }
+            mctsPlanner->plan(root, searched, seeds, searchedActions);
+        }
+    }
+    
     // 1. 生成能量
     generateEnergy();
     
-    // 2. 更新队友共享视野
+    // 2. 更新队友共享视野、影响力图和寻路流场（流场只在基地被摧毁时重算）
     model->updateSharedVision();
+    model->updateInfluenceMaps();
+    model->updateFlowFields();
     
     // 3. 准备记录本回合的状态和动作（用于训练日志）
-    std::string team0ActionJson = "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
-    std::string team1ActionJson = "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
+    Action team0Action = Action::wait();
+    Action team1Action = Action::wait();
     
     // 在决策前获取状态（训练模式下需要）
     // 注意：现在训练 Team 1（红色），所以获取 Team 1 的视角
-    std::string stateJson;
+    Observation turnState;
     if (trainingLogger && gameMode == GameMode::TRAINING) {
-        stateJson = getStateJson(1);  // 获取 Team 1 的决策前状态
+        observe(1, turnState);  // 获取 Team 1 的决策前状态
     }
+    Observation policyState;  // 策略网络每次购买前的观测（循环内复用）
     
     // 4. Team 0 决策（蓝色 - AI规则/Python AI，允许每回合多次购买）
     const int MAX_PURCHASES_PER_TURN = 3;  // 每回合最多购买3个兵
     
-    if (team0Type == PlayerType::AI_PYTHON && pythonAgent && pythonAgent->isInitialized()) {
-        // Python AI决策 - 循环调用直到无法购买或达到上限
+    if (hasPolicyAgent(team0Type)) {
+        // 策略网络决策（Python/原生） - 循环调用直到无法购买或达到上限
         for (int i = 0; i < MAX_PURCHASES_PER_TURN; ++i) {
-            std::string team0StateJson = getStateJson(0);
-            std::string action = pythonAgent->getAction(team0StateJson);
+            observe(0, policyState);
+            Action action = getPolicyAction(team0Type, policyState);
             
-            // 检查是否是wait动作（action_type == 0）
-            if (action.find("\"action_type\": 0") != std::string::npos) {
+            // 检查是否是wait动作
+            if (action.isWait()) {
                 break;  // 模型选择等待，停止购买
             }
             
-            bool success = parseAndExecuteAction(0, action);
+            bool success = executeAction(0, action);
             if (success) {
-                team0ActionJson = action;  // 记录最后一次成功的购买
+                team0Action = action;  // 记录最后一次成功的购买
             } else {
                 break;  // 购买失败（能量不足或位置被占），停止购买
             }
         }
-    } else if (team0Type == PlayerType::AI_RULE_BASED) {
+    } else if (team0Type == PlayerType::AI_RULE_BASED || (team0Type == PlayerType::AI_MCTS && !searched[0])) {
         // 规则AI决策 - 循环调用直到无法购买或达到上限
         for (int i = 0; i < MAX_PURCHASES_PER_TURN; ++i) {
-            std::string action = aiControllerTeam0->tryPurchaseOnce(model, this, currentTurn, Team::TEAM_A);
+            Action action = aiControllerTeam0->tryPurchaseOnce(model, this, currentTurn, Team::TEAM_A);
 
             // 检查是否是wait动作
-            if (action.find("\"action_type\": 0") != std::string::npos) {
+            if (action.isWait()) {
                 break;  // 无法购买，停止
             }
 
-            // 调用parseAndExecuteAction扣能量
-            bool success = parseAndExecuteAction(0, action);
+            // 调用executeAction扣能量
+            bool success = executeAction(0, action);
             if (success) {
-                team0ActionJson = action;  // 记录最后一次成功的购买
+                team0Action = action;  // 记录最后一次成功的购买
             } else {
                 break;  // 购买失败，停止购买
             }
         }
+    } else if (team0Type == PlayerType::EXTERNAL) {
+        team0Action = executeExternalAction(0);
+    } else if (team0Type == PlayerType::AI_MCTS) {
+        team0Action = executeSingleAction(0, searchedActions[0]);
     }
-    // HUMAN类型不自动决策，由View层调用purchaseSoldier
+    // HUMAN类型不自动决策，由View层调用requestPurchase
     
     // 4. Team 1 决策（红色 - 主控方：人类/Python AI，允许每回合多次购买）
-    if (team1Type == PlayerType::AI_PYTHON && pythonAgent && pythonAgent->isInitialized()) {
-        // Python AI决策 - 循环调用直到无法购买或达到上限
+    if (hasPolicyAgent(team1Type)) {
+        // 策略网络决策（Python/原生） - 循环调用直到无法购买或达到上限
         for (int i = 0; i < MAX_PURCHASES_PER_TURN; ++i) {
-            std::string currentStateJson = getStateJson(1);
-            std::string action = pythonAgent->getAction(currentStateJson);
+            observe(1, policyState);
+            Action action = getPolicyAction(team1Type, policyState);
             
             // 检查是否是wait动作
-            if (action.find("\"action_type\": 0") != std::string::npos) {
+            if (action.isWait()) {
                 break;  // 模型选择等待，停止购买
             }
             
-            bool success = parseAndExecuteAction(1, action);
+            bool success = executeAction(1, action);
             if (success) {
-                team1ActionJson = action;  // 记录最后一次成功的购买
+                team1Action = action;  // 记录最后一次成功的购买
                 // 训练模式下，只记录第一次购买动作（保持训练数据格式不变）
                 if (i == 0 && trainingLogger && gameMode == GameMode::TRAINING) {
-                    stateJson = currentStateJson;  // 使用第一次购买前的状态
+                    turnState = policyState;  // 使用第一次购买前的状态
                 }
             } else {
                 break;  // 购买失败，停止购买
             }
         }
-    } else if (team1Type == PlayerType::AI_RULE_BASED) {
+    } else if (team1Type == PlayerType::AI_RULE_BASED || (team1Type == PlayerType::AI_MCTS && !searched[1])) {
         // 规则AI决策 - 循环调用直到无法购买或达到上限
         for (int i = 0; i < MAX_PURCHASES_PER_TURN; ++i) {
-            std::string action = aiControllerTeam1->tryPurchaseOnce(model, this, currentTurn, Team::TEAM_B);
+            Action action = aiControllerTeam1->tryPurchaseOnce(model, this, currentTurn, Team::TEAM_B);
 
             // 检查是否是wait动作
-            if (action.find("\"action_type\": 0") != std::string::npos) {
+            if (action.isWait()) {
                 break;  // 无法购买，停止
             }
 
-            // 调用parseAndExecuteAction扣能量
-            bool success = parseAndExecuteAction(1, action);
+            // 调用executeAction扣能量
+            bool success = executeAction(1, action);
             if (success) {
-                team1ActionJson = action;  // 记录最后一次成功的购买
+                team1Action = action;  // 记录最后一次成功的购买
             } else {
                 break;  // 购买失败，停止购买
             }
         }
+    } else if (team1Type == PlayerType::EXTERNAL) {
+        team1Action = executeExternalAction(1);
+    } else if (team1Type == PlayerType::AI_MCTS) {
+        team1Action = executeSingleAction(1, searchedActions[1]);
     }
     
     // 5. 处理所有士兵的行为（移动）
@@ -230,15 +358,13 @@ void GameController::processTurn() {
     
     // 6. 处理战斗，获取治疗统计数据
     std::vector<GameEvent> combatEvents;
-    auto healStats = CombatSystem::processCombat(model, combatEvents, currentTurn);
+    auto healStats = CombatSystem::processCombat(model, combatEvents, currentTurn, verbose);
     team0HealThisTurn = healStats[0];
     team1HealThisTurn = healStats[1];
     
     // 将战斗事件添加到日志中
-    if (trainingLogger && gameMode == GameMode::TRAINING) {
-        for (const auto& evt : combatEvents) {
-            trainingLogger->addEvent(evt);
-        }
+    for (const auto& evt : combatEvents) {
+        recordEvent(evt);
     }
     
     // 7. 清理死亡士兵
@@ -247,15 +373,19 @@ void GameController::processTurn() {
     // 8. 检查游戏是否结束
     checkGameOver();
     
+    if (replayRecorder) {
+        replayRecorder->record(*model, team0Action, team1Action);
+    }
+    
     // 9. 记录训练日志（记录 Team 1 红色的状态和动作）
     if (trainingLogger && gameMode == GameMode::TRAINING) {
-        // stateJson 是 Team 1 的决策前状态
-        trainingLogger->recordTurn(currentTurn, stateJson, team0ActionJson, team1ActionJson);
+        // turnState 是 Team 1 的决策前状态
+        trainingLogger->recordTurn(currentTurn, turnState, team0Action, team1Action);
     }
     
     // 10. 每10回合输出一次状态
     int turn = model->getTurnCount();
-    if (turn % 10 == 0) {
+    if (verbose && turn % 10 == 0) {
         auto currentSoldiers = model->getSoldiers();
         int teamA = 0, teamB = 0;
         for (const auto& s : currentSoldiers) {
@@ -283,6 +413,54 @@ void GameController::processTurn() {
     }
 }
 
+std::unique_ptr<MctsPlanner> GameController::createMctsPlanner() const {
+    // 训练模式没有回合计时：改为固定迭代次数，不让每回合都花满时间预算
+    MctsConfig config = MctsPlanner::defaultConfig();
+    if (gameMode == GameMode::TRAINING) config = MctsPlanner::trainingConfig(config);
+    return std::make_unique<MctsPlanner>(config);
+}
+
+bool GameController::hasPolicyAgent(PlayerType type) const {
+    if (type == PlayerType::AI_PYTHON) {
+        return pythonAgent && pythonAgent->isInitialized();
+    }
+    if (type == PlayerType::AI_NATIVE) {
+        return nativePolicy && nativePolicy->isLoaded();
+    }
+    return false;
+}
+
+Action GameController::getPolicyAction(PlayerType type, const Observation& obs) {
+    if (type == PlayerType::AI_NATIVE) {
+        return nativePolicy->getAction(obs);
+    }
+    stateBuffer.clear();
+    writeObservationJson(obs, stateBuffer);
+    return parseActionJson(pythonAgent->getAction(stateBuffer));
+}
+
+Action GameController::parseActionJson(const std::string& actionJson) {
+    // Python边界：动作JSON -> Action，无法解析或兵种无效时视为等待
+    try {
+        json action = json::parse(actionJson);
+        
+        int actionType = action["action_type"];
+        if (actionType == 0) {
+            return Action::wait();
+        }
+        
+        int baseId = action["base_id"];
+        int unitType = action["unit_type"];
+        if (unitType < 0 || unitType >= SOLDIER_TYPE_COUNT) {
+            return Action::wait();  // 无效的unit_type
+        }
+        return Action::spawn(baseId, static_cast<SoldierType>(unitType));
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to parse action JSON: " << e.what() << std::endl;
+        return Action::wait();
+    }
+}
+
 void GameController::generateEnergy() {
     model->addEnergy(Team::TEAM_A, ENERGY_PER_TURN);
     model->addEnergy(Team::TEAM_B, ENERGY_PER_TURN);
@@ -290,9 +468,21 @@ void GameController::generateEnergy() {
 
 
 
-bool GameController::purchaseSoldier(Team team, SoldierType type, const Position& basePos) {
+bool GameController::requestPurchase(Team team, SoldierType type, const Position& basePos) {
+    std::lock_guard<std::mutex> lock(turnMutex);
+    if (!purchaseSoldier(team, type, basePos)) return false;
+    model->publishRenderSnapshot();  // 新士兵立即显示，不等回合结束
+    return true;
+}
+
+bool GameController::purchaseSoldier(Team team, SoldierType type, const Position& basePos, SoldierId* spawnedId) {
     int cost = CombatSystem::getSoldierCost(type);
     
+    // 士兵数达到上限时不能出兵（出兵位置不足时士兵会叠放在基地格上，地图格子数本身不构成上限）
+    if (model->soldiers.size() >= static_cast<size_t>(MAX_SOLDIERS)) {
+        return false;
+    }
+    
     // 检查并消费能量
     if (!model->spendEnergy(team, cost)) {
         return false;  // 能量不足
@@ -308,7 +498,8 @@ bool GameController::purchaseSoldier(Team team, SoldierType type, const Position
     
     // 创建士兵
     auto soldier = std::make_shared<Soldier>(spawnPos, type, team);
-    model->addSoldier(soldier);
+    SoldierId id = model->addSoldier(soldier);
+    if (spawnedId) *spawnedId = id;
     return true;
 }
 
@@ -355,6 +546,10 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
     if (!soldier->isAlive()) return;
     
     Position currentPos = soldier->getPosition();
+    const SoldierColumns& cols = model->getSoldierColumns();
+    const SpatialHash& spatial = model->getSpatialIndex();
+    Team enemyTeam = (soldier->getTeam() == Team::TEAM_A) ? Team::TEAM_B : Team::TEAM_A;
+    RngStream& moveRng = model->getRng().stream(RngStreamId::MOVEMENT);
     
     // 检测拥堵情况
     int nearbyAllies = aiControllerTeam0->countNearbyAllies(model, soldier, 2);
@@ -363,16 +558,9 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
     
     // 如果极度拥挤且不在战斗中，跳过移动等待疏散
     if (isVeryCrowded) {
-        auto soldiers = model->getSoldiers();
-        bool inCombat = false;
-        for (const auto& enemy : soldiers) {
-            if (!enemy->isAlive() || enemy->getTeam() == soldier->getTeam()) continue;
-            int dist = currentPos.chebyshevDistanceTo(enemy->getPosition());
-            if (dist <= soldier->getAttackRange() + 2) {  // 接近战斗范围
-                inCombat = true;
-                break;
-            }
-        }
+        // 接近战斗范围：攻击范围+2内有敌人
+        bool inCombat = spatial.nearest(currentPos, enemyTeam, DistanceMetric::CHEBYSHEV,
+                                        [](size_t) { return true; }, soldier->getAttackRange() + 2) >= 0;
         if (!inCombat) {
             return;  // 不在战斗中，等待其他士兵先走
         }
@@ -381,15 +569,8 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
     // 弓箭手特殊AI：战术决策
     if (soldier->getType() == SoldierType::ARCHER) {
         // 1. 检查攻击范围内是否有敌人（可以原地攻击）
-        bool hasTargetInRange = false;
-        auto soldiers = model->getSoldiers();
-        for (const auto& target : soldiers) {
-            if (target->isAlive() && target->getTeam() != soldier->getTeam() &&
-                soldier->canAttack(target->getPosition())) {
-                hasTargetInRange = true;
-                break;
-            }
-        }
+        bool hasTargetInRange = spatial.nearest(currentPos, enemyTeam, DistanceMetric::CHEBYSHEV,
+                                                [](size_t) { return true; }, soldier->getAttackRange()) >= 0;
         
         // 如果攻击范围内有敌人，停留原地射击（不移动）
         if (hasTargetInRange) {
@@ -397,25 +578,14 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
         }
         
         // 2. 检查是否有近战敌人靠近（距离<=2格），需要后撤
-        std::shared_ptr<Soldier> nearestMelee = nullptr;
-        int minDistance = 999;
-        for (const auto& enemy : soldiers) {
-            if (!enemy->isAlive() || enemy->getTeam() == soldier->getTeam()) continue;
-            
-            // 判断是否是近战单位（攻击范围<=1）
-            if (enemy->getAttackRange() <= 1) {
-                int dist = abs(enemy->getPosition().x - currentPos.x) + 
-                          abs(enemy->getPosition().y - currentPos.y);
-                if (dist <= 2 && dist < minDistance) {
-                    minDistance = dist;
-                    nearestMelee = enemy;
-                }
-            }
-        }
+        // 判断是否是近战单位（攻击范围<=1）
+        int nearestMelee = spatial.nearest(currentPos, enemyTeam, DistanceMetric::MANHATTAN, [&](size_t i) {
+            return cols.statsAt(i).attackRange <= 1;
+        }, 2);
         
         // 如果有近战单位接近，后撤（远离近战敌人）
-        if (nearestMelee) {
-            Position enemyPos = nearestMelee->getPosition();
+        if (nearestMelee >= 0) {
+            Position enemyPos = cols.positionAt(nearestMelee);
             std::vector<Position> retreatCandidates = aiControllerTeam0->getRetreatPositions(currentPos, enemyPos);
             
             for (const auto& newPos : retreatCandidates) {
@@ -462,7 +632,7 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
         }
         
         // AI决策：获取移动候选位置列表
-        std::vector<Position> candidates = aiControllerTeam0->getMoveCandidates(model, soldier);
+        std::vector<Position> candidates = aiControllerTeam0->getMoveCandidates(model, soldier, moveRng);
         
         // 如果返回空列表，表示AI建议不移动（当前位置更好）
         if (candidates.empty()) {
@@ -494,7 +664,7 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
             Position(currentPos.x - 1, currentPos.y - 1)
         };
         
-        std::shuffle(neighbors.begin(), neighbors.end(), rng);
+        std::shuffle(neighbors.begin(), neighbors.end(), moveRng);
         
         for (const auto& pos : neighbors) {
             if (model->getMap()->isWalkable(pos) && !aiControllerTeam0->isPositionOccupied(model, pos, soldier)) {
@@ -514,7 +684,7 @@ void GameController::processSoldierBehavior(std::shared_ptr<Soldier> soldier) {
                     }
                 }
             }
-            std::shuffle(farPositions.begin(), farPositions.end(), rng);
+            std::shuffle(farPositions.begin(), farPositions.end(), moveRng);
             
             for (const auto& pos : farPositions) {
                 if (model->getMap()->isWalkable(pos) && !aiControllerTeam0->isPositionOccupied(model, pos, soldier)) {
@@ -534,15 +704,15 @@ void GameController::cleanupDeadSoldiers() {
     auto soldiers = model->getSoldiers();
     
     // 收集死亡士兵
-    std::vector<std::shared_ptr<Soldier>> deadSoldiers;
+    std::vector<SoldierId> deadSoldiers;
     for (const auto& soldier : soldiers) {
         if (!soldier->isAlive()) {
-            deadSoldiers.push_back(soldier);
+            deadSoldiers.push_back(soldier->getId());
         }
     }
     
-    // 删除死亡士兵
-    for (const auto& dead : deadSoldiers) {
+    // 删除死亡士兵（按ID，O(1)）
+    for (SoldierId dead : deadSoldiers) {
         model->removeSoldier(dead);
     }
 }
@@ -562,14 +732,16 @@ void GameController::checkGameOver() {
         // 血量多的一方获胜，相同则Team B获胜
         if (teamAHp > teamBHp) {
             model->setGameOver(Team::TEAM_A);
-            if (trainingLogger) trainingLogger->addEvent(GameEvent(EventType::GAME_OVER, 0, currentTurn, "Time Limit Reached - Team A Wins"));
+            recordEvent(GameEvent(EventType::GAME_OVER, 0, currentTurn, "Time Limit Reached - Team A Wins"));
         } else {
             model->setGameOver(Team::TEAM_B);
-            if (trainingLogger) trainingLogger->addEvent(GameEvent(EventType::GAME_OVER, 1, currentTurn, "Time Limit Reached - Team B Wins"));
+            recordEvent(GameEvent(EventType::GAME_OVER, 1, currentTurn, "Time Limit Reached - Team B Wins"));
         }
         
-        std::cout << "Game ended: MAX_TURNS reached (" << MAX_TURNS << "). "
-                  << "Team A HP=" << teamAHp << ", Team B HP=" << teamBHp << std::endl;
+        if (verbose) {
+            std::cout << "Game ended: MAX_TURNS reached (" << MAX_TURNS << "). "
+                      << "Team A HP=" << teamAHp << ", Team B HP=" << teamBHp << std::endl;
+        }
         return;
     }
     
@@ -593,197 +765,118 @@ void GameController::checkGameOver() {
     
     if (!teamAAlive) {
         model->setGameOver(Team::TEAM_B);
-        if (trainingLogger) trainingLogger->addEvent(GameEvent(EventType::GAME_OVER, 1, currentTurn, "Domination - Team B Wins"));
+        recordEvent(GameEvent(EventType::GAME_OVER, 1, currentTurn, "Domination - Team B Wins"));
     } else if (!teamBAlive) {
         model->setGameOver(Team::TEAM_A);
-        if (trainingLogger) trainingLogger->addEvent(GameEvent(EventType::GAME_OVER, 0, currentTurn, "Domination - Team A Wins"));
+        recordEvent(GameEvent(EventType::GAME_OVER, 0, currentTurn, "Domination - Team A Wins"));
     }
 }
 
 // ==================== 新增：AI相关功能实现 ====================
 
-std::string GameController::getStateJson(int myTeam) {
-    json state;
+void GameController::observe(int myTeam, Observation& obs) {
+    obs = Observation();
     
-    // 基础特征（8维）
-    state["turn"] = currentTurn;
-    state["my_team"] = myTeam;
+    // 基础特征
+    obs.turn = currentTurn;
+    obs.myTeam = myTeam;
     // 修复：使用正确的能量值（从 Model::getEnergy 获取，而不是 teams[].energy）
-    state["my_energy"] = model->getEnergy(myTeam == 0 ? Team::TEAM_A : Team::TEAM_B);
-    state["enemy_energy"] = model->getEnergy(myTeam == 0 ? Team::TEAM_B : Team::TEAM_A);
-    
-    // 统计基地HP和数量
-    int myTotalBaseHP = 0, enemyTotalBaseHP = 0;
-    int myBaseCount = 0, enemyBaseCount = 0;
-    for (const auto& base : model->bases) {
-        if (static_cast<int>(base->getTeam()) == myTeam) {
-            myTotalBaseHP += base->getHp();
-            myBaseCount++;
-        } else {
-            enemyTotalBaseHP += base->getHp();
-            enemyBaseCount++;
-        }
-    }
-    state["my_total_base_hp"] = myTotalBaseHP;
-    state["enemy_total_base_hp"] = enemyTotalBaseHP;
-    state["my_base_count"] = myBaseCount;
-    state["enemy_base_count"] = enemyBaseCount;
+    obs.myEnergy = model->getEnergy(myTeam == 0 ? Team::TEAM_A : Team::TEAM_B);
+    obs.enemyEnergy = model->getEnergy(myTeam == 0 ? Team::TEAM_B : Team::TEAM_A);
     
     // 治疗量统计（本回合）
-    state["my_heal_done"] = (myTeam == 0) ? team0HealThisTurn : team1HealThisTurn;
-    state["enemy_heal_done"] = (myTeam == 0) ? team1HealThisTurn : team0HealThisTurn;
-    
-    // 统计士兵数量
-    int mySoldierCount = 0, enemySoldierCount = 0;
-    for (const auto& soldier : model->soldiers) {
-        if (static_cast<int>(soldier->getTeam()) == myTeam) {
-            mySoldierCount++;
-        } else {
-            enemySoldierCount++;
-        }
-    }
-    state["my_soldier_count"] = mySoldierCount;
-    state["enemy_soldier_count"] = enemySoldierCount;
-    
-    // 我方基地（最多5个，按HP降序）
-    state["my_bases"] = json::array();
-    std::vector<std::shared_ptr<Base>> myBases;
-    for (const auto& base : model->bases) {
-        if (static_cast<int>(base->getTeam()) == myTeam) {
-            myBases.push_back(base);
-        }
-    }
-    std::sort(myBases.begin(), myBases.end(),
-              [](const auto& a, const auto& b) { return a->getHp() > b->getHp(); });
-    
-    for (size_t i = 0; i < std::min(myBases.size(), size_t(5)); i++) {
-        int nearbyAllies = 0, nearbyEnemies = 0;
-        countNearbySoldiers(myBases[i]->getPosition(), nearbyAllies, nearbyEnemies, myTeam);
-        
-        state["my_bases"].push_back({
-            {"hp", myBases[i]->getHp()},
-            {"max_hp", myBases[i]->getMaxHp()},
-            {"x", myBases[i]->getPosition().x},
-            {"y", myBases[i]->getPosition().y},
-            {"nearby_allies", nearbyAllies},
-            {"nearby_enemies", nearbyEnemies}
-        });
-    }
-    
-    // 敌方基地（最多5个）
-    state["enemy_bases"] = json::array();
-    std::vector<std::shared_ptr<Base>> enemyBases;
-    for (const auto& base : model->bases) {
-        if (static_cast<int>(base->getTeam()) != myTeam) {
-            enemyBases.push_back(base);
-        }
-    }
-    std::sort(enemyBases.begin(), enemyBases.end(),
-              [](const auto& a, const auto& b) { return a->getHp() > b->getHp(); });
-    
-    for (size_t i = 0; i < std::min(enemyBases.size(), size_t(5)); i++) {
-        int distance = getDistanceToNearestBase(enemyBases[i]->getPosition(), myTeam);
-        
-        state["enemy_bases"].push_back({
-            {"hp", enemyBases[i]->getHp()},
-            {"max_hp", enemyBases[i]->getMaxHp()},
-            {"x", enemyBases[i]->getPosition().x},
-            {"y", enemyBases[i]->getPosition().y},
-            {"distance_to_nearest_my_base", distance}
-        });
-    }
-    
-    // 士兵类型统计
-    int myArcher = 0, myInfantry = 0, myCavalry = 0, myCaster = 0, myDoctor = 0;
-    int enemyArcher = 0, enemyInfantry = 0, enemyCavalry = 0, enemyCaster = 0, enemyDoctor = 0;
-    float myAvgX = 0, myAvgY = 0, enemyAvgX = 0, enemyAvgY = 0;
-    int myFrontCount = 0, enemyFrontCount = 0;
-    
-    for (const auto& soldier : model->soldiers) {
-        bool isMy = (static_cast<int>(soldier->getTeam()) == myTeam);
-        
-        // 统计兵种
-        if (isMy) {
-            switch (soldier->getType()) {
-                case SoldierType::ARCHER: myArcher++; break;
-                case SoldierType::INFANTRY: myInfantry++; break;
-                case SoldierType::CAVALRY: myCavalry++; break;
-                case SoldierType::CASTER: myCaster++; break;
-                case SoldierType::DOCTOR: myDoctor++; break;
-            }
-            myAvgX += soldier->getPosition().x;
-            myAvgY += soldier->getPosition().y;
-            if (soldier->getPosition().y > 10) myFrontCount++;
+    obs.myHealDone = (myTeam == 0) ? team0HealThisTurn : team1HealThisTurn;
+    obs.enemyHealDone = (myTeam == 0) ? team1HealThisTurn : team0HealThisTurn;
+    
+    // 基地：统计HP和数量，并按HP降序排列（同HP时保持基地列表中的顺序），观测只取前 MAX_BASES 个
+    const auto& myTeamBases = (myTeam == 0) ? model->getBasesTeamA() : model->getBasesTeamB();
+    const auto& enemyTeamBases = (myTeam == 0) ? model->getBasesTeamB() : model->getBasesTeamA();
+    using SortedBases = std::array<const Base*, BASE_COUNT_PER_TEAM>;
+    auto collectBases = [](const std::vector<std::unique_ptr<Base>>& teamBases, SortedBases& sorted,
+                           int& totalHp, int& count) {
+        for (const auto& base : teamBases) {
+            totalHp += base->getHp();
+            count++;
+        }
+        size_t stored = std::min(teamBases.size(), sorted.size());
+        for (size_t i = 0; i < stored; i++) {
+            sorted[i] = teamBases[i].get();
+        }
+        std::stable_sort(sorted.begin(), sorted.begin() + stored,
+                         [](const Base* a, const Base* b) { return a->getHp() > b->getHp(); });
+        return static_cast<int>(stored);
+    };
+    SortedBases myBases;
+    SortedBases enemyBases;
+    int myStored = collectBases(myTeamBases, myBases, obs.myTotalBaseHp, obs.myBaseCount);
+    int enemyStored = collectBases(enemyTeamBases, enemyBases, obs.enemyTotalBaseHp, obs.enemyBaseCount);
+    
+    obs.myBaseEntries = std::min(myStored, Observation::MAX_BASES);
+    for (int i = 0; i < obs.myBaseEntries; i++) {
+        BaseObservation& entry = obs.myBases[i];
+        entry.hp = myBases[i]->getHp();
+        entry.maxHp = myBases[i]->getMaxHp();
+        entry.x = myBases[i]->getPosition().x;
+        entry.y = myBases[i]->getPosition().y;
+        countNearbySoldiers(myBases[i]->getPosition(), entry.nearbyAllies, entry.nearbyEnemies, myTeam);
+    }
+    
+    obs.enemyBaseEntries = std::min(enemyStored, Observation::MAX_BASES);
+    for (int i = 0; i < obs.enemyBaseEntries; i++) {
+        BaseObservation& entry = obs.enemyBases[i];
+        entry.hp = enemyBases[i]->getHp();
+        entry.maxHp = enemyBases[i]->getMaxHp();
+        entry.x = enemyBases[i]->getPosition().x;
+        entry.y = enemyBases[i]->getPosition().y;
+        entry.distanceToNearestMyBase = getDistanceToNearestBase(enemyBases[i]->getPosition(), myTeam);
+    }
+    
+    // 士兵：一次遍历组件存储，统计数量、兵种和分布（与 soldiers 同序，求和顺序不变）
+    const SoldierColumns& cols = model->getSoldierColumns();
+    for (size_t i = 0; i < cols.size(); i++) {
+        int type = cols.type[i];
+        int x = cols.x[i];
+        int y = cols.y[i];
+        if (cols.team[i] == myTeam) {
+            obs.mySoldierCount++;
+            obs.myTypeCounts[type]++;
+            obs.myAvgX += x;
+            obs.myAvgY += y;
+            if (y > 10) obs.myFrontCount++;
         } else {
-            switch (soldier->getType()) {
-                case SoldierType::ARCHER: enemyArcher++; break;
-                case SoldierType::INFANTRY: enemyInfantry++; break;
-                case SoldierType::CAVALRY: enemyCavalry++; break;
-                case SoldierType::CASTER: enemyCaster++; break;
-                case SoldierType::DOCTOR: enemyDoctor++; break;
-            }
-            enemyAvgX += soldier->getPosition().x;
-            enemyAvgY += soldier->getPosition().y;
-            if (soldier->getPosition().y < 10) enemyFrontCount++;
+            obs.enemySoldierCount++;
+            obs.enemyTypeCounts[type]++;
+            obs.enemyAvgX += x;
+            obs.enemyAvgY += y;
+            if (y < 10) obs.enemyFrontCount++;
         }
     }
     
     // 计算平均位置
-    if (mySoldierCount > 0) {
-        myAvgX /= mySoldierCount;
-        myAvgY /= mySoldierCount;
+    if (obs.mySoldierCount > 0) {
+        obs.myAvgX /= obs.mySoldierCount;
+        obs.myAvgY /= obs.mySoldierCount;
     }
-    if (enemySoldierCount > 0) {
-        enemyAvgX /= enemySoldierCount;
-        enemyAvgY /= enemySoldierCount;
+    if (obs.enemySoldierCount > 0) {
+        obs.enemyAvgX /= obs.enemySoldierCount;
+        obs.enemyAvgY /= obs.enemySoldierCount;
     }
     
-    state["my_soldier_types"] = {
-        {"archer_count", myArcher},
-        {"infantry_count", myInfantry},
-        {"cavalry_count", myCavalry},
-        {"caster_count", myCaster},
-        {"doctor_count", myDoctor}
-    };
-    
-    state["enemy_soldier_types"] = {
-        {"archer_count", enemyArcher},
-        {"infantry_count", enemyInfantry},
-        {"cavalry_count", enemyCavalry},
-        {"caster_count", enemyCaster},
-        {"doctor_count", enemyDoctor}
-    };
-    
-    state["soldier_distribution"] = {
-        {"my_avg_x", myAvgX},
-        {"my_avg_y", myAvgY},
-        {"enemy_avg_x", enemyAvgX},
-        {"enemy_avg_y", enemyAvgY},
-        {"my_front_soldier_count", myFrontCount},
-        {"enemy_front_soldier_count", enemyFrontCount}
-    };
-    
     // 游戏状态
-    state["game_over"] = model->isGameOver();
-    state["winner"] = model->isGameOver() ? static_cast<int>(model->getWinner()) : -1;
-    
-    return state.dump();
+    obs.gameOver = model->isGameOver();
+    obs.winner = obs.gameOver ? static_cast<int>(model->getWinner()) : -1;
 }
 
 void GameController::countNearbySoldiers(const Position& basePos, int& allies, int& enemies, int team) {
     allies = 0;
     enemies = 0;
     
-    for (const auto& soldier : model->soldiers) {
-        int dist = basePos.distanceTo(soldier->getPosition());
-        if (dist <= 3) {  // 半径3格
-            if (static_cast<int>(soldier->getTeam()) == team) {
-                allies++;
-            } else {
-                enemies++;
-            }
-        }
-    }
+    // 半径3格
+    Team myTeam = static_cast<Team>(team);
+    Team enemyTeam = (myTeam == Team::TEAM_A) ? Team::TEAM_B : Team::TEAM_A;
+    const SpatialHash& spatial = model->getSpatialIndex();
+    spatial.forEachInRadius(basePos, 3, myTeam, DistanceMetric::MANHATTAN, [&](size_t) { allies++; });
+    spatial.forEachInRadius(basePos, 3, enemyTeam, DistanceMetric::MANHATTAN, [&](size_t) { enemies++; });
 }
 
 int GameController::getDistanceToNearestBase(const Position& pos, int team) {
@@ -799,78 +892,75 @@ int GameController::getDistanceToNearestBase(const Position& pos, int team) {
     return minDist;
 }
 
-bool GameController::parseAndExecuteAction(int team, const std::string& actionJson) {
-    try {
-        json action = json::parse(actionJson);
-        
-        int actionType = action["action_type"];
-        
-        // action_type = 0: wait
-        if (actionType == 0) {
-            return true;
-        }
-        
-        // action_type = 1: spawn
-        int baseId = action["base_id"];
-        int unitType = action["unit_type"];
+bool GameController::executeAction(int team, const Action& action) {
+    // action_type = 0: wait
+    if (action.isWait()) {
+        return true;
+    }
+    
+    // action_type = 1: spawn
+    int baseId = action.baseId;
+    SoldierType soldierType = action.unit;
+
+    // 获取该队伍的基地列表
+    const auto& teamBases = (team == 0) ? model->getBasesTeamA() : model->getBasesTeamB();
 
-        // 获取该队伍的基地列表
-        std::vector<std::shared_ptr<Base>> teamBases;
-        for (const auto& base : model->bases) {
-            if (static_cast<int>(base->getTeam()) == team) {
-                teamBases.push_back(base);
+    // [修复] 检查baseId对应基地是否被摧毁，如果被摧毁则随机选择存活基地
+    if (baseId < 0 || baseId >= static_cast<int>(teamBases.size()) || !teamBases[baseId]->isAlive()) {
+        std::vector<size_t> aliveBases;
+        for (size_t i = 0; i < teamBases.size(); i++) {
+            if (teamBases[i]->isAlive()) {
+                aliveBases.push_back(i);
             }
         }
 
-        // [修复] 检查baseId对应基地是否被摧毁，如果被摧毁则随机选择存活基地
-        if (baseId < 0 || baseId >= static_cast<int>(teamBases.size()) || !teamBases[baseId]->isAlive()) {
-            std::vector<size_t> aliveBases;
-            for (size_t i = 0; i < teamBases.size(); i++) {
-                if (teamBases[i]->isAlive()) {
-                    aliveBases.push_back(i);
-                }
-            }
+        if (aliveBases.empty()) {
+            // 所有基地都被摧毁了，不能出兵
+            return true;
+        }
 
-            if (aliveBases.empty()) {
-                // 所有基地都被摧毁了，不能出兵
-                return true;
-            }
+        // 随机选择一个存活基地
+        std::uniform_int_distribution<> dis(0, aliveBases.size() - 1);
+        baseId = aliveBases[dis(model->getRng().stream(RngStreamId::MOVEMENT))];
+    }
+    
+    // 执行购买
+    Position basePos = teamBases[baseId]->getPosition();
+    SoldierId spawnedId = INVALID_SOLDIER_ID;
+    bool success = purchaseSoldier(static_cast<Team>(team), soldierType, basePos, &spawnedId);
+    
+    // 记录生成事件
+    if (success) {
+        std::string typeName = CombatSystem::getSoldierTypeName(soldierType);
+        GameEvent spawnEvent(EventType::SPAWN, team, currentTurn, "Spawn " + typeName);
+        spawnEvent.soldier_id = spawnedId;
+        spawnEvent.base_id = baseId;  // 记录从哪个基地生成（方便计算奖励）
+        recordEvent(spawnEvent);
+    }
+    
+    return success;
+}
 
-            // 随机选择一个存活基地
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<> dis(0, aliveBases.size() - 1);
-            baseId = aliveBases[dis(gen)];
-        }
-        
-        // 转换unitType为SoldierType（支持全部5种兵）
-        SoldierType soldierType;
-        switch (unitType) {
-            case 0: soldierType = SoldierType::ARCHER; break;
-            case 1: soldierType = SoldierType::INFANTRY; break;
-            case 2: soldierType = SoldierType::CAVALRY; break;
-            case 3: soldierType = SoldierType::CASTER; break;   // 支持法师
-            case 4: soldierType = SoldierType::DOCTOR; break;   // 支持医疗兵
-            default: return false;  // 无效的unit_type
-        }
-        
-        // 执行购买
-        Position basePos = teamBases[baseId]->getPosition();
-        bool success = purchaseSoldier(static_cast<Team>(team), soldierType, basePos);
-        
-        // 记录生成事件
-        if (success && trainingLogger && gameMode == GameMode::TRAINING) {
-            std::string typeName = CombatSystem::getSoldierTypeName(soldierType);
-            GameEvent spawnEvent(EventType::SPAWN, team, currentTurn, "Spawn " + typeName);
-            spawnEvent.soldier_id = baseId; // 在这里临时借用soldier_id存一下是从哪个基地生成的（方便计算奖励）
-            trainingLogger->addEvent(spawnEvent);
-        }
-        
-        return success;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to parse action JSON: " << e.what() << std::endl;
-        return false;
+Action GameController::executeExternalAction(int team) {
+    // 外部动作只执行一次（每回合最多购买一个兵），之后回到等待
+    Action action = externalActions[team];
+    externalActions[team] = Action::wait();
+    return executeSingleAction(team, action);
+}
+
+Action GameController::executeSingleAction(int team, const Action& action) {
+    if (action.isWait() || !executeAction(team, action)) {
+        return Action::wait();
+    }
+    return action;
+}
+
+void GameController::recordEvent(const GameEvent& event) {
+    if (team0Type == PlayerType::EXTERNAL || team1Type == PlayerType::EXTERNAL) {
+        turnEvents.push_back(event);
+    }
+    if (trainingLogger && gameMode == GameMode::TRAINING) {
+        trainingLogger->addEvent(event);
     }
 }
 
@@ -887,6 +977,17 @@ void GameController::setGameMode(GameMode mode, PlayerType team0, PlayerType tea
         pythonAgent->initialize("python/infer.py");
     }
     
+    if (team0Type == PlayerType::AI_NATIVE || team1Type == PlayerType::AI_NATIVE) {
+        if (!nativePolicy) {
+            nativePolicy = std::make_unique<NativePolicy>();
+        }
+        nativePolicy->load("python/policy_model.bin");
+    }
+    
+    if ((team0Type == PlayerType::AI_MCTS || team1Type == PlayerType::AI_MCTS) && !mctsPlanner) {
+        mctsPlanner = createMctsPlanner();
+    }
+    
     if (gameMode == GameMode::TRAINING) {
         trainingLogger = std::make_unique<TrainingLogger>();
         trainingLogger->startGame(gameMode, team0Type, team1Type);
@@ -0,0 +1,152 @@
+// DatasetWriter.cpp - 二进制列式训练数据集写入
+#include "../include/DatasetWriter.h"
+#include "../include/FeatureEncoder.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <unistd.h>
+
+static size_t alignUp(size_t n, size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+DatasetWriter::DatasetWriter(const std::string& directory, size_t shardRows)
+    : directory(directory), shardRows(shardRows), shardSequence(0), droppedRows(0) {
+    auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm localTime{};
+    localtime_r(&time, &localTime);
+    std::stringstream ss;
+    ss << directory << "/shard-" << std::put_time(&localTime, "%Y%m%d-%H%M%S") << "-" << ::getpid() << "-";
+    shardPrefix = ss.str();
+}
+
+DatasetWriter::~DatasetWriter() {
+    flush();
+    if (droppedRows > 0) {
+        std::cerr << "Dataset writer dropped " << droppedRows << " rows in shards that could not be written" << std::endl;
+    }
+}
+
+void DatasetWriter::appendGame(const DatasetGame& game) {
+    size_t rows = game.rows();
+    if (rows == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    gameStarts.push_back(pending.rows());
+    gameRows.push_back(static_cast<uint32_t>(rows));
+    gameWinners.push_back(game.winner);
+    pending.features.insert(pending.features.end(), game.features.begin(), game.features.end());
+    pending.actions.insert(pending.actions.end(), game.actions.begin(), game.actions.end());
+    pending.rewards.insert(pending.rewards.end(), game.rewards.begin(), game.rewards.end());
+
+    if (pending.rows() >= shardRows) {
+        writeShard();
+    }
+}
+
+void DatasetWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    writeShard();
+}
+
+void DatasetWriter::writeShard() {
+    uint64_t rowCount = pending.rows();
+    if (rowCount == 0) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    // 各列的偏移（64字节对齐）
+    uint64_t featuresOffset = HEADER_SIZE;
+    uint64_t actionsOffset = alignUp(featuresOffset + pending.features.size() * sizeof(float), COLUMN_ALIGNMENT);
+    uint64_t rewardsOffset = alignUp(actionsOffset + pending.actions.size(), COLUMN_ALIGNMENT);
+    uint64_t gamesOffset = alignUp(rewardsOffset + pending.rewards.size() * sizeof(float), COLUMN_ALIGNMENT);
+
+    // 序号只在分片成功写出后递增，文件名保持连续
+    std::string filename = shardPrefix + std::to_string(shardSequence) + ".dsds";
+    std::string tempFilename = filename + ".tmp";
+    std::ofstream out(tempFilename, std::ios::binary);
+    if (!out.is_open()) {
+        dropShard("Failed to create dataset shard " + tempFilename);
+        return;
+    }
+
+    auto writeRaw = [&](const void* data, size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    auto padTo = [&](uint64_t offset) {
+        static const char zeros[COLUMN_ALIGNMENT] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        if (offset > position) writeRaw(zeros, offset - position);
+    };
+
+    // 文件头
+    uint32_t featureDim = FeatureEncoder::FEATURE_DIM;
+    uint32_t featureVersion = FeatureEncoder::VERSION;
+    uint32_t gameCount = static_cast<uint32_t>(gameStarts.size());
+    uint32_t reserved = 0;
+    writeRaw(MAGIC, sizeof(MAGIC));
+    writeRaw(&VERSION, sizeof(VERSION));
+    writeRaw(&featureDim, sizeof(featureDim));
+    writeRaw(&gameCount, sizeof(gameCount));
+    writeRaw(&rowCount, sizeof(rowCount));
+    writeRaw(&featuresOffset, sizeof(featuresOffset));
+    writeRaw(&actionsOffset, sizeof(actionsOffset));
+    writeRaw(&rewardsOffset, sizeof(rewardsOffset));
+    writeRaw(&gamesOffset, sizeof(gamesOffset));
+    writeRaw(&featureVersion, sizeof(featureVersion));
+    writeRaw(&reserved, sizeof(reserved));
+
+    // 列数据
+    padTo(featuresOffset);
+    writeRaw(pending.features.data(), pending.features.size() * sizeof(float));
+    padTo(actionsOffset);
+    writeRaw(pending.actions.data(), pending.actions.size());
+    padTo(rewardsOffset);
+    writeRaw(pending.rewards.data(), pending.rewards.size() * sizeof(float));
+    padTo(gamesOffset);
+    for (size_t i = 0; i < gameStarts.size(); i++) {
+        writeRaw(&gameStarts[i], sizeof(uint64_t));
+        writeRaw(&gameRows[i], sizeof(uint32_t));
+        writeRaw(&gameWinners[i], sizeof(int32_t));
+    }
+
+    out.close();
+    if (!out) {
+        std::remove(tempFilename.c_str());
+        dropShard("Failed to write dataset shard " + tempFilename);
+        return;
+    }
+    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+        std::remove(tempFilename.c_str());
+        dropShard("Failed to rename dataset shard to " + filename);
+        return;
+    }
+
+    shardSequence++;
+    std::cout << "Dataset shard written: " << filename << " (" << gameCount << " games, "
+              << rowCount << " rows)" << std::endl;
+    clearPending();
+}
+
+void DatasetWriter::dropShard(const std::string& message) {
+    // 丢弃写失败的分片：保留它会让 pending 无限增长，之后每局都重试一次整片写入
+    // 只报告第一次失败（之后通常是同样的原因，例如磁盘已满），析构时汇总丢弃的行数
+    if (droppedRows == 0) {
+        std::cerr << message << "; dropping " << pending.rows() << " rows (later failures are not reported)" << std::endl;
+    }
+    droppedRows += pending.rows();
+    clearPending();
+}
+
+void DatasetWriter::clearPending() {
+    pending.clear();
+    gameStarts.clear();
+    gameRows.clear();
+    gameWinners.clear();
+}
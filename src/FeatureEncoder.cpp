@@ -0,0 +1,214 @@
+// FeatureEncoder.cpp - 79维状态特征编码
+#include "../include/FeatureEncoder.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+
+using json = nlohmann::json;
+
+// 从已解析的状态JSON提取特征
+static void encodeState(const json& state, float* features);
+
+void FeatureEncoder::encode(const Observation& obs, float* features) {
+    // 与 parse_state_to_features 相同：先按 double 归一化，再转成 float
+    int index = 0;
+    auto push = [&](double value) { features[index++] = static_cast<float>(value); };
+
+    // 1. 能量 (2)
+    push(obs.myEnergy / 1000.0);
+    push(obs.enemyEnergy / 1000.0);
+
+    // 2. 基地总HP (2)
+    push(obs.myTotalBaseHp / 50000.0);
+    push(obs.enemyTotalBaseHp / 50000.0);
+
+    // 3. 士兵总数 (2)
+    push(obs.mySoldierCount / 100.0);
+    push(obs.enemySoldierCount / 100.0);
+
+    // 4-5. 双方各兵种数量 (5 + 5)，顺序为 archer, infantry, cavalry, caster, doctor
+    static const SoldierType TYPE_ORDER[5] = {
+        SoldierType::ARCHER, SoldierType::INFANTRY, SoldierType::CAVALRY, SoldierType::CASTER, SoldierType::DOCTOR
+    };
+    for (SoldierType type : TYPE_ORDER) push(obs.myTypeCounts[static_cast<int>(type)] / 20.0);
+    for (SoldierType type : TYPE_ORDER) push(obs.enemyTypeCounts[static_cast<int>(type)] / 20.0);
+
+    // 6. 我方基地 (3 * 7)，没有距离字段时取默认值 64
+    for (int i = 0; i < 3; i++) {
+        if (i >= obs.myBaseEntries) {
+            for (int k = 0; k < 7; k++) push(0.0);
+            continue;
+        }
+        const BaseObservation& base = obs.myBases[i];
+        push(base.hp / 15000.0);
+        push(base.x / 64.0);
+        push(base.y / 64.0);
+        push(base.nearbyAllies / 20.0);
+        push(base.nearbyEnemies / 20.0);
+        push(base.nearbyEnemies > 0 ? 1.0 : 0.0);
+        push(64 / 64.0);
+    }
+
+    // 7. 敌方基地 (3 * 7)，没有附近士兵字段
+    for (int i = 0; i < 3; i++) {
+        if (i >= obs.enemyBaseEntries) {
+            for (int k = 0; k < 7; k++) push(0.0);
+            continue;
+        }
+        const BaseObservation& base = obs.enemyBases[i];
+        push(base.hp / 15000.0);
+        push(base.x / 64.0);
+        push(base.y / 64.0);
+        push(0.0);
+        push(0.0);
+        push(0.0);
+        push(base.distanceToNearestMyBase / 64.0);
+    }
+
+    // 8. 战场分布 (6)：状态里有 front 计数，没有 mid/back 计数
+    push(obs.myFrontCount / 20.0);
+    push(0.0);
+    push(0.0);
+    push(obs.enemyFrontCount / 20.0);
+    push(0.0);
+    push(0.0);
+
+    // 9. 治疗量 (2)
+    push(obs.myHealDone / 100.0);
+    push(obs.enemyHealDone / 100.0);
+
+    // 10. 游戏状态 (1)
+    push(obs.gameOver ? 1.0 : 0.0);
+
+    // 补充到 79 维
+    while (index < FEATURE_DIM) {
+        features[index++] = 0.0f;
+    }
+}
+
+bool FeatureEncoder::encodeJson(const char* stateJson, size_t length, float* features) {
+    json state = json::parse(stateJson, stateJson + length, nullptr, false);
+    if (state.is_discarded() || !state.is_object()) {
+        std::fill(features, features + FEATURE_DIM, 0.0f);
+        return false;
+    }
+    encodeState(state, features);
+    return true;
+}
+
+int64_t FeatureEncoder::encodeGameJson(const char* gameJson, size_t length, float* features, int64_t capacity) {
+    json game = json::parse(gameJson, gameJson + length, nullptr, false);
+    if (game.is_discarded() || !game.is_object()) return -1;
+    auto episodes = game.find("episodes");
+    if (episodes == game.end() || !episodes->is_array()) return -1;
+
+    static const json emptyState = json::object();
+    int64_t rows = static_cast<int64_t>(episodes->size());
+    for (int64_t row = 0; row < std::min(rows, capacity); row++) {
+        const json& episode = (*episodes)[static_cast<size_t>(row)];
+        auto state = episode.find("state");
+        bool valid = state != episode.end() && state->is_object();
+        encodeState(valid ? *state : emptyState, features + row * FEATURE_DIM);
+    }
+    return rows;
+}
+
+static void encodeState(const json& state, float* features) {
+    constexpr int FEATURE_DIM = FeatureEncoder::FEATURE_DIM;
+    int index = 0;
+    auto push = [&](double value) {
+        if (index < FEATURE_DIM) features[index++] = static_cast<float>(value);
+    };
+    // 布尔值按 0/1 处理（与 Python 中 bool 是 int 的子类一致）
+    auto number = [](const json& obj, const char* key, double fallback) {
+        auto it = obj.find(key);
+        if (it == obj.end()) return fallback;
+        if (it->is_boolean()) return it->get<bool>() ? 1.0 : 0.0;
+        return it->is_number() ? it->get<double>() : fallback;
+    };
+    const json empty = json::object();
+    auto object = [&](const char* key) -> const json& {
+        auto it = state.find(key);
+        return (it != state.end() && it->is_object()) ? *it : empty;
+    };
+
+    // 1. 能量 (2)
+    push(number(state, "my_energy", 0) / 1000.0);
+    push(number(state, "enemy_energy", 0) / 1000.0);
+
+    // 2. 基地总HP (2)
+    push(number(state, "my_total_base_hp", 0) / 50000.0);
+    push(number(state, "enemy_total_base_hp", 0) / 50000.0);
+
+    // 3. 士兵总数 (2)
+    push(number(state, "my_soldier_count", 0) / 100.0);
+    push(number(state, "enemy_soldier_count", 0) / 100.0);
+
+    // 4-5. 双方各兵种数量 (5 + 5)
+    static const char* TYPE_KEYS[5] = {"archer_count", "infantry_count", "cavalry_count", "caster_count", "doctor_count"};
+    for (const char* group : {"my_soldier_types", "enemy_soldier_types"}) {
+        const json& types = object(group);
+        for (const char* key : TYPE_KEYS) {
+            push(number(types, key, 0) / 20.0);
+        }
+    }
+
+    // 6-7. 双方基地信息 (3 * 7 + 3 * 7)
+    for (const char* group : {"my_bases", "enemy_bases"}) {
+        bool mine = (std::strcmp(group, "my_bases") == 0);
+        auto it = state.find(group);
+        size_t count = (it != state.end() && it->is_array()) ? it->size() : 0;
+        for (size_t i = 0; i < 3; i++) {
+            if (i >= count) {
+                for (int k = 0; k < 7; k++) push(0.0);
+                continue;
+            }
+            const json& base = (*it)[i];
+            double nearbyEnemies = number(base, "nearby_enemies", 0);
+            push(number(base, "hp", 0) / 15000.0);
+            push(number(base, "position_x", number(base, "x", 32)) / 64.0);
+            push(number(base, "position_y", number(base, "y", 32)) / 64.0);
+            push(number(base, "nearby_allies", 0) / 20.0);
+            push(nearbyEnemies / 20.0);
+            if (base.contains("is_under_attack")) {
+                push(number(base, "is_under_attack", 0));
+            } else {
+                push(mine && nearbyEnemies > 0 ? 1.0 : 0.0);
+            }
+            double distance = number(base, "distance_to_nearest_my_base",
+                                     number(base, "distance_to_nearest_enemy_base", 64));
+            push(distance / 64.0);
+        }
+    }
+
+    // 8. 战场分布 (6)
+    const json& dist = object("soldier_distribution");
+    if (dist.contains("my_front_soldier_count")) {
+        push(number(dist, "my_front_soldier_count", 0) / 20.0);
+        push(number(dist, "my_mid_soldier_count", 0) / 20.0);
+        push(number(dist, "my_back_soldier_count", 0) / 20.0);
+        push(number(dist, "enemy_front_soldier_count", 0) / 20.0);
+        push(number(dist, "enemy_mid_soldier_count", 0) / 20.0);
+        push(number(dist, "enemy_back_soldier_count", 0) / 20.0);
+    } else {
+        push(number(dist, "my_front_soldier_count", 0) / 20.0);
+        push(number(dist, "my_avg_x", 0) / 20.0);
+        push(number(dist, "my_avg_y", 0) / 20.0);
+        push(number(dist, "enemy_front_soldier_count", 0) / 20.0);
+        push(number(dist, "enemy_avg_x", 0) / 20.0);
+        push(number(dist, "enemy_avg_y", 0) / 20.0);
+    }
+
+    // 9. 治疗量 (2)
+    push(number(state, "my_heal_done", 0) / 100.0);
+    push(number(state, "enemy_heal_done", 0) / 100.0);
+
+    // 10. 游戏状态 (1)
+    auto gameOver = state.find("game_over");
+    push(gameOver != state.end() && gameOver->is_boolean() && gameOver->get<bool>() ? 1.0 : 0.0);
+
+    // 补充到 79 维
+    while (index < FEATURE_DIM) {
+        features[index++] = 0.0f;
+    }
+}
@@ -0,0 +1,29 @@
+// FeatureEncoderCApi.cpp - libds_features 的 C 接口
+#include "../include/FeatureEncoderCApi.h"
+#include "../include/FeatureEncoder.h"
+#include "../include/NativePolicy.h"
+
+uint32_t ds_feature_version(void) {
+    return FeatureEncoder::VERSION;
+}
+
+int32_t ds_feature_dim(void) {
+    return FeatureEncoder::FEATURE_DIM;
+}
+
+int32_t ds_encode_state(const char* state_json, size_t length, float* features) {
+    return FeatureEncoder::encodeJson(state_json, length, features) ? 1 : 0;
+}
+
+int64_t ds_encode_game(const char* game_json, size_t length, float* features, int64_t capacity) {
+    return FeatureEncoder::encodeGameJson(game_json, length, features, capacity);
+}
+
+int64_t ds_policy_forward(const char* weights_path, const float* features, int64_t rows, float* logits) {
+    NativePolicy policy;
+    if (!policy.load(weights_path)) return -1;
+    for (int64_t row = 0; row < rows; row++) {
+        policy.forward(features + row * NativePolicy::FEATURE_DIM, logits + row * NativePolicy::OUTPUT_DIM);
+    }
+    return rows;
+}
@@ -0,0 +1,35 @@
+// GameState.cpp - 从快照模拟一回合
+#include "../include/GameState.h"
+#include "../include/Controller.h"
+
+namespace {
+
+// 每个线程复用的模拟器：两队都是外部智能体，不创建训练日志、Python代理和工作线程
+struct Simulator {
+    std::shared_ptr<GameModel> model;
+    std::unique_ptr<GameController> controller;
+    
+    Simulator()
+        : model(std::make_shared<GameModel>(0u)),
+          controller(std::make_unique<GameController>(model, GameMode::AI_VS_AI,
+                                                      PlayerType::EXTERNAL, PlayerType::EXTERNAL)) {
+        controller->setVerbose(false);
+    }
+};
+
+} // namespace
+
+bool simulateTurn(GameState& state, const Action (&actions)[2], std::vector<GameEvent>* events) {
+    if (events) events->clear();
+    if (state.gameOver) return true;
+    
+    thread_local Simulator simulator;
+    GameController& controller = *simulator.controller;
+    controller.loadState(state);
+    controller.setExternalAction(0, actions[0]);
+    controller.setExternalAction(1, actions[1]);
+    controller.step();
+    
+    if (events) *events = controller.getTurnEvents();
+    return controller.saveState(state);
+}
@@ -0,0 +1,258 @@
+// Launcher.cpp - 命令行解析、工作目录与无界面运行（DS_PJ 和 ds_train 共用）
+#include "../include/Launcher.h"
+#include "../include/Model.h"
+#include "../include/TrainingRunner.h"
+#include "../include/TrainingLogger.h"
+#include "../include/MctsPlanner.h"
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <libgen.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+std::atomic<bool> g_interrupted(false);
+
+namespace {
+
+std::shared_ptr<GameController> g_controller = nullptr;
+
+// 信号处理函数
+void signalHandler(int signum) {
+    if (signum == SIGINT) {
+        std::cout << "\n\n️ Received interrupt signal (Ctrl+C)" << std::endl;
+        std::cout << "Saving training data gracefully..." << std::endl;
+        g_interrupted = true;
+
+        // 停止游戏控制器，触发保存
+        if (g_controller) {
+            g_controller->stop();
+        }
+    }
+}
+
+bool parsePlayerType(const std::string& type, PlayerType& out) {
+    if (type == "human") out = PlayerType::HUMAN;
+    else if (type == "ai_python") out = PlayerType::AI_PYTHON;
+    else if (type == "ai_rule") out = PlayerType::AI_RULE_BASED;
+    else if (type == "ai_native") out = PlayerType::AI_NATIVE;
+    else if (type == "ai_mcts") out = PlayerType::AI_MCTS;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+GameConfig parseArgs(int argc, char* argv[], const GameConfig& defaults) {
+    GameConfig config = defaults;
+    bool seedGiven = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "training") config.mode = GameMode::TRAINING;
+            else if (mode == "ai_vs_ai") config.mode = GameMode::AI_VS_AI;
+            else if (mode == "human_vs_ai") config.mode = GameMode::HUMAN_VS_AI;
+        }
+        else if (arg == "--team0" && i + 1 < argc) {
+            parsePlayerType(argv[++i], config.team0);
+        }
+        else if (arg == "--team1" && i + 1 < argc) {
+            parsePlayerType(argv[++i], config.team1);
+        }
+        else if (arg == "--games" && i + 1 < argc) {
+            config.games = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            config.threads = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            config.recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            config.replayPath = argv[++i];
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+            seedGiven = true;
+        }
+        else if (arg == "--log-fsync" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "never") TrainingLogger::setSyncPolicy(LogSyncPolicy::NEVER);
+            else if (policy == "game") TrainingLogger::setSyncPolicy(LogSyncPolicy::EVERY_GAME);
+            else TrainingLogger::setSyncPolicy(LogSyncPolicy::INTERVAL, std::atoi(policy.c_str()));
+        }
+        else if (arg == "--log-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "jsonl") TrainingLogger::setOutputFormats(true, false);
+            else if (format == "binary") TrainingLogger::setOutputFormats(false, true);
+            else if (format == "both") TrainingLogger::setOutputFormats(true, true);
+        }
+        else if ((arg == "--mcts-ms" || arg == "--mcts-threads" || arg == "--mcts-iterations") && i + 1 < argc) {
+            MctsConfig mcts = MctsPlanner::defaultConfig();
+            int value = std::max(0, std::atoi(argv[++i]));
+            if (arg == "--mcts-ms") mcts.budgetMs = value;
+            else if (arg == "--mcts-threads") mcts.threads = value;
+            else mcts.maxIterations = value;
+            MctsPlanner::setDefaultConfig(mcts);
+        }
+        else if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [OPTIONS]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --mode <mode>       Game mode: training, ai_vs_ai, human_vs_ai (default: "
+                      << gameModeToString(defaults.mode) << ")\n";
+            std::cout << "  --team0 <type>      Team 0 type: human, ai_python, ai_native, ai_mcts, ai_rule (default: "
+                      << playerTypeToString(defaults.team0) << ")\n";
+            std::cout << "  --team1 <type>      Team 1 type: human, ai_python, ai_native, ai_mcts, ai_rule (default: "
+                      << playerTypeToString(defaults.team1) << ")\n";
+            std::cout << "  --games <N>         Run N training games in this process (implies --mode training)\n";
+            std::cout << "  --threads <T>       Worker threads for --games (default: all CPU cores)\n";
+            std::cout << "  --seed <N>          Random seed; the same seed and actions replay the same game (default: random)\n";
+            std::cout << "  --record <file>     Write a compact replay of a single game to file\n";
+            std::cout << "  --replay <file>     Play back a replay in the game window (DS_PJ only)\n";
+            std::cout << "  --log-fsync <p>     Training log fsync policy: never, game, or every N games (default: 100)\n";
+            std::cout << "  --log-format <f>    Training output: jsonl, binary (dataset/ shards), both (default)\n";
+            std::cout << "  --mcts-ms <ms>      ai_mcts search time per turn, shared by both teams (default: 100, at most "
+                      << MctsPlanner::MAX_BUDGET_MS << ")\n";
+            std::cout << "  --mcts-threads <T>  ai_mcts root-parallel search threads (default: all CPU cores; 1 in training)\n";
+            std::cout << "  --mcts-iterations <N>  Fixed ai_mcts iterations per thread instead of a time budget (reproducible;\n"
+                      << "                      training defaults to " << MctsPlanner::TRAINING_ITERATIONS << ")\n";
+            std::cout << "  --help, -h          Show this help message\n\n";
+            std::cout << "Examples:\n";
+            std::cout << "  " << argv[0] << " --mode ai_vs_ai --team0 ai_python --team1 ai_rule\n";
+            std::cout << "  " << argv[0] << " --mode training --team0 ai_python --team1 ai_rule\n";
+            std::cout << "  " << argv[0] << " --mode training --team0 ai_rule --team1 ai_native\n";
+            std::cout << "  " << argv[0] << " --games 1000 --threads 8 --team0 ai_rule --team1 ai_rule\n";
+            std::cout << "  " << argv[0] << " --mode ai_vs_ai --team0 ai_rule --team1 ai_rule --seed 42 --record game.dsrp\n";
+            std::cout << "  " << argv[0] << " --replay game.dsrp\n";
+            std::cout << "  " << argv[0] << " --mode ai_vs_ai --team0 ai_rule --team1 ai_mcts --mcts-ms 150\n";
+            exit(0);
+        }
+    }
+
+    if (!seedGiven) {
+        config.seed = RngContext::randomSeed();
+    }
+    return config;
+}
+
+void changeToProjectRoot() {
+    char exePath[PATH_MAX];
+    bool found = false;
+#ifdef __APPLE__
+    uint32_t size = sizeof(exePath);
+    found = _NSGetExecutablePath(exePath, &size) == 0;
+#else
+    ssize_t length = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+    if (length > 0) {
+        exePath[length] = '\0';
+        found = true;
+    }
+#endif
+    if (!found) return;
+
+    char* dirPath = dirname(exePath);  // 获取目录部分
+    char* parentPath = dirname(dirPath);  // 再上一级
+    if (chdir(parentPath) == 0) {
+        std::cout << "Working directory: " << parentPath << std::endl;
+    }
+}
+
+void installInterruptHandler() {
+    std::signal(SIGINT, signalHandler);
+}
+
+void setInterruptTarget(std::shared_ptr<GameController> controller) {
+    g_controller = std::move(controller);
+}
+
+int runHeadless(const GameConfig& config) {
+    if (!config.replayPath.empty()) {
+        std::cerr << "--replay needs the game window (run DS_PJ)" << std::endl;
+        return 1;
+    }
+
+    // 多局并行训练：每局独立的Model/Controller，在线程池上运行
+    if (config.games > 0) {
+        TrainingConfig trainingConfig;
+        trainingConfig.team0 = config.team0;
+        trainingConfig.team1 = config.team1;
+        trainingConfig.games = config.games;
+        trainingConfig.threads = config.threads > 0 ? config.threads
+                                                    : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        trainingConfig.baseSeed = config.seed;
+        if (!config.recordPath.empty()) {
+            std::cout << "--record only applies to single games; ignored with --games" << std::endl;
+        }
+
+        std::cout << "Parallel training: " << trainingConfig.games << " games on "
+                  << trainingConfig.threads << " threads" << std::endl;
+        std::cout << "Team 0: " << playerTypeToString(trainingConfig.team0) << std::endl;
+        std::cout << "Team 1: " << playerTypeToString(trainingConfig.team1) << std::endl;
+        std::cout << "Base seed: " << trainingConfig.baseSeed << std::endl;
+
+        TrainingRunner runner(trainingConfig);
+        TrainingSummary summary = runner.run(g_interrupted);
+        TrainingLogger::flushDataset();
+        if (g_interrupted) {
+            std::cout << "Training interrupted by user. Finished games have been saved." << std::endl;
+        }
+        TrainingRunner::printSummary(summary);
+        return 0;
+    }
+
+    std::cout << "Strategy Game Starting..." << std::endl;
+    std::cout << "Mode: " << gameModeToString(config.mode) << std::endl;
+    std::cout << "Team 0: " << playerTypeToString(config.team0) << std::endl;
+    std::cout << "Team 1: " << playerTypeToString(config.team1) << std::endl;
+    std::cout << "Seed: " << config.seed << std::endl;
+
+    auto model = std::make_shared<GameModel>(config.seed);
+    auto controller = std::make_shared<GameController>(model, config.mode, config.team0, config.team1);
+    setInterruptTarget(controller);
+    if (!config.recordPath.empty() && controller->recordReplay(config.recordPath)) {
+        std::cout << "Recording replay to " << config.recordPath << std::endl;
+    }
+
+    std::cout << "Starting Game Controller..." << std::endl;
+    controller->start();
+
+    // 无渲染，等待游戏结束（不sleep，让Controller全速运行）
+    int lastReportedTurn = 0;
+    while (!model->isGameOver() && !g_interrupted) {
+        int currentTurn = controller->getCurrentTurn();
+        // 每1000回合报告一次进度
+        if (currentTurn > 0 && currentTurn % 1000 == 0 && currentTurn != lastReportedTurn) {
+            std::cout << "Turn " << currentTurn << " - Game still running..." << std::endl;
+            lastReportedTurn = currentTurn;
+        }
+        // 短暂让出CPU，避免100%占用
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 如果是被中断，显示提示
+    if (g_interrupted) {
+        std::cout << "Training interrupted by user. Data has been saved." << std::endl;
+    }
+
+    std::cout << "Stopping Controller..." << std::endl;
+    controller->stop();
+    TrainingLogger::flushDataset();
+    setInterruptTarget(nullptr);  // 清除全局引用
+    std::cout << "Game Over!" << std::endl;
+
+    if (model->isGameOver()) {
+        std::string winner = (model->getWinner() == Team::TEAM_A) ? "Team A" : "Team B";
+        std::cout << winner << " Wins!" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,236 @@
+// MctsPlanner.cpp - 出兵决策的蒙特卡洛树搜索
+#include "../include/MctsPlanner.h"
+#include "../include/AIController.h"
+#include "../include/CombatSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+// 命令行设置的默认配置
+static MctsConfig defaultMctsConfig;
+
+void MctsPlanner::setDefaultConfig(const MctsConfig& config) {
+    defaultMctsConfig = config;
+}
+
+MctsConfig MctsPlanner::defaultConfig() {
+    return defaultMctsConfig;
+}
+
+MctsPlanner::MctsPlanner(const MctsConfig& config)
+    : config(config),
+      pool(config.threads > 0 ? static_cast<size_t>(config.threads)
+                              : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+Action MctsPlanner::actionAt(int index) {
+    if (index <= 0) return Action::wait();
+    int spawn = index - 1;
+    return Action::spawn(spawn / SOLDIER_TYPE_COUNT, static_cast<SoldierType>(spawn % SOLDIER_TYPE_COUNT));
+}
+
+MctsConfig MctsPlanner::trainingConfig(MctsConfig config) {
+    if (config.maxIterations <= 0) config.maxIterations = TRAINING_ITERATIONS;
+    if (config.threads <= 0) config.threads = 1;
+    return config;
+}
+
+bool MctsPlanner::needsSearch(const GameState& root, int team) {
+    if (root.gameOver) return false;
+    
+    // 本回合买不起任何兵（或没有存活基地）时只能等待，不需要搜索
+    int energy = root.energy[team] + ENERGY_PER_TURN;
+    int cheapest = std::numeric_limits<int>::max();
+    for (int type = 0; type < SOLDIER_TYPE_COUNT; type++) {
+        cheapest = std::min(cheapest, CombatSystem::getSoldierCost(static_cast<SoldierType>(type)));
+    }
+    bool hasBase = std::any_of(std::begin(root.bases[team]), std::end(root.bases[team]),
+                               [](const BaseState& base) { return base.hp > 0; });
+    return energy >= cheapest && hasBase;
+}
+
+void MctsPlanner::plan(const GameState& root, const bool (&searching)[2], const uint64_t (&seeds)[2],
+                       Action (&actions)[2]) {
+    int teams[2];
+    int teamCount = 0;
+    for (int team = 0; team < 2; team++) {
+        actions[team] = Action::wait();
+        if (searching[team] && needsSearch(root, team)) teams[teamCount++] = team;
+    }
+    if (teamCount == 0) return;
+    
+    // 根并行：线程池按队伍平分，每个线程独立建树，两队的搜索同时进行
+    // 线程比队伍少时任务分轮执行，预算按轮数均分，整个回合的搜索时间仍不超过一份预算
+    size_t perTeam = std::max<size_t>(1, pool.size() / teamCount);
+    size_t tasks = perTeam * teamCount;
+    size_t rounds = (tasks + pool.size() - 1) / pool.size();
+    auto budget = std::chrono::milliseconds(std::max<int>(1, std::clamp(config.budgetMs, 1, MAX_BUDGET_MS) /
+                                                             static_cast<int>(rounds)));
+    results.assign(tasks, RootStats{});
+    for (int k = 0; k < teamCount; k++) {
+        for (size_t w = 0; w < perTeam; w++) {
+            int team = teams[k];
+            RootStats& stats = results[k * perTeam + w];
+            pool.submit([this, &root, team, seed = seeds[team] + w, budget, &stats]() {
+                search(root, team, seed, budget, stats);
+            });
+        }
+    }
+    pool.wait();
+    
+    for (int k = 0; k < teamCount; k++) {
+        actions[teams[k]] = actionAt(bestAction(&results[k * perTeam], perTeam));
+    }
+}
+
+int MctsPlanner::bestAction(const RootStats* stats, size_t count) {
+    // 合并根节点统计：访问次数最多的动作，相同时取平均回报高的
+    int best = 0;
+    int bestVisits = -1;
+    double bestMean = 0.0;
+    for (int a = 0; a < ACTION_COUNT; a++) {
+        int visits = 0;
+        double value = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            visits += stats[i].visits[a];
+            value += stats[i].value[a];
+        }
+        double mean = visits > 0 ? value / visits : 0.0;
+        if (visits > bestVisits || (visits == bestVisits && mean > bestMean)) {
+            best = a;
+            bestVisits = visits;
+            bestMean = mean;
+        }
+    }
+    return best;
+}
+
+void MctsPlanner::search(const GameState& root, int team, uint64_t seed,
+                         std::chrono::milliseconds budget, RootStats& stats) const {
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    
+    // 子节点连续存放在 nodes 中
+    struct Node {
+        int firstChild = -1;
+        int childCount = 0;
+        int action = 0;     // 从父节点到达该节点的动作编号
+        int visits = 0;
+        double value = 0.0; // 累计回报（搜索方视角）
+    };
+    std::vector<Node> nodes(1);
+    std::vector<int> path;
+    
+    RngStream rng(seed);
+    std::uniform_int_distribution<> typeDis(0, SOLDIER_TYPE_COUNT - 1);
+    int enemy = 1 - team;
+    
+    // 展开：等待，以及在存活基地出本回合买得起的兵
+    auto expand = [&](int node, const GameState& state) {
+        int energy = state.energy[team] + ENERGY_PER_TURN;
+        int first = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        for (int base = 0; base < BASE_COUNT_PER_TEAM; base++) {
+            if (state.bases[team][base].hp <= 0) continue;
+            for (int type = 0; type < SOLDIER_TYPE_COUNT; type++) {
+                if (CombatSystem::getSoldierCost(static_cast<SoldierType>(type)) > energy) continue;
+                nodes.emplace_back();
+                nodes.back().action = 1 + base * SOLDIER_TYPE_COUNT + type;
+            }
+        }
+        nodes[node].firstChild = first;
+        nodes[node].childCount = static_cast<int>(nodes.size()) - first;
+    };
+    
+    // UCB1，未访问过的子节点优先
+    auto select = [&](int node) {
+        const Node& parent = nodes[node];
+        double logVisits = std::log(static_cast<double>(std::max(1, parent.visits)));
+        int best = parent.firstChild;
+        double bestScore = -std::numeric_limits<double>::infinity();
+        for (int c = parent.firstChild; c < parent.firstChild + parent.childCount; c++) {
+            const Node& child = nodes[c];
+            if (child.visits == 0) return c;
+            double score = child.value / child.visits + config.exploration * std::sqrt(logVisits / child.visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = c;
+            }
+        }
+        return best;
+    };
+    
+    Action actions[2];
+    for (int iteration = 0; ; iteration++) {
+        if (config.maxIterations > 0 ? iteration >= config.maxIterations
+                                     : std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        
+        GameState state = root;
+        state.rng = RngContext(rng());
+        SoldierType queueHead[2] = {static_cast<SoldierType>(typeDis(rng)), static_cast<SoldierType>(typeDis(rng))};
+        
+        // 选择 + 展开：沿树下降，到达新叶子后停止
+        int node = 0;
+        int depth = 0;
+        bool ok = true;
+        path.assign(1, 0);
+        while (depth < config.horizon && !state.gameOver) {
+            if (node != 0 && nodes[node].visits == 0) break;
+            if (nodes[node].childCount == 0) expand(node, state);
+            
+            node = select(node);
+            actions[team] = actionAt(nodes[node].action);
+            actions[enemy] = AIController::rolloutPurchase(state, enemy, queueHead[enemy], rng);
+            ok = simulateTurn(state, actions);
+            path.push_back(node);
+            depth++;
+            if (!ok) break;
+        }
+        
+        // rollout：双方都按规则AI出兵
+        while (ok && depth < config.horizon && !state.gameOver) {
+            actions[team] = AIController::rolloutPurchase(state, team, queueHead[team], rng);
+            actions[enemy] = AIController::rolloutPurchase(state, enemy, queueHead[enemy], rng);
+            ok = simulateTurn(state, actions);
+            depth++;
+        }
+        
+        // 回传
+        double value = evaluate(state, team);
+        for (int n : path) {
+            nodes[n].visits++;
+            nodes[n].value += value;
+        }
+    }
+    
+    stats = RootStats{};
+    const Node& rootNode = nodes[0];
+    for (int c = rootNode.firstChild; c >= 0 && c < rootNode.firstChild + rootNode.childCount; c++) {
+        stats.visits[nodes[c].action] += nodes[c].visits;
+        stats.value[nodes[c].action] += nodes[c].value;
+    }
+}
+
+double MctsPlanner::evaluate(const GameState& state, int team) {
+    if (state.gameOver) return state.winner == team ? 1.0 : 0.0;
+    
+    // 基地HP差，以及兵力差（士兵按剩余生命比例折算价格，未花掉的能量也计入）
+    int enemy = 1 - team;
+    double baseHp[2] = {0.0, 0.0};
+    double material[2] = {static_cast<double>(state.energy[0]), static_cast<double>(state.energy[1])};
+    for (int t = 0; t < 2; t++) {
+        for (const auto& base : state.bases[t]) baseHp[t] += std::max(0, base.hp);
+    }
+    for (int i = 0; i < state.soldierCount; i++) {
+        const SoldierState& soldier = state.soldiers[i];
+        SoldierType type = static_cast<SoldierType>(soldier.type);
+        material[soldier.team] += CombatSystem::getSoldierCost(type) * soldier.hp /
+                                  static_cast<double>(getSoldierStats(type).hp);
+    }
+    
+    double baseTerm = (baseHp[team] - baseHp[enemy]) / (BASE_HP * BASE_COUNT_PER_TEAM);
+    double materialTerm = (material[team] - material[enemy]) / (material[0] + material[1] + 1000.0);
+    return 0.5 + 0.5 * std::clamp(baseTerm + 0.5 * materialTerm, -1.0, 1.0);
+}
@@ -1,117 +1,319 @@
 #include "../include/Model.h"
-#include <random>
+#include "../include/GameState.h"
 #include <algorithm>
-
-// 随机数生成器
-static std::random_device rd;
-static std::mt19937 gen(rd());
+#include <array>
+#include <numeric>
 
 // Soldier 实现
 Soldier::Soldier(Position pos, SoldierType type, Team team)
-    : position(pos), type(type), team(team), alive(true) {
-    
-    // 根据类型初始化属性
-    switch (type) {
-        case SoldierType::ARCHER:
-            maxHp = hp = Archer::HP;
-            attack = Archer::ATTACK;
-            attackRange = Archer::ATTACK_RANGE;
-            visionRange = Archer::VISION_RANGE;
-            moveSpeed = Archer::MOVE_SPEED;
-            armor = Archer::ARMOR;
-            break;
-        case SoldierType::INFANTRY:
-            maxHp = hp = Infantry::HP;
-            attack = Infantry::ATTACK;
-            attackRange = Infantry::ATTACK_RANGE;
-            visionRange = Infantry::VISION_RANGE;
-            moveSpeed = Infantry::MOVE_SPEED;
-            armor = Infantry::ARMOR;
-            break;
-        case SoldierType::CAVALRY:
-            maxHp = hp = Cavalry::HP;
-            attack = Cavalry::ATTACK;
-            attackRange = Cavalry::ATTACK_RANGE;
-            visionRange = Cavalry::VISION_RANGE;
-            moveSpeed = Cavalry::MOVE_SPEED;
-            armor = Cavalry::ARMOR;
-            break;
-        case SoldierType::CASTER:
-            maxHp = hp = Caster::HP;
-            attack = Caster::ATTACK;
-            attackRange = Caster::ATTACK_RANGE;
-            visionRange = Caster::VISION_RANGE;
-            moveSpeed = Caster::MOVE_SPEED;
-            armor = Caster::ARMOR;
-            break;
-        case SoldierType::DOCTOR:
-            maxHp = hp = Doctor::HP;
-            attack = Doctor::ATTACK;
-            attackRange = Doctor::ATTACK_RANGE;
-            visionRange = Doctor::VISION_RANGE;
-            moveSpeed = Doctor::MOVE_SPEED;
-            armor = Doctor::ARMOR;
-            break;
-    }
-}
-
-Position Soldier::getPosition() const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return position;
-}
+    : position(pos), type(type), team(team), hp(getSoldierStats(type).hp), alive(true),
+      id(INVALID_SOLDIER_ID), owner(nullptr) {}
 
 void Soldier::setPosition(const Position& pos) {
-    std::lock_guard<std::mutex> lock(mutex);
     position = pos;
+    if (owner) owner->onSoldierMoved(id, pos);
 }
 
 void Soldier::setHp(int newHp) {
-    std::lock_guard<std::mutex> lock(mutex);
-    hp = std::max(0, std::min(newHp, maxHp));  // 限制在 [0, maxHp] 范围内
+    hp = std::max(0, std::min(newHp, getMaxHp()));  // 限制在 [0, maxHp] 范围内
     if (hp <= 0) {
-        alive.store(false);
+        alive.store(false, std::memory_order_relaxed);
     }
+    if (owner) owner->onSoldierHpChanged(id, hp, isAlive());
 }
 
 void Soldier::takeDamage(int damage) {
-    std::lock_guard<std::mutex> lock(mutex);
-    int actualDamage = std::max(0, damage - armor);
+    int actualDamage = std::max(0, damage - getArmor());
     hp -= actualDamage;
     if (hp <= 0) {
         hp = 0;
-        alive.store(false);
+        alive.store(false, std::memory_order_relaxed);
     }
+    if (owner) owner->onSoldierHpChanged(id, hp, isAlive());
 }
 
 bool Soldier::canAttack(const Position& target) const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return position.chebyshevDistanceTo(target) <= attackRange;
+    return position.chebyshevDistanceTo(target) <= getAttackRange();
 }
 
 bool Soldier::canSee(const Position& target) const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return position.chebyshevDistanceTo(target) <= visionRange;
+    return position.chebyshevDistanceTo(target) <= getVisionRange();
+}
+
+// SoldierColumns 实现
+void SoldierColumns::push(const Soldier& soldier) {
+    size_t i = size();
+    x.push_back(soldier.getPosition().x);
+    y.push_back(soldier.getPosition().y);
+    hp.push_back(soldier.getHp());
+    team.push_back(static_cast<uint8_t>(soldier.getTeam()));
+    type.push_back(static_cast<uint8_t>(soldier.getType()));
+    visionGroup.push_back(-1);
+    if ((i >> 6) >= aliveBits.size()) aliveBits.push_back(0);
+    setAlive(i, soldier.isAlive());
+}
+
+void SoldierColumns::swapRemove(size_t i) {
+    size_t last = size() - 1;
+    if (i != last) {
+        x[i] = x[last];
+        y[i] = y[last];
+        hp[i] = hp[last];
+        team[i] = team[last];
+        type[i] = type[last];
+        visionGroup[i] = visionGroup[last];
+        setAlive(i, isAlive(last));
+    }
+    setAlive(last, false);
+    x.pop_back();
+    y.pop_back();
+    hp.pop_back();
+    team.pop_back();
+    type.pop_back();
+    visionGroup.pop_back();
+    if (aliveBits.size() > (size() + 63) / 64) aliveBits.pop_back();
+}
+
+void SoldierColumns::setAlive(size_t i, bool value) {
+    uint64_t bit = uint64_t(1) << (i & 63);
+    if (value) {
+        aliveBits[i >> 6] |= bit;
+    } else {
+        aliveBits[i >> 6] &= ~bit;
+    }
+}
+
+void SoldierColumns::clear() {
+    x.clear();
+    y.clear();
+    hp.clear();
+    team.clear();
+    type.clear();
+    visionGroup.clear();
+    aliveBits.clear();
+}
+
+// VisionBoard 实现
+// 每个兵种视野方块在各列位置上的行掩码：squareRowMasks[type][y] 覆盖 [y - r, y + r]
+static const std::array<std::array<uint64_t, MAP_SIZE>, SOLDIER_TYPE_COUNT> squareRowMasks = [] {
+    std::array<std::array<uint64_t, MAP_SIZE>, SOLDIER_TYPE_COUNT> masks{};
+    for (int t = 0; t < SOLDIER_TYPE_COUNT; t++) {
+        int range = SOLDIER_STATS[t].visionRange;
+        for (int y = 0; y < MAP_SIZE; y++) {
+            uint64_t mask = 0;
+            for (int v = std::max(0, y - range); v <= std::min(MAP_SIZE - 1, y + range); v++) {
+                mask |= uint64_t(1) << v;
+            }
+            masks[t][y] = mask;
+        }
+    }
+    return masks;
+}();
+
+void VisionBoard::orSquare(int cx, int cy, SoldierType type) {
+    if (cy < 0 || cy >= MAP_SIZE) return;
+    int range = getSoldierStats(type).visionRange;
+    uint64_t mask = squareRowMasks[static_cast<int>(type)][cy];
+    for (int x = std::max(0, cx - range); x <= std::min(MAP_SIZE - 1, cx + range); x++) {
+        rows[x] |= mask;
+    }
+}
+
+// FlowField 实现
+void FlowField::build(const GameMap& map, const std::vector<Position>& targets) {
+    std::fill(distance.begin(), distance.end(), UNREACHABLE);
+    
+    std::vector<int> queue;
+    queue.reserve(MAP_SIZE * MAP_SIZE);
+    for (const auto& target : targets) {
+        if (!map.isValidPosition(target)) continue;
+        int cell = target.x * MAP_SIZE + target.y;
+        if (distance[cell] == 0) continue;
+        distance[cell] = 0;
+        queue.push_back(cell);
+    }
+    
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        int x = cell / MAP_SIZE;
+        int y = cell % MAP_SIZE;
+        uint16_t next = distance[cell] + 1;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                if (dx == 0 && dy == 0) continue;
+                Position pos(x + dx, y + dy);
+                if (!map.isWalkable(pos)) continue;
+                int neighbor = pos.x * MAP_SIZE + pos.y;
+                if (distance[neighbor] != UNREACHABLE) continue;
+                distance[neighbor] = next;
+                queue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+// SpatialHash 实现
+void SpatialHash::insert(size_t index) {
+    bucketFor(index).push_back(static_cast<uint32_t>(index));
+}
+
+void SpatialHash::remove(size_t index) {
+    auto& bucket = bucketFor(index);
+    auto it = std::find(bucket.begin(), bucket.end(), static_cast<uint32_t>(index));
+    if (it != bucket.end()) {
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+void SpatialHash::move(size_t index, int newX, int newY) {
+    int team = cols.team[index];
+    int oldBucket = bucketOf(cols.x[index], cols.y[index]);
+    int newBucket = bucketOf(newX, newY);
+    if (oldBucket == newBucket) return;
+    remove(index);
+    buckets[team][newBucket].push_back(static_cast<uint32_t>(index));
+}
+
+void SpatialHash::reindex(size_t from, size_t to) {
+    auto& bucket = bucketFor(from);
+    std::replace(bucket.begin(), bucket.end(), static_cast<uint32_t>(from), static_cast<uint32_t>(to));
 }
 
-// 视野共享相关方法
-void Soldier::updateLastTurnVision(const std::set<int>& enemyIds) {
-    std::lock_guard<std::mutex> lock(visionMutex);
-    lastTurnVisibleEnemies = enemyIds;
+void SpatialHash::clear() {
+    for (auto& teamBuckets : buckets) {
+        for (auto& bucket : teamBuckets) bucket.clear();
+    }
 }
 
-void Soldier::updateSharedVision(const std::set<int>& sharedEnemyIds) {
-    std::lock_guard<std::mutex> lock(visionMutex);
-    sharedVisibleEnemies = sharedEnemyIds;
+// InfluenceMap 实现
+InfluenceMap::InfluenceMap() {
+    for (int t = 0; t < 2; t++) {
+        density[t].assign(PADDED_SIZE * PADDED_SIZE, 0);
+        threat[t].assign(MAP_SIZE * MAP_SIZE, 0);
+    }
+    cellCounts.assign(GUARDED_SIZE * GUARDED_SIZE, 0);
+    for (auto& grid : rowWindows) grid.assign(GUARDED_SIZE * GUARDED_SIZE, 0);
+    for (auto& grid : attackByRange) grid.assign(MAP_SIZE * MAP_SIZE, 0);
+    boxRows.assign(MAP_SIZE * MAP_SIZE, 0);
 }
 
-std::set<int> Soldier::getLastTurnVisibleEnemies() const {
-    std::lock_guard<std::mutex> lock(visionMutex);
-    return lastTurnVisibleEnemies;
+void InfluenceMap::addSoldier(Team team, int x, int y, int delta) {
+    auto& grid = density[static_cast<int>(team)];
+    for (int dx = -DENSITY_RADIUS; dx <= DENSITY_RADIUS; dx++) {
+        int px = x + dx + DENSITY_RADIUS;
+        if (px < 0 || px >= PADDED_SIZE) continue;
+        int width = DENSITY_RADIUS - std::abs(dx);
+        for (int py = std::max(0, y + DENSITY_RADIUS - width); py <= std::min(PADDED_SIZE - 1, y + DENSITY_RADIUS + width); py++) {
+            grid[px * PADDED_SIZE + py] += delta;
+        }
+    }
 }
 
-std::set<int> Soldier::getSharedVisibleEnemies() const {
-    std::lock_guard<std::mutex> lock(visionMutex);
-    return sharedVisibleEnemies;
+void InfluenceMap::rebuild(const SoldierColumns& cols) {
+    constexpr int R = DENSITY_RADIUS;
+    constexpr int P = PADDED_SIZE;
+    constexpr int G = GUARDED_SIZE;
+    constexpr int M = MAP_SIZE;
+    
+    for (int t = 0; t < 2; t++) {
+        // 密度：菱形 = 第x行半宽R的窗口和 + 第x±d行半宽R-d的窗口和
+        // 先算出各半宽的横向窗口和，再按行相加（格子(x, y)在保护网格中的坐标为(x + 2R, y + 2R)）
+        std::fill(cellCounts.begin(), cellCounts.end(), 0);
+        for (size_t i = 0; i < cols.size(); i++) {
+            if (cols.team[i] != t || !cols.isAlive(i)) continue;
+            cellCounts[(cols.x[i] + 2 * R) * G + cols.y[i] + 2 * R]++;
+        }
+        rowWindows[0] = cellCounts;
+        for (int w = 1; w <= R; w++) {
+            const int16_t* narrower = rowWindows[w - 1].data();
+            int16_t* out = rowWindows[w].data();
+            for (int x = 0; x < G; x++) {
+                for (int y = w; y < G - w; y++) {
+                    out[x * G + y] = narrower[x * G + y] + cellCounts[x * G + y - w] + cellCounts[x * G + y + w];
+                }
+            }
+        }
+        auto& grid = density[t];
+        for (int px = 0; px < P; px++) {
+            int gx = px + R;
+            for (int py = 0; py < P; py++) {
+                int gy = py + R;
+                int total = rowWindows[R][gx * G + gy];
+                for (int d = 1; d <= R; d++) {
+                    total += rowWindows[R - d][(gx - d) * G + gy] + rowWindows[R - d][(gx + d) * G + gy];
+                }
+                grid[px * P + py] = static_cast<int16_t>(total);
+            }
+        }
+        
+        // 威胁：敌方攻击力按攻击范围分组，每组做一次横向+纵向的滑动窗口求和（切比雪夫方块）
+        auto& threatGrid = threat[t];
+        std::fill(threatGrid.begin(), threatGrid.end(), 0);
+        bool hasRange[MAX_ATTACK_RANGE + 1] = {};
+        for (size_t i = 0; i < cols.size(); i++) {
+            if (cols.team[i] == t || !cols.isAlive(i)) continue;
+            const SoldierStats& stats = cols.statsAt(i);
+            attackByRange[stats.attackRange][cols.x[i] * M + cols.y[i]] += stats.attack;
+            hasRange[stats.attackRange] = true;
+        }
+        
+        for (int range = 0; range <= MAX_ATTACK_RANGE; range++) {
+            if (!hasRange[range]) continue;
+            auto& weights = attackByRange[range];
+            
+            for (int x = 0; x < M; x++) {
+                const int32_t* in = &weights[x * M];
+                int32_t* out = &boxRows[x * M];
+                int sum = 0;
+                for (int y = 0; y < std::min(range, M); y++) sum += in[y];
+                for (int y = 0; y < M; y++) {
+                    if (y + range < M) sum += in[y + range];
+                    if (y - range - 1 >= 0) sum -= in[y - range - 1];
+                    out[y] = sum;
+                }
+            }
+            // 纵向按整行累加，内层循环连续访问
+            for (int x = 0; x < M; x++) {
+                int32_t* out = &threatGrid[x * M];
+                for (int rx = std::max(0, x - range); rx <= std::min(M - 1, x + range); rx++) {
+                    const int32_t* row = &boxRows[rx * M];
+                    for (int y = 0; y < M; y++) out[y] += row[y];
+                }
+            }
+            std::fill(weights.begin(), weights.end(), 0);
+        }
+    }
+}
+
+// OccupancyGrid 实现
+void OccupancyGrid::enter(int x, int y, SoldierId id) {
+    if (!inBounds(x, y)) return;
+    int cell = x * MAP_SIZE + y;
+    count[cell]++;
+    occupant[cell] = id;
+}
+
+void OccupancyGrid::leave(int x, int y, SoldierId id, const SoldierColumns& cols,
+                          const SlotMap<std::shared_ptr<Soldier>>& soldiers) {
+    if (!inBounds(x, y)) return;
+    int cell = x * MAP_SIZE + y;
+    if (count[cell] == 0) return;
+    count[cell]--;
+    if (count[cell] == 0 || occupant[cell] != id) return;
+    
+    // 叠放的格子：离开的是记录的士兵时，重新找一个仍在格子上的存活士兵（很少发生）
+    for (size_t i = 0; i < cols.size(); i++) {
+        if (cols.x[i] == x && cols.y[i] == y && cols.isAlive(i) && soldiers.handleAt(i) != id) {
+            occupant[cell] = soldiers.handleAt(i);
+            return;
+        }
+    }
+}
+
+void OccupancyGrid::clear() {
+    std::fill(count.begin(), count.end(), 0);
+    std::fill(occupant.begin(), occupant.end(), INVALID_SOLDIER_ID);
 }
 
 // Base 实现
@@ -125,25 +327,34 @@ void Base::takeDamage(int damage) {
 }
 
 // GameMap 实现
-GameMap::GameMap() : terrain(MAP_SIZE, std::vector<TerrainType>(MAP_SIZE, TerrainType::PLAIN)) {}
+GameMap::GameMap() {
+    terrain.fill(TerrainType::PLAIN);
+    bumpRevision();
+}
 
-void GameMap::initialize() {
+void GameMap::bumpRevision() {
+    static std::atomic<uint64_t> nextRevision(1);
+    revision.store(nextRevision.fetch_add(1, std::memory_order_relaxed), std::memory_order_release);
+}
+
+void GameMap::initialize(RngStream& rng) {
     std::lock_guard<std::mutex> lock(mutex);
     
     // 初始化为平原
     for (int i = 0; i < MAP_SIZE; i++) {
         for (int j = 0; j < MAP_SIZE; j++) {
-            terrain[i][j] = TerrainType::PLAIN;
+            terrain[i * MAP_SIZE + j] = TerrainType::PLAIN;
         }
     }
     
     // 基地位置将在GameModel::initialize中设置
     
     // 生成障碍物
-    generateObstacles();
+    generateObstacles(rng);
+    bumpRevision();
 }
 
-void GameMap::generateObstacles() {
+void GameMap::generateObstacles(RngStream& rng) {
     std::uniform_int_distribution<> dis(0, MAP_SIZE - 1);
     std::uniform_int_distribution<> typeDis(0, 1);
     
@@ -151,8 +362,8 @@ void GameMap::generateObstacles() {
     int obstacleCount = (MAP_SIZE * MAP_SIZE) / 70;
     
     for (int i = 0; i < obstacleCount; i++) {
-        int x = dis(gen);
-        int y = dis(gen);
+        int x = dis(rng);
+        int y = dis(rng);
         
         // 不在基地附近生成障碍物
         if ((x >= 2 && x <= 8 && y >= 2 && y <= 8) ||
@@ -161,10 +372,10 @@ void GameMap::generateObstacles() {
             continue;
         }
         
-        if (terrain[x][y] == TerrainType::PLAIN) {
+        if (terrain[x * MAP_SIZE + y] == TerrainType::PLAIN) {
             // 随机选择障碍物类型（山脉或河流）
-            TerrainType obstacleType = typeDis(gen) == 0 ? TerrainType::MOUNTAIN : TerrainType::RIVER;
-            terrain[x][y] = obstacleType;
+            TerrainType obstacleType = typeDis(rng) == 0 ? TerrainType::MOUNTAIN : TerrainType::RIVER;
+            terrain[x * MAP_SIZE + y] = obstacleType;
             
             // 创建4-相邻聚类：只有上下左右有概率是同一种类型（不包括对角线）
             std::uniform_int_distribution<> clusterDis(0, 100);
@@ -182,8 +393,8 @@ void GameMap::generateObstacles() {
                      ny >= MAP_SIZE - 9 && ny <= MAP_SIZE - 3)) continue;
                 
                 // 相邻格子：70%概率与中心相同类型（强边连接）
-                if (terrain[nx][ny] == TerrainType::PLAIN && clusterDis(gen) < 70) {
-                    terrain[nx][ny] = obstacleType;
+                if (terrain[nx * MAP_SIZE + ny] == TerrainType::PLAIN && clusterDis(rng) < 70) {
+                    terrain[nx * MAP_SIZE + ny] = obstacleType;
                 }
             }
             
@@ -198,8 +409,8 @@ void GameMap::generateObstacles() {
                      ny >= MAP_SIZE - 9 && ny <= MAP_SIZE - 3)) continue;
                 
                 // 距离2倍的格子：40%概率
-                if (terrain[nx][ny] == TerrainType::PLAIN && clusterDis(gen) < 40) {
-                    terrain[nx][ny] = obstacleType;
+                if (terrain[nx * MAP_SIZE + ny] == TerrainType::PLAIN && clusterDis(rng) < 40) {
+                    terrain[nx * MAP_SIZE + ny] = obstacleType;
                 }
             }
         }
@@ -209,9 +420,9 @@ void GameMap::generateObstacles() {
     // Team A基地（左上角，约5,5）
     for (int x = 2; x <= 8; x++) {
         for (int y = 2; y <= 8; y++) {
-            if (terrain[x][y] == TerrainType::MOUNTAIN || 
-                terrain[x][y] == TerrainType::RIVER) {
-                terrain[x][y] = TerrainType::PLAIN;
+            if (terrain[x * MAP_SIZE + y] == TerrainType::MOUNTAIN || 
+                terrain[x * MAP_SIZE + y] == TerrainType::RIVER) {
+                terrain[x * MAP_SIZE + y] = TerrainType::PLAIN;
             }
         }
     }
@@ -219,9 +430,9 @@ void GameMap::generateObstacles() {
     // Team B基地（右下角，约14,14）
     for (int x = MAP_SIZE - 9; x <= MAP_SIZE - 3; x++) {
         for (int y = MAP_SIZE - 9; y <= MAP_SIZE - 3; y++) {
-            if (terrain[x][y] == TerrainType::MOUNTAIN || 
-                terrain[x][y] == TerrainType::RIVER) {
-                terrain[x][y] = TerrainType::PLAIN;
+            if (terrain[x * MAP_SIZE + y] == TerrainType::MOUNTAIN || 
+                terrain[x * MAP_SIZE + y] == TerrainType::RIVER) {
+                terrain[x * MAP_SIZE + y] = TerrainType::PLAIN;
             }
         }
     }
@@ -231,7 +442,7 @@ bool GameMap::isWalkable(const Position& pos) const {
     if (!isValidPosition(pos)) return false;
     
     std::lock_guard<std::mutex> lock(mutex);
-    TerrainType type = terrain[pos.x][pos.y];
+    TerrainType type = terrain[pos.x * MAP_SIZE + pos.y];
     return type == TerrainType::PLAIN || 
            type == TerrainType::BASE_A || 
            type == TerrainType::BASE_B;
@@ -244,25 +455,36 @@ bool GameMap::isValidPosition(const Position& pos) const {
 TerrainType GameMap::getTerrainAt(const Position& pos) const {
     std::lock_guard<std::mutex> lock(mutex);
     if (!isValidPosition(pos)) return TerrainType::MOUNTAIN;
-    return terrain[pos.x][pos.y];
+    return terrain[pos.x * MAP_SIZE + pos.y];
 }
 
 void GameMap::setTerrainAt(const Position& pos, TerrainType type) {
     std::lock_guard<std::mutex> lock(mutex);
-    if (isValidPosition(pos)) {
-        terrain[pos.x][pos.y] = type;
+    if (isValidPosition(pos) && terrain[pos.x * MAP_SIZE + pos.y] != type) {
+        terrain[pos.x * MAP_SIZE + pos.y] = type;
+        bumpRevision();
     }
 }
 
+bool GameMap::assignTerrain(const TerrainGrid& grid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (terrain == grid) return false;
+    terrain = grid;
+    bumpRevision();
+    return true;
+}
+
 // GameModel 实现
-GameModel::GameModel() 
-    : gameOver(false), winner(Team::TEAM_A), turnCount(0),
-      energyTeamA(INITIAL_ENERGY), energyTeamB(INITIAL_ENERGY) {}
+GameModel::GameModel() : GameModel(RngContext::randomSeed()) {}
+
+GameModel::GameModel(uint64_t seed)
+    : spatialIndex(soldierColumns), flowFieldBaseMask(0), gameOver(false), winner(Team::TEAM_A), turnCount(0),
+      energyTeamA(INITIAL_ENERGY), energyTeamB(INITIAL_ENERGY), rng(seed) {}
 
 void GameModel::initialize() {
     // 初始化地图
     gameMap = std::make_unique<GameMap>();
-    gameMap->initialize();
+    gameMap->initialize(rng.stream(RngStreamId::MAP));
     
     // 初始化基地 - Team A（蓝色，上半平面）
     basesTeamA.clear();
@@ -321,33 +543,254 @@ void GameModel::initialize() {
     // 清空士兵列表
     {
         std::lock_guard<std::mutex> lock(soldiersMutex);
+        for (auto& soldier : soldiers) soldier->detach();
         soldiers.clear();
+        soldierColumns.clear();
+        occupancy.clear();
+        spatialIndex.clear();
+        influence = InfluenceMap();
     }
     
     gameOver.store(false);
     turnCount = 0;
     
+    // 新地图需要重新计算流场
+    updateFlowFields(true);
+    
     // 初始化队伍能量
     teams[0].energy = INITIAL_ENERGY;
     teams[1].energy = INITIAL_ENERGY;
+    energyTeamA.store(INITIAL_ENERGY);
+    energyTeamB.store(INITIAL_ENERGY);
+    
+    publishRenderSnapshot();
+}
+
+bool GameModel::saveState(GameState& state) const {
+    std::lock_guard<std::mutex> lock(soldiersMutex);
+    const SoldierColumns& cols = soldierColumns;
+    int alive = 0;
+    for (size_t i = 0; i < cols.size(); i++) {
+        if (cols.isAlive(i)) alive++;
+    }
+    if (alive > GameState::MAX_SOLDIERS) return false;
+    
+    state.terrain = gameMap ? &gameMap->getTerrain() : nullptr;
+    state.turn = turnCount;
+    state.energy[0] = energyTeamA.load();
+    state.energy[1] = energyTeamB.load();
+    state.gameOver = gameOver.load() ? 1 : 0;
+    state.winner = state.gameOver ? static_cast<int8_t>(winner.load()) : -1;
+    state.rng = rng;
+    
+    const std::vector<std::unique_ptr<Base>>* teamBases[2] = {&basesTeamA, &basesTeamB};
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            BaseState& base = state.bases[t][i];
+            base = BaseState{};
+            if (i >= static_cast<int>(teamBases[t]->size())) continue;
+            const Base& source = *(*teamBases[t])[i];
+            base.x = static_cast<uint8_t>(source.getPosition().x);
+            base.y = static_cast<uint8_t>(source.getPosition().y);
+            base.hp = source.getHp();
+        }
+    }
+    
+    // 只保存存活士兵，保持组件存储中的相对顺序
+    int count = 0;
+    for (size_t i = 0; i < cols.size(); i++) {
+        if (!cols.isAlive(i)) continue;
+        SoldierState& soldier = state.soldiers[count++];
+        soldier.x = static_cast<uint8_t>(cols.x[i]);
+        soldier.y = static_cast<uint8_t>(cols.y[i]);
+        soldier.team = cols.team[i];
+        soldier.type = cols.type[i];
+        soldier.hp = static_cast<int16_t>(cols.hp[i]);
+    }
+    state.soldierCount = static_cast<int16_t>(count);
+    return true;
+}
+
+void GameModel::loadState(const GameState& state) {
+    // 地形：与当前地图相同时不复制
+    bool terrainChanged = false;
+    if (!gameMap) {
+        gameMap = std::make_unique<GameMap>();
+        terrainChanged = true;
+    }
+    if (state.terrain) {
+        terrainChanged |= gameMap->assignTerrain(*state.terrain);
+    }
+    
+    // 基地：位置一致时复用已有对象，只更新HP
+    bool basesChanged = false;
+    std::vector<std::unique_ptr<Base>>* teamBases[2] = {&basesTeamA, &basesTeamB};
+    for (int t = 0; t < 2; t++) {
+        auto& list = *teamBases[t];
+        if (list.size() != BASE_COUNT_PER_TEAM) {
+            list.clear();
+            list.resize(BASE_COUNT_PER_TEAM);
+        }
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            const BaseState& saved = state.bases[t][i];
+            Position pos(saved.x, saved.y);
+            if (!list[i] || !(list[i]->getPosition() == pos)) {
+                list[i] = std::make_unique<Base>(pos, static_cast<Team>(t));
+                basesChanged = true;
+            }
+            list[i]->setHp(saved.hp);
+        }
+    }
+    if (basesChanged) {
+        bases.clear();
+        for (const auto& base : basesTeamA) {
+            bases.push_back(std::shared_ptr<Base>(base.get(), [](Base*){}));  // 非拥有型shared_ptr
+        }
+        for (const auto& base : basesTeamB) {
+            bases.push_back(std::shared_ptr<Base>(base.get(), [](Base*){}));
+        }
+    }
+    
+    // 士兵：按快照顺序重新加入（ID重新分配）
+    {
+        std::lock_guard<std::mutex> lock(soldiersMutex);
+        for (auto& soldier : soldiers) soldier->detach();
+        soldiers.clear();
+        soldierColumns.clear();
+        occupancy.clear();
+        spatialIndex.clear();
+        visionGroups.clear();
+        teamVision[0].clear();
+        teamVision[1].clear();
+    }
+    for (int i = 0; i < state.soldierCount; i++) {
+        const SoldierState& saved = state.soldiers[i];
+        auto soldier = std::make_shared<Soldier>(Position(saved.x, saved.y), static_cast<SoldierType>(saved.type),
+                                                 static_cast<Team>(saved.team));
+        soldier->setHp(saved.hp);
+        addSoldier(soldier);
+    }
+    // 密度是增量维护的，载入后整体重建一次（视野在下一回合开始时计算）
+    updateInfluenceMaps();
+    
+    energyTeamA.store(state.energy[0]);
+    energyTeamB.store(state.energy[1]);
+    turnCount = state.turn;
+    rng = state.rng;
+    gameOver.store(state.gameOver != 0);
+    winner.store(state.winner == static_cast<int>(Team::TEAM_B) ? Team::TEAM_B : Team::TEAM_A);
+    
+    updateFlowFields(terrainChanged || basesChanged);
+}
+
+void GameModel::publishRenderSnapshot() {
+    std::lock_guard<std::mutex> lock(soldiersMutex);
+    const SoldierColumns& cols = soldierColumns;
+    renderSnapshot.turn = turnCount;
+    renderSnapshot.soldiers.clear();
+    for (size_t i = 0; i < cols.size(); i++) {
+        if (!cols.isAlive(i)) continue;
+        renderSnapshot.soldiers.push_back(SoldierSnapshot{cols.positionAt(i), cols.typeAt(i), cols.teamAt(i), cols.hp[i]});
+    }
+}
+
+void GameModel::copyRenderSnapshot(RenderSnapshot& out) const {
+    std::lock_guard<std::mutex> lock(soldiersMutex);
+    out.turn = renderSnapshot.turn;
+    out.soldiers.assign(renderSnapshot.soldiers.begin(), renderSnapshot.soldiers.end());
 }
 
 std::vector<std::shared_ptr<Soldier>> GameModel::getSoldiers() const {
     std::lock_guard<std::mutex> lock(soldiersMutex);
-    return soldiers;
+    return std::vector<std::shared_ptr<Soldier>>(soldiers.begin(), soldiers.end());
 }
 
-void GameModel::addSoldier(std::shared_ptr<Soldier> soldier) {
+std::shared_ptr<Soldier> GameModel::getSoldier(SoldierId id) const {
     std::lock_guard<std::mutex> lock(soldiersMutex);
-    soldiers.push_back(soldier);
+    const auto* soldier = soldiers.get(id);
+    return soldier ? *soldier : nullptr;
 }
 
-void GameModel::removeSoldier(std::shared_ptr<Soldier> soldier) {
+SoldierId GameModel::addSoldier(std::shared_ptr<Soldier> soldier) {
     std::lock_guard<std::mutex> lock(soldiersMutex);
-    soldiers.erase(
-        std::remove(soldiers.begin(), soldiers.end(), soldier),
-        soldiers.end()
-    );
+    SoldierId id = soldiers.insert(soldier);
+    if (id == INVALID_SOLDIER_ID) return id;
+    soldier->attach(this, id);
+    soldierColumns.push(*soldier);
+    if (soldier->isAlive()) {
+        occupancy.enter(soldier->getPosition().x, soldier->getPosition().y, id);
+        spatialIndex.insert(soldierColumns.size() - 1);
+        influence.addSoldier(soldier->getTeam(), soldier->getPosition().x, soldier->getPosition().y, 1);
+    }
+    return id;
+}
+
+void GameModel::removeSoldier(SoldierId id) {
+    std::lock_guard<std::mutex> lock(soldiersMutex);
+    int index = soldiers.denseIndexOf(id);
+    if (index < 0) return;
+    soldiers[index]->detach();
+    if (soldierColumns.isAlive(index)) {
+        spatialIndex.remove(index);
+        influence.addSoldier(soldierColumns.teamAt(index), soldierColumns.x[index], soldierColumns.y[index], -1);
+        soldierColumns.setAlive(index, false);
+        occupancy.leave(soldierColumns.x[index], soldierColumns.y[index], id, soldierColumns, soldiers);
+    }
+    size_t last = soldierColumns.size() - 1;
+    if (static_cast<size_t>(index) != last && soldierColumns.isAlive(last)) {
+        spatialIndex.reindex(last, index);
+    }
+    soldiers.erase(id);
+    soldierColumns.swapRemove(static_cast<size_t>(index));
+}
+
+bool GameModel::isOccupied(const Position& pos, SoldierId excludeId) const {
+    int count = occupancy.countAt(pos.x, pos.y);
+    if (count == 0) return false;
+    if (excludeId == INVALID_SOLDIER_ID) return true;
+    
+    // 排除的士兵自己站在该格上时不算占用
+    int index = soldiers.denseIndexOf(excludeId);
+    bool excludeHere = index >= 0 && soldierColumns.isAlive(index) &&
+                       soldierColumns.x[index] == pos.x && soldierColumns.y[index] == pos.y;
+    return count > (excludeHere ? 1 : 0);
+}
+
+SoldierId GameModel::getSoldierIdAt(const Position& pos) const {
+    if (occupancy.countAt(pos.x, pos.y) == 0) return INVALID_SOLDIER_ID;
+    return occupancy.occupant[pos.x * MAP_SIZE + pos.y];
+}
+
+void GameModel::onSoldierMoved(SoldierId id, const Position& pos) {
+    int index = soldiers.denseIndexOf(id);
+    if (index < 0) return;
+    if (soldierColumns.isAlive(index)) {
+        occupancy.leave(soldierColumns.x[index], soldierColumns.y[index], id, soldierColumns, soldiers);
+        occupancy.enter(pos.x, pos.y, id);
+        spatialIndex.move(index, pos.x, pos.y);
+        influence.addSoldier(soldierColumns.teamAt(index), soldierColumns.x[index], soldierColumns.y[index], -1);
+        influence.addSoldier(soldierColumns.teamAt(index), pos.x, pos.y, 1);
+    }
+    soldierColumns.x[index] = pos.x;
+    soldierColumns.y[index] = pos.y;
+}
+
+void GameModel::onSoldierHpChanged(SoldierId id, int hp, bool alive) {
+    int index = soldiers.denseIndexOf(id);
+    if (index < 0) return;
+    soldierColumns.hp[index] = hp;
+    if (alive != soldierColumns.isAlive(index)) {
+        // 死亡的士兵不再占据格子（尸体在回合末清理）
+        if (!alive) spatialIndex.remove(index);
+        soldierColumns.setAlive(static_cast<size_t>(index), alive);
+        influence.addSoldier(soldierColumns.teamAt(index), soldierColumns.x[index], soldierColumns.y[index], alive ? 1 : -1);
+        if (alive) {
+            occupancy.enter(soldierColumns.x[index], soldierColumns.y[index], id);
+            spatialIndex.insert(index);
+        } else {
+            occupancy.leave(soldierColumns.x[index], soldierColumns.y[index], id, soldierColumns, soldiers);
+        }
+    }
 }
 
 void GameModel::setGameOver(Team winningTeam) {
@@ -386,58 +829,82 @@ bool GameModel::spendEnergy(Team team, int amount) {
     return false;
 }
 
+const VisionBoard* GameModel::getSharedVision(SoldierId id) const {
+    int index = soldiers.denseIndexOf(id);
+    if (index < 0) return nullptr;
+    int group = soldierColumns.visionGroup[index];
+    return group >= 0 ? &visionGroups[group] : nullptr;
+}
+
 void GameModel::updateSharedVision() {
     std::lock_guard<std::mutex> lock(soldiersMutex);
+    SoldierColumns& cols = soldierColumns;
+    size_t count = cols.size();
     
-    // 第一步：保存所有士兵当前可见的敌人ID到lastTurnVisibleEnemies
-    for (auto& soldier : soldiers) {
-        if (!soldier->isAlive()) continue;
-        
-        std::set<int> currentVisibleEnemies;
-        Position myPos = soldier->getPosition();
-        Team myTeam = soldier->getTeam();
-        
-        // 遍历所有敌人，找出当前视野内的敌人
-        for (size_t i = 0; i < soldiers.size(); ++i) {
-            const auto& other = soldiers[i];
-            if (!other->isAlive()) continue;
-            if (other->getTeam() == myTeam) continue;
-            
-            Position otherPos = other->getPosition();
-            if (soldier->canSee(otherPos)) {
-                currentVisibleEnemies.insert(static_cast<int>(i));
-            }
+    // 第一步：并查集，把通信距离内的存活队友连成组
+    std::vector<uint32_t> parent(count);
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto find = [&](uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
         }
-        
-        soldier->updateLastTurnVision(currentVisibleEnemies);
+        return i;
+    };
+    for (size_t i = 0; i < count; i++) {
+        if (!cols.isAlive(i)) continue;
+        spatialIndex.forEachInRadius(cols.positionAt(i), COMMUNICATION_RANGE, cols.teamAt(i),
+                                     DistanceMetric::CHEBYSHEV, [&](size_t j) {
+            if (j <= i) return;
+            uint32_t a = find(static_cast<uint32_t>(i));
+            uint32_t b = find(static_cast<uint32_t>(j));
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        });
     }
     
-    // 第二步：为每个士兵收集队友共享的视野
-    for (auto& soldier : soldiers) {
-        if (!soldier->isAlive()) continue;
-        
-        std::set<int> sharedEnemies;
-        Position myPos = soldier->getPosition();
-        Team myTeam = soldier->getTeam();
-        
-        // 遍历所有队友，收集距离<=COMMUNICATION_RANGE的队友的lastTurnVisibleEnemies
-        for (const auto& teammate : soldiers) {
-            if (!teammate->isAlive()) continue;
-            if (teammate->getTeam() != myTeam) continue;
-            if (teammate.get() == soldier.get()) continue;  // 跳过自己
-            
-            Position teammatePos = teammate->getPosition();
-            int distance = myPos.chebyshevDistanceTo(teammatePos);
-            
-            if (distance <= COMMUNICATION_RANGE) {
-                // 合并队友上回合看到的敌人
-                std::set<int> teammateVision = teammate->getLastTurnVisibleEnemies();
-                sharedEnemies.insert(teammateVision.begin(), teammateVision.end());
-            }
+    // 第二步：给每个组分配位图，并上组内所有士兵的视野方块
+    teamVision[0].clear();
+    teamVision[1].clear();
+    visionGroups.clear();
+    std::vector<int32_t> groupOfRoot(count, -1);
+    for (size_t i = 0; i < count; i++) {
+        if (!cols.isAlive(i)) {
+            cols.visionGroup[i] = -1;
+            continue;
         }
-        
-        soldier->updateSharedVision(sharedEnemies);
+        uint32_t root = find(static_cast<uint32_t>(i));
+        if (groupOfRoot[root] < 0) {
+            groupOfRoot[root] = static_cast<int32_t>(visionGroups.size());
+            visionGroups.emplace_back();
+        }
+        int32_t group = groupOfRoot[root];
+        cols.visionGroup[i] = group;
+        visionGroups[group].orSquare(cols.x[i], cols.y[i], cols.typeAt(i));
+        teamVision[cols.team[i]].orSquare(cols.x[i], cols.y[i], cols.typeAt(i));
     }
 }
 
+void GameModel::updateFlowFields(bool force) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < bases.size(); i++) {
+        if (bases[i]->isAlive()) mask |= uint32_t(1) << i;
+    }
+    if (!force && mask == flowFieldBaseMask) return;
+    flowFieldBaseMask = mask;
+    
+    // 队伍A前往队伍B的基地，反之亦然
+    std::vector<Position> targetsForA, targetsForB;
+    for (const auto& base : basesTeamB) {
+        if (base->isAlive()) targetsForA.push_back(base->getPosition());
+    }
+    for (const auto& base : basesTeamA) {
+        if (base->isAlive()) targetsForB.push_back(base->getPosition());
+    }
+    flowFields[static_cast<int>(Team::TEAM_A)].build(*gameMap, targetsForA);
+    flowFields[static_cast<int>(Team::TEAM_B)].build(*gameMap, targetsForB);
+}
 
+void GameModel::updateInfluenceMaps() {
+    std::lock_guard<std::mutex> lock(soldiersMutex);
+    influence.rebuild(soldierColumns);
+}
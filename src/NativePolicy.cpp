@@ -0,0 +1,230 @@
+// NativePolicy.cpp - 原生策略网络推理实现
+#include "../include/NativePolicy.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// x86 上 AVX2/FMA 内核只编译这几个函数（target 属性），运行时检测CPU后再选用，
+// 不支持 AVX2 的机器走标量实现；ARM64 上 NEON 总是可用
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NATIVE_POLICY_AVX2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define NATIVE_POLICY_NEON 1
+#endif
+
+// 权重文件格式常量（与 export_weights.py 保持一致）
+static constexpr char WEIGHTS_MAGIC[4] = {'D', 'S', 'P', 'N'};
+static constexpr uint32_t WEIGHTS_VERSION = 1;
+static constexpr uint32_t ACTIVATION_MISH = 1;
+
+// SIMD宽度：权重行和输入向量都补齐到8个float
+static constexpr int SIMD_WIDTH = 8;
+
+static int alignToSimd(int n) {
+    return (n + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+}
+
+// 点积：n 必须是 SIMD_WIDTH 的倍数
+using DotProductFn = float (*)(const float* a, const float* b, int n);
+
+static float dotProductScalar(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(NATIVE_POLICY_AVX2)
+__attribute__((target("avx2,fma")))
+static float dotProductAvx2(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i < n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+#elif defined(NATIVE_POLICY_NEON)
+static float dotProductNeon(const float* a, const float* b, int n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1));
+}
+#endif
+
+static DotProductFn selectDotProduct() {
+#if defined(NATIVE_POLICY_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return dotProductAvx2;
+    }
+    return dotProductScalar;
+#elif defined(NATIVE_POLICY_NEON)
+    return dotProductNeon;
+#else
+    return dotProductScalar;
+#endif
+}
+
+static const DotProductFn dotProduct = selectDotProduct();
+
+// Mish(x) = x * tanh(softplus(x))
+// 利用 tanh(log(1+e^x)) = n / (n + 2)，其中 n = e^x * (e^x + 2)，只需一次exp
+static inline float mish(float x) {
+    if (x > 20.0f) return x;
+    float e = std::exp(x);
+    float n = e * (e + 2.0f);
+    return x * n / (n + 2.0f);
+}
+
+NativePolicy::NativePolicy() : loaded(false) {}
+
+bool NativePolicy::load(const std::string& path) {
+    loaded = false;
+    layers.reset();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open native policy weights: " << path << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, layerCount = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&layerCount), sizeof(layerCount));
+    if (!file || std::memcmp(magic, WEIGHTS_MAGIC, sizeof(magic)) != 0 || version != WEIGHTS_VERSION) {
+        std::cerr << "Invalid native policy weights file: " << path << std::endl;
+        return false;
+    }
+
+    // 读取层描述
+    std::vector<Layer> built;
+    for (uint32_t i = 0; i < layerCount; i++) {
+        uint32_t header[3];
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        Layer layer;
+        layer.inFeatures = static_cast<int>(header[0]);
+        layer.outFeatures = static_cast<int>(header[1]);
+        layer.stride = alignToSimd(layer.inFeatures);
+        layer.mish = (header[2] == ACTIVATION_MISH);
+        built.push_back(std::move(layer));
+    }
+
+    // 校验网络结构：首层输入79维，末层输出10维，层间维度衔接
+    if (!file || built.empty() ||
+        built.front().inFeatures != FEATURE_DIM || built.back().outFeatures != OUTPUT_DIM) {
+        std::cerr << "Unexpected native policy shape in " << path << std::endl;
+        return false;
+    }
+    for (size_t i = 1; i < built.size(); i++) {
+        if (built[i].inFeatures != built[i - 1].outFeatures) {
+            std::cerr << "Mismatched layer sizes in " << path << std::endl;
+            return false;
+        }
+    }
+
+    // 读取权重，按行补齐到SIMD宽度
+    int maxWidth = 0;
+    for (auto& layer : built) {
+        layer.weights.assign(static_cast<size_t>(layer.outFeatures) * layer.stride, 0.0f);
+        layer.bias.resize(layer.outFeatures);
+        for (int row = 0; row < layer.outFeatures; row++) {
+            file.read(reinterpret_cast<char*>(&layer.weights[static_cast<size_t>(row) * layer.stride]),
+                      sizeof(float) * layer.inFeatures);
+        }
+        file.read(reinterpret_cast<char*>(layer.bias.data()), sizeof(float) * layer.outFeatures);
+        maxWidth = std::max({maxWidth, layer.stride, alignToSimd(layer.outFeatures)});
+    }
+    if (!file) {
+        std::cerr << "Truncated native policy weights file: " << path << std::endl;
+        return false;
+    }
+
+    layers = std::make_shared<const std::vector<Layer>>(std::move(built));
+    bufferA.assign(maxWidth, 0.0f);
+    bufferB.assign(maxWidth, 0.0f);
+    loaded = true;
+    std::cout << "Native policy loaded: " << path << std::endl;
+    return true;
+}
+
+void NativePolicy::forward(const float* features, float* logits) {
+    // 输入复制到补齐过的缓冲区（补齐部分保持为0）
+    std::fill(bufferA.begin(), bufferA.end(), 0.0f);
+    std::copy(features, features + FEATURE_DIM, bufferA.begin());
+
+    float* input = bufferA.data();
+    float* output = bufferB.data();
+
+    for (const auto& layer : *layers) {
+        const float* w = layer.weights.data();
+        for (int row = 0; row < layer.outFeatures; row++) {
+            float value = dotProduct(w + static_cast<size_t>(row) * layer.stride, input, layer.stride) + layer.bias[row];
+            output[row] = layer.mish ? mish(value) : value;
+        }
+        // 清零补齐部分，作为下一层的输入
+        std::fill(output + layer.outFeatures, output + alignToSimd(layer.outFeatures), 0.0f);
+        std::swap(input, output);
+    }
+
+    std::copy(input, input + OUTPUT_DIM, logits);
+}
+
+Action NativePolicy::getAction(const Observation& obs) {
+    if (!loaded) return Action::wait();
+
+    float features[FEATURE_DIM];
+    FeatureEncoder::encode(obs, features);
+    int myBaseCount = obs.myBaseCount > 0 ? obs.myBaseCount : obs.myBaseEntries;
+    return decide(features, obs.myEnergy, myBaseCount);
+}
+
+Action NativePolicy::decide(const float* features, int myEnergy, int myBaseCount) {
+    float logits[OUTPUT_DIM];
+    forward(features, logits);
+
+    // 动态调整logits：能量越多越倾向出兵（与 model_policy 一致）
+    float* actionLogits = logits;
+    if (myEnergy > 100) {
+        actionLogits[0] -= std::min((myEnergy - 100) * 0.5f, 50.0f);
+    }
+    if (myEnergy > 300) {
+        actionLogits[0] -= 100.0f;
+    }
+
+    // argmax（并列时取第一个，与 torch.argmax 一致）
+    auto argmax = [](const float* values, int count) {
+        return static_cast<int>(std::max_element(values, values + count) - values);
+    };
+    int actionType = argmax(actionLogits, ACTION_TYPE_COUNT);
+    int baseId = argmax(logits + ACTION_TYPE_COUNT, BASE_ID_COUNT);
+    int unitType = argmax(logits + ACTION_TYPE_COUNT + BASE_ID_COUNT, UNIT_TYPE_COUNT);
+
+    if (actionType == 0) return Action::wait();
+
+    if (baseId >= myBaseCount) {
+        baseId = 0;  // 降级到第一个基地
+    }
+
+    return Action::spawn(baseId, static_cast<GameConstants::SoldierType>(unitType));
+}
@@ -0,0 +1,111 @@
+// Observation.cpp - 观测的JSON序列化（不构建JSON DOM）
+#include "../include/Observation.h"
+#include <charconv>
+#include <cstring>
+
+static void appendLiteral(std::string& out, const char* text) {
+    out.append(text, std::strlen(text));
+}
+
+static void appendInt(std::string& out, int value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// 与 nlohmann::json 的浮点输出一致：按 double 输出最短可往返的定点表示，整数值补 ".0"
+static void appendFloat(std::string& out, float value) {
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(value), std::chars_format::fixed);
+    out.append(buffer, result.ptr);
+    if (std::memchr(buffer, '.', result.ptr - buffer) == nullptr) {
+        out.append(".0");
+    }
+}
+
+// 追加 "key":value（key 以逗号或左括号开头，由调用者按字母序给出）
+static void appendField(std::string& out, const char* key, int value) {
+    appendLiteral(out, key);
+    appendInt(out, value);
+}
+
+static void appendTypeCounts(std::string& out, const int* counts) {
+    appendField(out, "{\"archer_count\":", counts[static_cast<int>(SoldierType::ARCHER)]);
+    appendField(out, ",\"caster_count\":", counts[static_cast<int>(SoldierType::CASTER)]);
+    appendField(out, ",\"cavalry_count\":", counts[static_cast<int>(SoldierType::CAVALRY)]);
+    appendField(out, ",\"doctor_count\":", counts[static_cast<int>(SoldierType::DOCTOR)]);
+    appendField(out, ",\"infantry_count\":", counts[static_cast<int>(SoldierType::INFANTRY)]);
+    out.push_back('}');
+}
+
+void writeObservationJson(const Observation& obs, std::string& out) {
+    // 键的顺序与 nlohmann::json 的 std::map 排序一致（字母序）
+    appendField(out, "{\"enemy_base_count\":", obs.enemyBaseCount);
+
+    appendLiteral(out, ",\"enemy_bases\":[");
+    for (int i = 0; i < obs.enemyBaseEntries; i++) {
+        const BaseObservation& base = obs.enemyBases[i];
+        if (i > 0) out.push_back(',');
+        appendField(out, "{\"distance_to_nearest_my_base\":", base.distanceToNearestMyBase);
+        appendField(out, ",\"hp\":", base.hp);
+        appendField(out, ",\"max_hp\":", base.maxHp);
+        appendField(out, ",\"x\":", base.x);
+        appendField(out, ",\"y\":", base.y);
+        out.push_back('}');
+    }
+    out.push_back(']');
+
+    appendField(out, ",\"enemy_energy\":", obs.enemyEnergy);
+    appendField(out, ",\"enemy_heal_done\":", obs.enemyHealDone);
+    appendField(out, ",\"enemy_soldier_count\":", obs.enemySoldierCount);
+    appendLiteral(out, ",\"enemy_soldier_types\":");
+    appendTypeCounts(out, obs.enemyTypeCounts);
+    appendField(out, ",\"enemy_total_base_hp\":", obs.enemyTotalBaseHp);
+    appendLiteral(out, obs.gameOver ? ",\"game_over\":true" : ",\"game_over\":false");
+    appendField(out, ",\"my_base_count\":", obs.myBaseCount);
+
+    appendLiteral(out, ",\"my_bases\":[");
+    for (int i = 0; i < obs.myBaseEntries; i++) {
+        const BaseObservation& base = obs.myBases[i];
+        if (i > 0) out.push_back(',');
+        appendField(out, "{\"hp\":", base.hp);
+        appendField(out, ",\"max_hp\":", base.maxHp);
+        appendField(out, ",\"nearby_allies\":", base.nearbyAllies);
+        appendField(out, ",\"nearby_enemies\":", base.nearbyEnemies);
+        appendField(out, ",\"x\":", base.x);
+        appendField(out, ",\"y\":", base.y);
+        out.push_back('}');
+    }
+    out.push_back(']');
+
+    appendField(out, ",\"my_energy\":", obs.myEnergy);
+    appendField(out, ",\"my_heal_done\":", obs.myHealDone);
+    appendField(out, ",\"my_soldier_count\":", obs.mySoldierCount);
+    appendLiteral(out, ",\"my_soldier_types\":");
+    appendTypeCounts(out, obs.myTypeCounts);
+    appendField(out, ",\"my_team\":", obs.myTeam);
+    appendField(out, ",\"my_total_base_hp\":", obs.myTotalBaseHp);
+
+    appendLiteral(out, ",\"soldier_distribution\":{\"enemy_avg_x\":");
+    appendFloat(out, obs.enemyAvgX);
+    appendLiteral(out, ",\"enemy_avg_y\":");
+    appendFloat(out, obs.enemyAvgY);
+    appendField(out, ",\"enemy_front_soldier_count\":", obs.enemyFrontCount);
+    appendLiteral(out, ",\"my_avg_x\":");
+    appendFloat(out, obs.myAvgX);
+    appendLiteral(out, ",\"my_avg_y\":");
+    appendFloat(out, obs.myAvgY);
+    appendField(out, ",\"my_front_soldier_count\":", obs.myFrontCount);
+    out.push_back('}');
+
+    appendField(out, ",\"turn\":", obs.turn);
+    appendField(out, ",\"winner\":", obs.winner);
+    out.push_back('}');
+}
+
+std::string observationToJson(const Observation& obs) {
+    std::string out;
+    out.reserve(1024);
+    writeObservationJson(obs, out);
+    return out;
+}
@@ -1,9 +1,28 @@
 #include "../include/PythonAgent.h"
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <unistd.h>
 #include <climits>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+// 默认的等待动作
+static const char* WAIT_ACTION = "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
+
+// 超时配置：首次启动需要导入torch并加载模型，较慢
+static constexpr int STARTUP_TIMEOUT_MS = 60000;
+static constexpr int REQUEST_TIMEOUT_MS = 5000;
+
+// 关闭管道后等待Python自行退出的时间，超时后依次发送SIGTERM/SIGKILL
+static constexpr int EXIT_GRACE_MS = 200;
+static constexpr int TERMINATE_TIMEOUT_MS = 500;
+
+// 单帧最大长度（防止读到错误数据时分配过大内存）
+static constexpr uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
 
 // 读取Python解释器路径配置
 static std::string getPythonPath() {
@@ -24,8 +43,19 @@ static std::string getPythonPath() {
     return "python3";
 }
 
-PythonAgent::PythonAgent() 
-    : pythonProcess(nullptr), pythonInput(nullptr), initialized(false) {
+// 在 timeoutMs 内轮询回收子进程，成功回收返回 true
+static bool reapChild(pid_t pid, int timeoutMs) {
+    for (int waited = 0; ; waited += 10) {
+        int status = 0;
+        pid_t result = waitpid(pid, &status, WNOHANG);
+        if (result == pid || (result < 0 && errno != EINTR)) return true;
+        if (waited >= timeoutMs) return false;
+        usleep(10 * 1000);
+    }
+}
+
+PythonAgent::PythonAgent()
+    : pythonPid(-1), toPython(-1), fromPython(-1), initialized(false) {
 }
 
 PythonAgent::~PythonAgent() {
@@ -33,6 +63,9 @@ PythonAgent::~PythonAgent() {
 }
 
 bool PythonAgent::initialize(const std::string& path) {
+    // 重复初始化时先关闭旧进程
+    shutdown();
+
     // 转换为绝对路径
     char absPath[PATH_MAX];
     if (realpath(path.c_str(), absPath) != nullptr) {
@@ -46,81 +79,176 @@ bool PythonAgent::initialize(const std::string& path) {
             scriptPath = path;  // 降级使用原始路径
         }
     }
-    
-    std::cout << "Python agent initialized: " << scriptPath << std::endl;
-    
-    // 获取Python解释器路径
+
+    // 获取Python解释器路径（只读取一次配置）
     std::string pythonCmd = getPythonPath();
-    
-    // 使用popen启动Python进程
-    std::string command = pythonCmd + " " + scriptPath;
-    
-    pythonProcess = popen(command.c_str(), "w");
-    if (!pythonProcess) {
-        std::cerr << "Failed to start Python process: " << scriptPath << std::endl;
+
+    // Python进程退出后写管道会触发SIGPIPE，忽略它，改为通过write返回值处理
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // 创建两条管道：C++ -> Python(stdin)，Python(stdout) -> C++
+    // 创建时就带 O_CLOEXEC：多个对局线程可能同时 fork，其他对局的子进程不能继承这里的管道端
+    // （否则关闭 toPython 后服务端收不到EOF）；子进程中 dup2 得到的 stdin/stdout 不带该标志
+    int inPipe[2], outPipe[2];
+    if (pipe2(inPipe, O_CLOEXEC) != 0) {
+        std::cerr << "Failed to create pipe: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (pipe2(outPipe, O_CLOEXEC) != 0) {
+        std::cerr << "Failed to create pipe: " << std::strerror(errno) << std::endl;
+        close(inPipe[0]);
+        close(inPipe[1]);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Failed to fork Python process: " << std::strerror(errno) << std::endl;
+        close(inPipe[0]); close(inPipe[1]);
+        close(outPipe[0]); close(outPipe[1]);
         return false;
     }
-    
+
+    if (pid == 0) {
+        // 子进程：把管道接到stdin/stdout，stderr保持继承以便查看调试输出
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        close(inPipe[0]); close(inPipe[1]);
+        close(outPipe[0]); close(outPipe[1]);
+        execlp(pythonCmd.c_str(), pythonCmd.c_str(), scriptPath.c_str(), "--server", static_cast<char*>(nullptr));
+        // exec失败
+        std::fprintf(stderr, "Failed to exec %s: %s\n", pythonCmd.c_str(), std::strerror(errno));
+        _exit(127);
+    }
+
+    // 父进程：保留写端和读端
+    close(inPipe[0]);
+    close(outPipe[1]);
+    toPython = inPipe[1];
+    fromPython = outPipe[0];
+    pythonPid = pid;
+
+    // 等待服务端的就绪帧（模型加载完成）
+    std::string ready;
+    if (!readFrame(ready, STARTUP_TIMEOUT_MS)) {
+        std::cerr << "Python inference server did not become ready: " << scriptPath << std::endl;
+        shutdown();
+        return false;
+    }
+
     initialized = true;
-    std::cout << "Python agent initialized: " << scriptPath << std::endl;
+    std::cout << "Python agent initialized: " << scriptPath << " " << ready << std::endl;
     return true;
 }
 
 JsonString PythonAgent::getAction(const JsonString& stateJson) {
     if (!initialized) {
         std::cerr << "Python agent not initialized!" << std::endl;
-        return "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
+        return WAIT_ACTION;
+    }
+
+    // 发送状态帧，读取动作帧
+    std::string actionStr;
+    if (!writeFrame(stateJson) || !readFrame(actionStr, REQUEST_TIMEOUT_MS)) {
+        std::cerr << "Python inference server failed, falling back to wait actions" << std::endl;
+        shutdown();
+        return WAIT_ACTION;
     }
 
-    // 写入状态
-    std::ofstream stateFile("/tmp/game_state.json");
-    stateFile << stateJson;
-    stateFile.close();
-    
-    // 调用Python推理
-    std::string pythonCmd = getPythonPath();
-    // 将stderr重定向到文件以便调试，避免丢弃
-    std::string command = pythonCmd + " " + scriptPath + " /tmp/game_state.json > /tmp/game_action.json 2>/tmp/python_stderr.log";
-
-    std::cerr << "[DEBUG PythonAgent] Command: " << command << std::endl;
-    int result = system(command.c_str());
-    std::cerr << "[DEBUG PythonAgent] System result: " << result << std::endl;
-
-    // 读取stderr日志（如果有错误）
-    std::ifstream stderrFile("/tmp/python_stderr.log");
-    if (stderrFile.is_open()) {
-        std::string errorContent((std::istreambuf_iterator<char>(stderrFile)),
-                                std::istreambuf_iterator<char>());
-        if (!errorContent.empty()) {
-            std::cerr << "[DEBUG PythonAgent] Python stderr: " << errorContent << std::endl;
-        }
-        stderrFile.close();
-    }
-    
-    if (result != 0) {
-        std::cerr << "Python inference failed with code: " << result << std::endl;
-        return "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
-    }
-    
-    // 读取动作
-    std::ifstream actionFile("/tmp/game_action.json");
-    if (!actionFile.is_open()) {
-        std::cerr << "[DEBUG PythonAgent] Failed to open action file!" << std::endl;
-        return "{\"action_type\": 0, \"base_id\": -1, \"unit_type\": -1}";
-    }
-    
-    std::stringstream buffer;
-    buffer << actionFile.rdbuf();
-    std::string actionStr = buffer.str();
-    std::cerr << "[DEBUG PythonAgent] Read action: " << actionStr << " (length=" << actionStr.length() << ")" << std::endl;
-    
     return actionStr;
 }
 
 void PythonAgent::shutdown() {
-    if (pythonProcess) {
-        pclose(pythonProcess);
-        pythonProcess = nullptr;
+    // 关闭写端，Python读到EOF后自行退出
+    if (toPython >= 0) {
+        close(toPython);
+        toPython = -1;
+    }
+    if (fromPython >= 0) {
+        close(fromPython);
+        fromPython = -1;
+    }
+    // 进程可能卡住（请求超时正是这种情况），不能无限期阻塞在 waitpid 上
+    if (pythonPid > 0) {
+        if (!reapChild(pythonPid, EXIT_GRACE_MS)) {
+            kill(pythonPid, SIGTERM);
+            if (!reapChild(pythonPid, TERMINATE_TIMEOUT_MS)) {
+                std::cerr << "Python inference server did not exit, killing it" << std::endl;
+                kill(pythonPid, SIGKILL);
+                int status = 0;
+                while (waitpid(pythonPid, &status, 0) < 0 && errno == EINTR) {}
+            }
+        }
+        pythonPid = -1;
     }
     initialized = false;
 }
+
+bool PythonAgent::writeFrame(const std::string& payload) {
+    // 帧头：4字节大端长度
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    unsigned char header[4] = {
+        static_cast<unsigned char>(size >> 24),
+        static_cast<unsigned char>(size >> 16),
+        static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size)
+    };
+    return writeAll(header, sizeof(header)) && writeAll(payload.data(), payload.size());
+}
+
+bool PythonAgent::readFrame(std::string& payload, int timeoutMs) {
+    unsigned char header[4];
+    if (!readAll(header, sizeof(header), timeoutMs)) return false;
+
+    uint32_t size = (static_cast<uint32_t>(header[0]) << 24) |
+                    (static_cast<uint32_t>(header[1]) << 16) |
+                    (static_cast<uint32_t>(header[2]) << 8) |
+                    static_cast<uint32_t>(header[3]);
+    if (size > MAX_FRAME_SIZE) {
+        std::cerr << "Python frame too large: " << size << " bytes" << std::endl;
+        return false;
+    }
+
+    payload.resize(size);
+    return readAll(payload.data(), size, timeoutMs);
+}
+
+bool PythonAgent::writeAll(const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(toPython, ptr, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool PythonAgent::readAll(void* data, size_t size, int timeoutMs) {
+    char* ptr = static_cast<char*>(data);
+    while (size > 0) {
+        pollfd pfd{fromPython, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (ready == 0) {
+            std::cerr << "Timed out waiting for Python inference server" << std::endl;
+            return false;
+        }
+
+        ssize_t n = read(fromPython, ptr, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;  // Python进程已退出
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,437 @@
+// Replay.cpp - 比赛录像的写入与回放
+#include "../include/Replay.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+constexpr uint8_t FLAG_KEYFRAME = 1;
+constexpr uint8_t FLAG_GAME_OVER = 2;
+constexpr uint8_t CHANGED_X = 1;
+constexpr uint8_t CHANGED_Y = 2;
+constexpr uint8_t CHANGED_HP = 4;
+constexpr size_t HEADER_SIZE = 4 + 4 + 8 + 4 + 2 + 2 * BASE_COUNT_PER_TEAM * 2 + MAP_SIZE * MAP_SIZE;
+
+void putFixed(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putZigzag(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void putSoldier(std::string& out, const ReplaySoldier& soldier, uint32_t& lastId) {
+    putVarint(out, soldier.id - lastId);
+    lastId = soldier.id;
+    out.push_back(static_cast<char>(soldier.x));
+    out.push_back(static_cast<char>(soldier.y));
+    out.push_back(static_cast<char>((soldier.team << 4) | soldier.type));
+    putVarint(out, static_cast<uint32_t>(soldier.hp));
+}
+
+// 有界读取：越界或数据不完整时 ok 变为 false，之后的读取都返回0
+struct Reader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t fixed(int bytes) {
+        if (pos + bytes > size) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(data[pos + i]) << (8 * i);
+        pos += bytes;
+        return value;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= size) break;
+            uint8_t byte = data[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t zigzag() {
+        uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool soldier(ReplaySoldier& soldier, uint32_t& lastId) {
+        soldier.id = lastId + static_cast<uint32_t>(varint());
+        lastId = soldier.id;
+        soldier.x = static_cast<uint8_t>(fixed(1));
+        soldier.y = static_cast<uint8_t>(fixed(1));
+        uint8_t teamType = static_cast<uint8_t>(fixed(1));
+        soldier.team = teamType >> 4;
+        soldier.type = teamType & 0x0F;
+        soldier.hp = static_cast<int32_t>(varint());
+        return ok;
+    }
+};
+
+} // namespace
+
+// ReplayRecorder 实现
+ReplayRecorder::ReplayRecorder(const std::string& path, PlayerType team0, PlayerType team1, int keyframeInterval)
+    : out(path, std::ios::binary | std::ios::trunc), teamTypes{team0, team1},
+      keyframeInterval(std::max(1, keyframeInterval)), frames(0), nextReplayId(0) {
+    if (!out) {
+        std::cerr << "Cannot open replay file " << path << std::endl;
+    }
+}
+
+uint8_t ReplayRecorder::encodeAction(const Action& action) {
+    if (action.isWait() || action.baseId < 0) return 0;
+    return static_cast<uint8_t>(1 + action.baseId * SOLDIER_TYPE_COUNT + static_cast<int>(action.unit));
+}
+
+Action ReplayRecorder::decodeAction(uint8_t code) {
+    if (code == 0) return Action::wait();
+    return Action::spawn((code - 1) / SOLDIER_TYPE_COUNT, static_cast<SoldierType>((code - 1) % SOLDIER_TYPE_COUNT));
+}
+
+void ReplayRecorder::writeHeader(const GameModel& model) {
+    buffer.clear();
+    buffer.append(MAGIC, sizeof(MAGIC));
+    putFixed(buffer, VERSION, 4);
+    putFixed(buffer, model.getSeed(), 8);
+    putFixed(buffer, static_cast<uint32_t>(keyframeInterval), 4);
+    buffer.push_back(static_cast<char>(teamTypes[0]));
+    buffer.push_back(static_cast<char>(teamTypes[1]));
+
+    const std::vector<std::unique_ptr<Base>>* teamBases[2] = {&model.getBasesTeamA(), &model.getBasesTeamB()};
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            Position pos = i < static_cast<int>(teamBases[t]->size()) ? (*teamBases[t])[i]->getPosition() : Position(0, 0);
+            buffer.push_back(static_cast<char>(pos.x));
+            buffer.push_back(static_cast<char>(pos.y));
+        }
+    }
+
+    const GameMap* map = model.getMap();
+    for (int i = 0; i < MAP_SIZE * MAP_SIZE; i++) {
+        buffer.push_back(static_cast<char>(map ? map->getTerrain()[i] : TerrainType::PLAIN));
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void ReplayRecorder::capture(const GameModel& model, ReplayFrame& frame) {
+    frame.energy[0] = model.getEnergy(Team::TEAM_A);
+    frame.energy[1] = model.getEnergy(Team::TEAM_B);
+    frame.gameOver = model.isGameOver();
+    frame.winner = frame.gameOver ? static_cast<int>(model.getWinner()) : -1;
+
+    const std::vector<std::unique_ptr<Base>>* teamBases[2] = {&model.getBasesTeamA(), &model.getBasesTeamB()};
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            frame.baseHp[t][i] = i < static_cast<int>(teamBases[t]->size()) ? (*teamBases[t])[i]->getHp() : 0;
+        }
+    }
+
+    // 新出现的士兵按遍历顺序编号，编号总是大于已有的士兵
+    const SoldierColumns& cols = model.getSoldierColumns();
+    frame.soldiers.clear();
+    for (size_t i = 0; i < cols.size(); i++) {
+        if (!cols.isAlive(i)) continue;
+        auto inserted = replayIds.try_emplace(model.soldiers.handleAt(i), nextReplayId);
+        if (inserted.second) nextReplayId++;
+        frame.soldiers.push_back({inserted.first->second, static_cast<uint8_t>(cols.x[i]),
+                                  static_cast<uint8_t>(cols.y[i]), cols.team[i], cols.type[i], cols.hp[i]});
+    }
+    std::sort(frame.soldiers.begin(), frame.soldiers.end(),
+              [](const ReplaySoldier& a, const ReplaySoldier& b) { return a.id < b.id; });
+}
+
+void ReplayRecorder::record(const GameModel& model, const Action& team0Action, const Action& team1Action) {
+    if (!out) return;
+    if (frames == 0) writeHeader(model);
+
+    capture(model, current);
+    bool keyframe = frames % keyframeInterval == 0;
+
+    buffer.clear();
+    buffer.push_back(static_cast<char>((keyframe ? FLAG_KEYFRAME : 0) | (current.gameOver ? FLAG_GAME_OVER : 0)));
+    buffer.push_back(static_cast<char>(encodeAction(team0Action)));
+    buffer.push_back(static_cast<char>(encodeAction(team1Action)));
+    putVarint(buffer, static_cast<uint32_t>(std::max(0, current.energy[0])));
+    putVarint(buffer, static_cast<uint32_t>(std::max(0, current.energy[1])));
+
+    if (keyframe) {
+        for (int t = 0; t < 2; t++) {
+            for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) putVarint(buffer, static_cast<uint32_t>(std::max(0, current.baseHp[t][i])));
+        }
+        putVarint(buffer, current.soldiers.size());
+        uint32_t lastId = 0;
+        for (const auto& soldier : current.soldiers) putSoldier(buffer, soldier, lastId);
+    } else {
+        for (int t = 0; t < 2; t++) {
+            for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) putZigzag(buffer, current.baseHp[t][i] - previous.baseHp[t][i]);
+        }
+
+        // 两个列表都按ID递增，一次归并得到死亡、变化和新出现的士兵
+        std::vector<uint32_t> removed;
+        std::vector<std::pair<const ReplaySoldier*, const ReplaySoldier*>> changed;
+        size_t p = 0;
+        size_t c = 0;
+        while (p < previous.soldiers.size() || c < current.soldiers.size()) {
+            if (c == current.soldiers.size() ||
+                (p < previous.soldiers.size() && previous.soldiers[p].id < current.soldiers[c].id)) {
+                removed.push_back(previous.soldiers[p++].id);
+            } else if (p == previous.soldiers.size() || current.soldiers[c].id < previous.soldiers[p].id) {
+                break;  // 剩下的都是新出现的士兵
+            } else {
+                const ReplaySoldier& before = previous.soldiers[p++];
+                const ReplaySoldier& after = current.soldiers[c++];
+                if (before.x != after.x || before.y != after.y || before.hp != after.hp) {
+                    changed.emplace_back(&before, &after);
+                }
+            }
+        }
+
+        putVarint(buffer, removed.size());
+        uint32_t lastId = 0;
+        for (uint32_t id : removed) {
+            putVarint(buffer, id - lastId);
+            lastId = id;
+        }
+
+        putVarint(buffer, changed.size());
+        lastId = 0;
+        for (const auto& [before, after] : changed) {
+            putVarint(buffer, after->id - lastId);
+            lastId = after->id;
+            uint8_t mask = (before->x != after->x ? CHANGED_X : 0) | (before->y != after->y ? CHANGED_Y : 0) |
+                           (before->hp != after->hp ? CHANGED_HP : 0);
+            buffer.push_back(static_cast<char>(mask));
+            if (mask & CHANGED_X) putZigzag(buffer, after->x - before->x);
+            if (mask & CHANGED_Y) putZigzag(buffer, after->y - before->y);
+            if (mask & CHANGED_HP) putZigzag(buffer, after->hp - before->hp);
+        }
+
+        putVarint(buffer, current.soldiers.size() - c);
+        lastId = 0;
+        for (; c < current.soldiers.size(); c++) putSoldier(buffer, current.soldiers[c], lastId);
+    }
+
+    if (current.gameOver) buffer.push_back(static_cast<char>(current.winner));
+
+    std::string length;
+    putVarint(length, buffer.size());
+    out.write(length.data(), static_cast<std::streamsize>(length.size()));
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    std::swap(previous, current);
+    frames++;
+}
+
+// ReplayPlayer 实现
+bool ReplayPlayer::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    records.clear();
+    keyframes.clear();
+    currentIndex = -1;
+
+    Reader reader{reinterpret_cast<const uint8_t*>(data.data()), data.size()};
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), ReplayRecorder::MAGIC, 4) != 0) {
+        error = path + " is not a replay file";
+        return false;
+    }
+    reader.pos = 4;
+    if (reader.fixed(4) != ReplayRecorder::VERSION) {
+        error = path + " has an unsupported replay version";
+        return false;
+    }
+    seed = reader.fixed(8);
+    reader.fixed(4);  // 关键帧间隔（以记录中的标志为准）
+    teamTypes[0] = static_cast<PlayerType>(reader.fixed(1));
+    teamTypes[1] = static_cast<PlayerType>(reader.fixed(1));
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            basePositions[t][i][0] = static_cast<uint8_t>(reader.fixed(1));
+            basePositions[t][i][1] = static_cast<uint8_t>(reader.fixed(1));
+        }
+    }
+    for (auto& cell : terrain) {
+        uint8_t type = static_cast<uint8_t>(reader.fixed(1));
+        if (type > static_cast<uint8_t>(TerrainType::BASE_B)) {
+            error = path + " has an invalid terrain type";
+            return false;
+        }
+        cell = static_cast<TerrainType>(type);
+    }
+
+    // 只建立索引；末尾不完整的记录（录制中断）被忽略
+    while (reader.pos < data.size()) {
+        uint64_t length = reader.varint();
+        if (!reader.ok || length == 0 || reader.pos + length > data.size()) break;
+        bool keyframe = static_cast<uint8_t>(data[reader.pos]) & FLAG_KEYFRAME;
+        if (keyframe) keyframes.push_back(static_cast<int>(records.size()));
+        records.push_back({reader.pos, static_cast<size_t>(length), keyframe});
+        reader.pos += length;
+    }
+
+    if (keyframes.empty() || keyframes.front() != 0) {
+        error = path + " has no frames";
+        return false;
+    }
+    return seek(0);
+}
+
+bool ReplayPlayer::seek(int index) {
+    index = std::clamp(index, 0, frameCount() - 1);
+    if (index == currentIndex) return true;
+
+    // 最近的关键帧在当前位置之后（或需要后退）时从关键帧开始
+    int keyframe = *(std::upper_bound(keyframes.begin(), keyframes.end(), index) - 1);
+    int start = currentIndex + 1;
+    if (currentIndex < keyframe || currentIndex > index) start = keyframe;
+
+    for (int i = start; i <= index; i++) {
+        if (!apply(records[i])) {
+            error = "corrupt replay record " + std::to_string(i);
+            currentIndex = -1;
+            return false;
+        }
+        currentIndex = i;
+    }
+
+    // 放不进 GameState 的局面不截断（否则回放显示的局面与录像不符）
+    if (!fitsState(index)) {
+        currentIndex = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayPlayer::fitsState(int index) {
+    if (current.soldiers.size() > static_cast<size_t>(GameState::MAX_SOLDIERS)) {
+        error = "replay record " + std::to_string(index) + " has " + std::to_string(current.soldiers.size()) +
+                " soldiers, more than a game state holds (" + std::to_string(GameState::MAX_SOLDIERS) + ")";
+        return false;
+    }
+    for (const auto& soldier : current.soldiers) {
+        if (soldier.hp < std::numeric_limits<int16_t>::min() || soldier.hp > std::numeric_limits<int16_t>::max()) {
+            error = "replay record " + std::to_string(index) + " has a soldier with HP " + std::to_string(soldier.hp) +
+                    ", outside the game state range";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ReplayPlayer::apply(const Record& record) {
+    Reader reader{reinterpret_cast<const uint8_t*>(data.data()) + record.offset, record.length};
+    uint8_t flags = static_cast<uint8_t>(reader.fixed(1));
+    current.actions[0] = static_cast<uint8_t>(reader.fixed(1));
+    current.actions[1] = static_cast<uint8_t>(reader.fixed(1));
+    current.energy[0] = static_cast<int32_t>(reader.varint());
+    current.energy[1] = static_cast<int32_t>(reader.varint());
+
+    if (flags & FLAG_KEYFRAME) {
+        for (int t = 0; t < 2; t++) {
+            for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) current.baseHp[t][i] = static_cast<int32_t>(reader.varint());
+        }
+        uint64_t count = reader.varint();
+        current.soldiers.clear();
+        uint32_t lastId = 0;
+        for (uint64_t i = 0; i < count && reader.ok; i++) {
+            ReplaySoldier soldier;
+            if (reader.soldier(soldier, lastId)) current.soldiers.push_back(soldier);
+        }
+    } else {
+        for (int t = 0; t < 2; t++) {
+            for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) current.baseHp[t][i] += static_cast<int32_t>(reader.zigzag());
+        }
+
+        // 死亡：按ID递增，一次归并删除
+        uint64_t removedCount = reader.varint();
+        scratch.clear();
+        uint32_t removedId = 0;
+        uint64_t removed = 0;
+        if (removedCount > 0) removedId = static_cast<uint32_t>(reader.varint());
+        for (const auto& soldier : current.soldiers) {
+            if (removed < removedCount && soldier.id == removedId) {
+                if (++removed < removedCount) removedId += static_cast<uint32_t>(reader.varint());
+                continue;
+            }
+            scratch.push_back(soldier);
+        }
+        if (removed != removedCount) return false;
+        current.soldiers.swap(scratch);
+
+        // 变化：同样按ID递增
+        uint64_t changedCount = reader.varint();
+        uint32_t lastId = 0;
+        size_t cursor = 0;
+        for (uint64_t i = 0; i < changedCount && reader.ok; i++) {
+            lastId += static_cast<uint32_t>(reader.varint());
+            while (cursor < current.soldiers.size() && current.soldiers[cursor].id < lastId) cursor++;
+            if (cursor == current.soldiers.size() || current.soldiers[cursor].id != lastId) return false;
+            ReplaySoldier& soldier = current.soldiers[cursor];
+            uint8_t mask = static_cast<uint8_t>(reader.fixed(1));
+            if (mask & CHANGED_X) soldier.x = static_cast<uint8_t>(soldier.x + reader.zigzag());
+            if (mask & CHANGED_Y) soldier.y = static_cast<uint8_t>(soldier.y + reader.zigzag());
+            if (mask & CHANGED_HP) soldier.hp += static_cast<int32_t>(reader.zigzag());
+        }
+
+        // 新出现的士兵ID大于所有已有士兵，直接追加
+        uint64_t addedCount = reader.varint();
+        lastId = 0;
+        for (uint64_t i = 0; i < addedCount && reader.ok; i++) {
+            ReplaySoldier soldier;
+            if (reader.soldier(soldier, lastId)) current.soldiers.push_back(soldier);
+        }
+    }
+
+    current.gameOver = flags & FLAG_GAME_OVER;
+    current.winner = current.gameOver ? static_cast<int>(reader.fixed(1)) : -1;
+    return reader.ok;
+}
+
+void ReplayPlayer::toState(GameState& state) const {
+    state.terrain = &terrain;
+    state.turn = currentIndex;
+    state.energy[0] = current.energy[0];
+    state.energy[1] = current.energy[1];
+    state.healDone[0] = 0;
+    state.healDone[1] = 0;
+    state.gameOver = current.gameOver ? 1 : 0;
+    state.winner = static_cast<int8_t>(current.winner);
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < BASE_COUNT_PER_TEAM; i++) {
+            state.bases[t][i] = {basePositions[t][i][0], basePositions[t][i][1], current.baseHp[t][i]};
+        }
+    }
+
+    // seek 已经检查过 fitsState
+    int count = static_cast<int>(current.soldiers.size());
+    for (int i = 0; i < count; i++) {
+        const ReplaySoldier& soldier = current.soldiers[i];
+        state.soldiers[i] = {soldier.x, soldier.y, soldier.team, soldier.type, static_cast<int16_t>(soldier.hp)};
+    }
+    state.soldierCount = static_cast<int16_t>(count);
+}
@@ -1,66 +1,102 @@
 #include "../include/TrainingLogger.h"
+#include "../include/DatasetWriter.h"
+#include "../include/FeatureEncoder.h"
 #include <iomanip>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <ctime>
+#include <mutex>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 同一进程内的多局游戏共用日志文件，追加和落盘计数需要串行化
+static std::mutex logFileMutex;
+static LogSyncPolicy syncPolicy = LogSyncPolicy::INTERVAL;
+static int syncInterval = 100;
+static int gamesSinceSync = 0;
+
+// 输出格式与二进制数据集写入器（进程内所有对局共用，写入器析构时写出最后一个分片）
+static bool jsonlEnabled = true;
+static bool binaryEnabled = true;
+static std::string datasetDirectory = TrainingLogger::DEFAULT_DATASET_DIR;
+static std::unique_ptr<DatasetWriter> datasetWriter;
+
+static DatasetWriter& getDatasetWriter() {
+    std::lock_guard<std::mutex> lock(logFileMutex);
+    if (!datasetWriter) datasetWriter = std::make_unique<DatasetWriter>(datasetDirectory);
+    return *datasetWriter;
+}
+
+// Action -> 数据集中的 (action_type, base_id, unit_type)
+static void writeActionFields(const Action& action, int8_t* fields) {
+    fields[0] = static_cast<int8_t>(action.type);
+    fields[1] = action.baseId;
+    fields[2] = static_cast<int8_t>(action.unitTypeId());
+}
 
 TrainingLogger::TrainingLogger() 
-    : totalTurns(0), gameStarted(false) {
+    : totalTurns(0), gameStarted(false), pushedRecords(0), logFilePath(DEFAULT_LOG_FILE),
+      queue(QUEUE_CAPACITY), processedRecords(0), verbose(true) {
+    writerThread = std::thread([this]() { writerLoop(); });
+}
+
+TrainingLogger::~TrainingLogger() {
+    LogRecord stop;
+    stop.kind = LogRecord::Kind::STOP;
+    submit(std::move(stop));
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+void TrainingLogger::submit(LogRecord&& record) {
+    pushedRecords++;
+    queue.push(std::move(record));
+}
+
+void TrainingLogger::flush() {
+    uint64_t processed = processedRecords.load(std::memory_order_acquire);
+    while (processed != pushedRecords) {
+        processedRecords.wait(processed, std::memory_order_acquire);
+        processed = processedRecords.load(std::memory_order_acquire);
+    }
 }
 
 void TrainingLogger::startGame(GameMode m, PlayerType t0, PlayerType t1) {
-    mode = m;
-    team0Type = t0;
-    team1Type = t1;
     totalTurns = 0;
     gameStarted = true;
     startTime = std::chrono::steady_clock::now();
+    currentTurnEvents.clear();
     
-    // 初始化JSON日志
-    logData = "{\n";
-    logData += "  \"metadata\": {\n";
-    logData += "    \"date\": \"" + getCurrentTimestamp() + "\",\n";
-    logData += "    \"mode\": \"" + gameModeToString(mode) + "\",\n";
-    logData += "    \"team0_type\": \"" + playerTypeToString(team0Type) + "\",\n";
-    logData += "    \"team1_type\": \"" + playerTypeToString(team1Type) + "\"\n";
-    logData += "  },\n";
-    logData += "  \"episodes\": [\n";
-}
-
-void TrainingLogger::recordTurn(int turn, const std::string& stateJson,
-                                const std::string& team0Action, 
-                                const std::string& team1Action) {
+    LogRecord record;
+    record.kind = LogRecord::Kind::BEGIN;
+    record.mode = m;
+    record.team0Type = t0;
+    record.team1Type = t1;
+    submit(std::move(record));
+}
+
+void TrainingLogger::recordTurn(int turn, const Observation& state,
+                                const Action& team0Action, 
+                                const Action& team1Action) {
     if (!gameStarted) return;
     
-    if (turn > 0) {
-        logData += ",\n";
-    }
-    
-    logData += "    {\n";
-    logData += "      \"turn\": " + std::to_string(turn) + ",\n";
-    logData += "      \"state\": " + stateJson + ",\n";
-    logData += "      \"team0_action\": " + team0Action + ",\n";
-    logData += "      \"team1_action\": " + team1Action + ",\n";
-    
-    // 计算奖励
-    float reward0 = calculateReward(0, currentTurnEvents);
-    float reward1 = calculateReward(1, currentTurnEvents);
-    logData += "      \"reward\": {\"team0\": " + std::to_string(reward0) + 
-               ", \"team1\": " + std::to_string(reward1) + "},\n";
+    // 奖励依赖当前的模型状态，必须在游戏线程计算
+    LogRecord record;
+    record.kind = LogRecord::Kind::TURN;
+    record.turn = turn;
+    record.reward[0] = calculateReward(0, currentTurnEvents);
+    record.reward[1] = calculateReward(1, currentTurnEvents);
+    record.state = state;
+    record.team0Action = team0Action;
+    record.team1Action = team1Action;
+    record.events.swap(currentTurnEvents);
+    submit(std::move(record));
     
-    // 记录事件
-    logData += "      \"events\": [\n";
-    for (size_t i = 0; i < currentTurnEvents.size(); ++i) {
-        if (i > 0) logData += ",\n";
-        const auto& evt = currentTurnEvents[i];
-        logData += "        {\"type\": \"" + evt.description + "\", \"team\": " + 
-                   std::to_string(evt.team) + "}";
-    }
-    logData += "\n      ]\n";
-    logData += "    }";
-    
-    currentTurnEvents.clear();
     totalTurns = turn + 1;
 }
 
@@ -72,21 +108,118 @@ void TrainingLogger::endGame(int winner) {
     if (!gameStarted) return;
     
     auto endTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration<double>(endTime - startTime).count();
-    
-    logData += "\n  ],\n";
-    logData += "  \"summary\": {\n";
-    logData += "    \"total_turns\": " + std::to_string(totalTurns) + ",\n";
-    logData += "    \"winner\": " + std::to_string(winner) + ",\n";
-    logData += "    \"duration_seconds\": " + std::to_string(duration) + "\n";
-    logData += "  }\n";
-    logData += "}\n";
     
-    saveToFile("game_log.json");
+    LogRecord record;
+    record.kind = LogRecord::Kind::END;
+    record.turn = totalTurns;
+    record.winner = winner;
+    record.durationSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    submit(std::move(record));
     gameStarted = false;
 }
 
-float TrainingLogger::calculateReward(int team, const std::vector<GameEvent>& events) {
+void TrainingLogger::writerLoop() {
+    LogRecord record;
+    while (true) {
+        queue.pop(record);
+        LogRecord::Kind kind = record.kind;
+        switch (kind) {
+            case LogRecord::Kind::BEGIN: writeBegin(record); break;
+            case LogRecord::Kind::TURN:  writeTurn(record); break;
+            case LogRecord::Kind::END:   writeEnd(record); break;
+            case LogRecord::Kind::STOP:  break;
+        }
+        processedRecords.fetch_add(1, std::memory_order_release);
+        processedRecords.notify_all();
+        if (kind == LogRecord::Kind::STOP) return;
+    }
+}
+
+void TrainingLogger::writeBegin(const LogRecord& record) {
+    datasetGame.clear();
+    if (!jsonlEnabled) return;
+    
+    // 初始化本局记录（JSON Lines：整局压缩为一行，不含换行符）
+    // 先清空再逐段追加（赋值字符串常量、"literal" + std::string 的临时对象在 GCC 12 -O2/-O3 下会误报 -Wrestrict）
+    logData.clear();
+    logData += "{";
+    logData += "\"metadata\": {";
+    logData += "\"date\": \"";
+    logData += getCurrentTimestamp();
+    logData += "\", \"mode\": \"";
+    logData += gameModeToString(record.mode);
+    logData += "\", \"team0_type\": \"";
+    logData += playerTypeToString(record.team0Type);
+    logData += "\", \"team1_type\": \"";
+    logData += playerTypeToString(record.team1Type);
+    logData += "\"";
+    logData += "}, ";
+    logData += "\"episodes\": [";
+}
+
+void TrainingLogger::writeTurn(const LogRecord& record) {
+    if (jsonlEnabled) {
+        if (record.turn > 0) {
+            logData += ", ";
+        }
+        
+        logData += "{";
+        logData += "\"turn\": " + std::to_string(record.turn) + ", ";
+        logData += "\"state\": ";
+        writeObservationJson(record.state, logData);
+        logData += ", ";
+        logData += "\"team0_action\": " + actionToJson(record.team0Action) + ", ";
+        logData += "\"team1_action\": " + actionToJson(record.team1Action) + ", ";
+        logData += "\"reward\": {\"team0\": " + std::to_string(record.reward[0]) + 
+                   ", \"team1\": " + std::to_string(record.reward[1]) + "}, ";
+        
+        // 记录事件
+        logData += "\"events\": [";
+        for (size_t i = 0; i < record.events.size(); ++i) {
+            if (i > 0) logData += ", ";
+            const auto& evt = record.events[i];
+            logData += "{\"type\": \"" + evt.description + "\", \"team\": " + 
+                       std::to_string(evt.team) + "}";
+        }
+        logData += "]";
+        logData += "}";
+    }
+    
+    if (binaryEnabled) {
+        // 直接从观测编码特征（与原生推理一致，不经过JSON）
+        size_t row = datasetGame.rows();
+        datasetGame.features.resize((row + 1) * FeatureEncoder::FEATURE_DIM);
+        FeatureEncoder::encode(record.state, &datasetGame.features[row * FeatureEncoder::FEATURE_DIM]);
+        
+        datasetGame.actions.resize((row + 1) * DatasetWriter::ACTION_FIELDS);
+        writeActionFields(record.team0Action, &datasetGame.actions[row * DatasetWriter::ACTION_FIELDS]);
+        writeActionFields(record.team1Action, &datasetGame.actions[row * DatasetWriter::ACTION_FIELDS + 3]);
+        
+        datasetGame.rewards.push_back(record.reward[0]);
+        datasetGame.rewards.push_back(record.reward[1]);
+    }
+}
+
+void TrainingLogger::writeEnd(const LogRecord& record) {
+    if (jsonlEnabled) {
+        logData += "], ";
+        logData += "\"summary\": {";
+        logData += "\"total_turns\": " + std::to_string(record.turn) + ", ";
+        logData += "\"winner\": " + std::to_string(record.winner) + ", ";
+        logData += "\"duration_seconds\": " + std::to_string(record.durationSeconds);
+        logData += "}";
+        logData += "}\n";
+        appendToFile(logFilePath);
+        logData.clear();
+    }
+    if (binaryEnabled) {
+        datasetGame.winner = record.winner;
+        getDatasetWriter().appendGame(datasetGame);
+        datasetGame.clear();
+    }
+}
+
+float TrainingLogger::calculateReward(const GameModel* model, int team, const std::vector<GameEvent>& events) {
     float reward = 0.0f;
     
     // 1. 基础事件奖励
@@ -108,8 +241,8 @@ float TrainingLogger::calculateReward(int team, const std::vector<GameEvent>& ev
 
     // 2. 战场态势分析 (如有Model权限)
     if (model) {
-        // 获取所有士兵
-        auto soldiers = model->getSoldiers();
+        const SpatialHash& spatial = model->getSpatialIndex();
+        Team enemyTeam = (team == 0) ? Team::TEAM_B : Team::TEAM_A;
         
         // 获取本队基地
         const auto& myBases = (team == 0) ? model->getBasesTeamA() : model->getBasesTeamB();
@@ -119,23 +252,14 @@ float TrainingLogger::calculateReward(int team, const std::vector<GameEvent>& ev
             if (!base->isAlive()) continue;
             
             // 检查基地周围 5 格有没有敌人
-            bool enemyNear = false;
-            for (const auto& s : soldiers) {
-                if (!s->isAlive()) continue;
-                if (static_cast<int>(s->getTeam()) == team) continue; // 忽略队友
-                
-                int dist = base->getPosition().chebyshevDistanceTo(s->getPosition());
-                if (dist <= 5) {
-                    enemyNear = true;
-                    break;
-                }
-            }
+            bool enemyNear = spatial.nearest(base->getPosition(), enemyTeam, DistanceMetric::CHEBYSHEV,
+                                             [](size_t) { return true; }, 5) >= 0;
             
             // 如果基地危险
             if (enemyNear) {
                 // 原有的逻辑缺陷修正：
                 // 如果基地危险，我们通过遍历 events 检查本回合有没有生成新的士兵 (SPAWN)
-                // 且该士兵是在这个被围攻的基地生成的（使用 soldier_id 记录的 baseId）
+                // 且该士兵是在这个被围攻的基地生成的（使用 base_id 记录的出兵基地）
                 
                 // 查找该基地的ID（在TeamBases数组中的索引）
                 int currentBaseId = -1;
@@ -150,7 +274,7 @@ float TrainingLogger::calculateReward(int team, const std::vector<GameEvent>& ev
                 bool defended = false;
                 for (const auto& evt : events) {
                     // 如果本回合不仅生成了兵，而且是在这个危险的基地生成的
-                    if (evt.type == EventType::SPAWN && evt.team == team && evt.soldier_id == currentBaseId) {
+                    if (evt.type == EventType::SPAWN && evt.team == team && evt.base_id == currentBaseId) {
                         defended = true;
                         break;
                     }
@@ -182,70 +306,66 @@ float TrainingLogger::calculateReward(int team, const std::vector<GameEvent>& ev
 std::string TrainingLogger::getCurrentTimestamp() {
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::tm localTime{};
+    localtime_r(&time_t, &localTime);  // std::localtime 返回共享缓冲区，多线程下不安全
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%dT%H:%M:%S");
+    ss << std::put_time(&localTime, "%Y-%m-%dT%H:%M:%S");
     return ss.str();
 }
 
-void TrainingLogger::saveToFile(const std::string& filename) {
-    // 使用临时文件策略，避免中断时破坏原文件
-    std::string tempFilename = filename + ".tmp";
-    
-    // 读取现有数据（如果文件存在）
-    std::ifstream inFile(filename);
-    std::string existingData;
-    bool fileExists = false;
-    
-    if (inFile.is_open()) {
-        std::stringstream buffer;
-        buffer << inFile.rdbuf();
-        existingData = buffer.str();
-        inFile.close();
-        
-        // 检查是否有有效的 JSON 数组（非空且包含games字段）
-        if (!existingData.empty() && existingData.find("\"games\": [") != std::string::npos) {
-            fileExists = true;
-        }
-    }
+void TrainingLogger::setSyncPolicy(LogSyncPolicy policy, int intervalGames) {
+    std::lock_guard<std::mutex> lock(logFileMutex);
+    syncPolicy = policy;
+    syncInterval = std::max(1, intervalGames);
+}
+
+void TrainingLogger::setOutputFormats(bool jsonl, bool binary, const std::string& datasetDir) {
+    std::lock_guard<std::mutex> lock(logFileMutex);
+    jsonlEnabled = jsonl;
+    binaryEnabled = binary;
+    datasetDirectory = datasetDir;
+}
+
+void TrainingLogger::flushDataset() {
+    std::lock_guard<std::mutex> lock(logFileMutex);
+    if (datasetWriter) datasetWriter->flush();
+}
+
+void TrainingLogger::appendToFile(const std::string& filename) {
+    // 追加写入：每局一行，一次 write 完成，不读取已有内容（旧实现每局重写整个文件）
+    std::lock_guard<std::mutex> lock(logFileMutex);
     
-    // 写入临时文件
-    std::ofstream outFile(tempFilename);
-    if (!outFile.is_open()) {
-        std::cerr << "Failed to create temporary training log file!" << std::endl;
+    int fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open training log " << filename << ": " << std::strerror(errno) << std::endl;
         return;
     }
     
-    if (fileExists) {
-        // 找到最后一个游戏的结束位置，在 ] 之前插入新游戏
-        size_t lastBracket = existingData.rfind("]");
-        if (lastBracket != std::string::npos) {
-            // 插入逗号和新游戏数据
-            std::string before = existingData.substr(0, lastBracket);
-            // 如果已有游戏，需要加逗号
-            if (before.find("{") != std::string::npos) {
-                before += ",\n";
-            }
-            before += "    " + logData;
-            before += "\n  ]\n}";
-            outFile << before;
+    // 正常情况下一次写完；被信号打断或部分写入时继续写剩余部分
+    const char* data = logData.data();
+    size_t remaining = logData.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Failed to write training log " << filename << ": " << std::strerror(errno) << std::endl;
+            break;
         }
-    } else {
-        // 创建新文件
-        outFile << "{\n  \"games\": [\n";
-        outFile << "    " + logData;
-        outFile << "\n  ]\n}";
+        data += written;
+        remaining -= static_cast<size_t>(written);
     }
     
-    outFile.flush();  // 确保数据写入磁盘
-    outFile.close();
+    // 按策略落盘
+    gamesSinceSync++;
+    bool shouldSync = (syncPolicy == LogSyncPolicy::EVERY_GAME) ||
+                      (syncPolicy == LogSyncPolicy::INTERVAL && gamesSinceSync >= syncInterval);
+    if (shouldSync) {
+        ::fsync(fd);
+        gamesSinceSync = 0;
+    }
+    ::close(fd);
     
-    // 写入成功后，用临时文件替换原文件
-    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
-        std::cerr << "Failed to rename temporary file to " << filename << std::endl;
-        // 尝试删除临时文件
-        std::remove(tempFilename.c_str());
-    } else {
-        std::cout << "Training log saved to " << filename << std::endl;
+    if (verbose.load(std::memory_order_relaxed)) {
+        std::cout << "Training log appended to " << filename << std::endl;
     }
-    std::cout << "Training log appended to " << filename << std::endl;
 }
@@ -0,0 +1,108 @@
+#include "../include/TrainingRunner.h"
+#include "../include/Model.h"
+#include "../include/Controller.h"
+#include "../include/ThreadPool.h"
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+
+// 进度输出来自多个工作线程，整行输出需要加锁避免交错
+static std::mutex outputMutex;
+
+TrainingRunner::TrainingRunner(const TrainingConfig& config) : config(config) {
+    if (this->config.games < 1) this->config.games = 1;
+    if (this->config.threads < 1) this->config.threads = 1;
+}
+
+TrainingSummary TrainingRunner::run(const std::atomic<bool>& interrupted) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 每局的结果写入各自的槽位，工作线程之间不共享可变状态
+    std::vector<GameResult> results(config.games);
+    {
+        ThreadPool pool(std::min(config.threads, config.games));
+        for (int i = 0; i < config.games; i++) {
+            pool.submit([this, i, &results, &interrupted]() {
+                if (interrupted.load()) return;
+                results[i] = runGame(i);
+            });
+        }
+        pool.wait();
+    }
+
+    // 汇总
+    TrainingSummary summary;
+    for (const auto& result : results) {
+        if (!result.finished) continue;
+        if (summary.gamesPlayed == 0) {
+            summary.minTurns = result.turns;
+            summary.maxTurns = result.turns;
+        }
+        summary.gamesPlayed++;
+        summary.wins[result.winner]++;
+        summary.totalTurns += result.turns;
+        summary.minTurns = std::min(summary.minTurns, result.turns);
+        summary.maxTurns = std::max(summary.maxTurns, result.turns);
+    }
+    summary.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return summary;
+}
+
+GameResult TrainingRunner::runGame(int index) {
+    GameResult result;
+
+    // 由 (baseSeed, index) 派生本局的种子
+    uint64_t seed = RngContext::deriveSeed(config.baseSeed, static_cast<uint64_t>(index));
+
+    try {
+        auto gameStart = std::chrono::steady_clock::now();
+        auto model = std::make_shared<GameModel>(seed);
+        {
+            // 控制器（日志记录器、AI代理）在本局结束后立即释放
+            GameController controller(model, GameMode::TRAINING, config.team0, config.team1);
+            // 多线程时各局的逐回合输出会在行中间交错，只保留下面加锁打印的每局摘要
+            if (config.threads > 1) controller.setVerbose(false);
+            controller.runToCompletion();
+            result.turns = controller.getCurrentTurn();
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count();
+        result.finished = model->isGameOver();
+        result.winner = static_cast<int>(model->getWinner());
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cerr << "[Game " << (index + 1) << "] Error: " << e.what() << std::endl;
+        return result;
+    }
+
+    if (result.finished) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "[Game " << (index + 1) << "/" << config.games << "] "
+                  << (result.winner == 0 ? "Team A" : "Team B") << " wins"
+                  << " | Turns: " << result.turns
+                  << " | Time: " << std::fixed << std::setprecision(2) << result.seconds << "s" << std::endl;
+    }
+    return result;
+}
+
+void TrainingRunner::printSummary(const TrainingSummary& summary) {
+    std::cout << "========================================" << std::endl;
+    std::cout << "Games played: " << summary.gamesPlayed << std::endl;
+    if (summary.gamesPlayed > 0) {
+        double avgTurns = static_cast<double>(summary.totalTurns) / summary.gamesPlayed;
+        std::cout << "Team A wins: " << summary.wins[0]
+                  << " (" << std::fixed << std::setprecision(1) << (100.0 * summary.wins[0] / summary.gamesPlayed) << "%)" << std::endl;
+        std::cout << "Team B wins: " << summary.wins[1]
+                  << " (" << std::fixed << std::setprecision(1) << (100.0 * summary.wins[1] / summary.gamesPlayed) << "%)" << std::endl;
+        std::cout << "Turns: avg " << std::fixed << std::setprecision(1) << avgTurns
+                  << ", min " << summary.minTurns << ", max " << summary.maxTurns << std::endl;
+    }
+    std::cout << "Elapsed: " << std::fixed << std::setprecision(2) << summary.elapsedSeconds << "s";
+    if (summary.elapsedSeconds > 0) {
+        std::cout << " (" << std::setprecision(2) << (summary.gamesPlayed / summary.elapsedSeconds) << " games/sec)";
+    }
+    std::cout << std::endl;
+    std::cout << "========================================" << std::endl;
+}
@@ -0,0 +1,83 @@
+// VecEnv.cpp - 批量强化学习环境
+#include "../include/VecEnv.h"
+#include "../include/TrainingLogger.h"
+#include <algorithm>
+#include <stdexcept>
+
+VecEnv::VecEnv(const VecEnvConfig& config)
+    : config(config), envs(std::max(1, config.numEnvs)),
+      pool(static_cast<size_t>(std::clamp(config.threads, 1, std::max(1, config.numEnvs)))) {
+    if (config.opponent == PlayerType::AI_NATIVE && !opponentPolicy.load(config.policyPath)) {
+        throw std::runtime_error("cannot load opponent policy " + config.policyPath);
+    }
+}
+
+Action VecEnv::decodeAction(const int8_t* fields) {
+    if (fields[0] != static_cast<int8_t>(ActionType::SPAWN)) return Action::wait();
+    int unitType = fields[2];
+    if (unitType < 0 || unitType >= SOLDIER_TYPE_COUNT) return Action::wait();
+    return Action::spawn(fields[1], static_cast<SoldierType>(unitType));
+}
+
+template <typename Fn>
+void VecEnv::parallelFor(Fn fn) {
+    int count = size();
+    int chunks = static_cast<int>(pool.size());
+    for (int c = 0; c < chunks; c++) {
+        int begin = count * c / chunks;
+        int end = count * (c + 1) / chunks;
+        pool.submit([&fn, begin, end]() {
+            for (int i = begin; i < end; i++) fn(i);
+        });
+    }
+    pool.wait();
+}
+
+void VecEnv::reset(const uint32_t* seeds, float* obs) {
+    for (int i = 0; i < size(); i++) {
+        envs[i].seed = seeds[i];
+        envs[i].episode = 0;
+    }
+    parallelFor([&](int i) {
+        startEpisode(envs[i], obs + static_cast<size_t>(i) * OBS_DIM);
+    });
+}
+
+void VecEnv::step(const int8_t* actions, float* obs, float* rewards, uint8_t* dones) {
+    parallelFor([&](int i) {
+        stepEnv(envs[i], decodeAction(actions + static_cast<size_t>(i) * ACTION_FIELDS),
+                obs + static_cast<size_t>(i) * OBS_DIM, rewards + i, dones + i);
+    });
+}
+
+void VecEnv::startEpisode(Env& env, float* obs) {
+    // 由 (seed, episode) 派生本局的种子（与 TrainingRunner 相同的派生方式）
+    uint64_t seed = RngContext::deriveSeed(env.seed, env.episode);
+    env.episode++;
+
+    // 非训练模式：不创建训练日志；控制器不启动线程，由 step 逐回合推进
+    env.model = std::make_shared<GameModel>(seed);
+    env.controller = std::make_unique<GameController>(env.model, GameMode::AI_VS_AI,
+                                                      config.opponent, PlayerType::EXTERNAL, &opponentPolicy);
+    env.controller->setVerbose(false);
+    env.controller->reset();
+
+    env.controller->observe(AGENT_TEAM, env.observation);
+    FeatureEncoder::encode(env.observation, obs);
+}
+
+void VecEnv::stepEnv(Env& env, const Action& action, float* obs, float* reward, uint8_t* done) {
+    env.controller->setExternalAction(AGENT_TEAM, action);
+    env.controller->step();
+
+    // 奖励与训练日志相同（事件奖励 + 基地危险时的出兵修正）
+    *reward = TrainingLogger::calculateReward(env.model.get(), AGENT_TEAM, env.controller->getTurnEvents());
+    *done = env.model->isGameOver() ? 1 : 0;
+
+    if (*done) {
+        startEpisode(env, obs);
+        return;
+    }
+    env.controller->observe(AGENT_TEAM, env.observation);
+    FeatureEncoder::encode(env.observation, obs);
+}
@@ -0,0 +1,49 @@
+// VecEnvCApi.cpp - libds_vecenv 的 C 接口
+#include "../include/VecEnvCApi.h"
+#include "../include/VecEnv.h"
+#include <iostream>
+#include <exception>
+
+struct DsVecEnv {
+    VecEnv env;
+    explicit DsVecEnv(const VecEnvConfig& config) : env(config) {}
+};
+
+DsVecEnv* ds_vecenv_create(int32_t num_envs, int32_t threads, int32_t opponent, const char* policy_path) {
+    VecEnvConfig config;
+    config.numEnvs = num_envs;
+    config.threads = threads;
+    config.opponent = (opponent == DS_VECENV_OPPONENT_NATIVE) ? PlayerType::AI_NATIVE : PlayerType::AI_RULE_BASED;
+    if (policy_path) config.policyPath = policy_path;
+    try {
+        return new DsVecEnv(config);
+    } catch (const std::exception& e) {
+        // 异常不能穿过 C 接口
+        std::cerr << "ds_vecenv_create failed: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void ds_vecenv_destroy(DsVecEnv* env) {
+    delete env;
+}
+
+int32_t ds_vecenv_size(const DsVecEnv* env) {
+    return env->env.size();
+}
+
+int32_t ds_vecenv_obs_dim(void) {
+    return VecEnv::OBS_DIM;
+}
+
+uint32_t ds_vecenv_feature_version(void) {
+    return FeatureEncoder::VERSION;
+}
+
+void ds_vecenv_reset(DsVecEnv* env, const uint32_t* seeds, float* obs) {
+    env->env.reset(seeds, obs);
+}
+
+void ds_vecenv_step(DsVecEnv* env, const int8_t* actions, float* obs, float* rewards, uint8_t* dones) {
+    env->env.step(actions, obs, rewards, dones);
+}
@@ -2,11 +2,69 @@
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
+
+// 回放进度条（购买面板右侧，窗口底部）
+static constexpr float REPLAY_BAR_LEFT = 350.0f;
+static constexpr float REPLAY_BAR_WIDTH = WINDOW_WIDTH - REPLAY_BAR_LEFT - 20.0f;
+static constexpr float REPLAY_BAR_TOP = WINDOW_HEIGHT - 40.0f;
+static constexpr float REPLAY_BAR_HEIGHT = 16.0f;
+
+// 贴图集布局：每个图块 ATLAS_TILE_SIZE 见方，四周留出透明间隔（平滑采样时不会混入相邻图块）
+static constexpr unsigned ATLAS_TILE_SIZE = 64;
+static constexpr unsigned ATLAS_PADDING = 2;
+static constexpr unsigned ATLAS_STRIDE = ATLAS_TILE_SIZE + 2 * ATLAS_PADDING;
+static constexpr unsigned ATLAS_COLUMNS = 4;
+static constexpr unsigned ATLAS_ROWS = 4;
+static constexpr int WHITE_TILE = SOLDIER_TYPE_COUNT * 2 + 2;
+
+static int atlasTile(SoldierType type, Team team) {
+    return static_cast<int>(type) * 2 + (team == Team::TEAM_A ? 0 : 1);
+}
+
+static sf::Vector2u atlasOrigin(int tile) {
+    return sf::Vector2u(tile % ATLAS_COLUMNS * ATLAS_STRIDE + ATLAS_PADDING,
+                        tile / ATLAS_COLUMNS * ATLAS_STRIDE + ATLAS_PADDING);
+}
+
+// 把 source 按面积平均缩小到 target 中 (left, top) 开始的 size 见方的图块
+// 非正方形的图片被拉伸（与原来按格子缩放精灵相同）；颜色按 alpha 加权，透明边缘不会发黑
+static void blitScaled(const sf::Image& source, sf::Image& target, unsigned left, unsigned top, unsigned size) {
+    sf::Vector2u sourceSize = source.getSize();
+    for (unsigned ty = 0; ty < size; ty++) {
+        unsigned y0 = ty * sourceSize.y / size;
+        unsigned y1 = std::max(y0 + 1, (ty + 1) * sourceSize.y / size);
+        for (unsigned tx = 0; tx < size; tx++) {
+            unsigned x0 = tx * sourceSize.x / size;
+            unsigned x1 = std::max(x0 + 1, (tx + 1) * sourceSize.x / size);
+            
+            uint64_t r = 0, g = 0, b = 0, a = 0;
+            for (unsigned y = y0; y < y1; y++) {
+                for (unsigned x = x0; x < x1; x++) {
+                    sf::Color pixel = source.getPixel(x, y);
+                    r += pixel.r * pixel.a;
+                    g += pixel.g * pixel.a;
+                    b += pixel.b * pixel.a;
+                    a += pixel.a;
+                }
+            }
+            
+            sf::Color out = sf::Color::Transparent;
+            if (a > 0) {
+                uint64_t count = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+                out = sf::Color(static_cast<sf::Uint8>(r / a), static_cast<sf::Uint8>(g / a),
+                                static_cast<sf::Uint8>(b / a), static_cast<sf::Uint8>(a / count));
+            }
+            target.setPixel(left + tx, top + ty, out);
+        }
+    }
+}
 
 GameView::GameView(std::shared_ptr<GameModel> model, std::shared_ptr<GameController> controller)
     : model(model), controller(controller),
       window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Strategy Game"),
-      fontLoaded(false), texturesLoaded(false), selectedBaseIndex(0) {
+      fontLoaded(false), texturesLoaded(false), unitVertices(sf::Triangles), terrainRevision(0), selectedBaseIndex(0),
+      replaySpeed(1000.0 / TURN_DURATION_MS), replayProgress(0.0), replayPaused(false) {
     
     window.setFramerateLimit(60);
 
@@ -25,6 +83,8 @@ void GameView::handleEvents() {
             if (event.mouseButton.button == sf::Mouse::Left) {
                 handleMouseClick(event.mouseButton.x, event.mouseButton.y);
             }
+        } else if (event.type == sf::Event::KeyPressed && replay) {
+            handleReplayKey(event.key.code);
         } else if (event.type == sf::Event::KeyPressed) {
             // 数字键1-3切换选中的基地
             if (event.key.code == sf::Keyboard::Num1) {
@@ -51,187 +111,244 @@ void GameView::handleEvents() {
 }
 
 void GameView::loadTextures() {
+    // 图块顺序与 atlasTile 一致：兵种×队伍，然后是两队基地
+    static const char* const files[ATLAS_TILE_COUNT - 1] = {
+        "Archer_blue.png", "Archer_red.png",
+        "Saber_blue.png", "Saber_red.png",
+        "Rider_blue.png", "Rider_red.png",
+        "caster_blue.png", "caster_red.png",
+        "doctor_blue.png", "doctor_red.png",
+        "home_blue.png", "home_red.png"
+    };
     std::string basePath = "image/";
     
-    texturesLoaded = true;
+    sf::Image image;
+    image.create(ATLAS_COLUMNS * ATLAS_STRIDE, ATLAS_ROWS * ATLAS_STRIDE, sf::Color::Transparent);
     
-    if (!texBaseBlue.loadFromFile(basePath + "home_blue.png")) {
-        texturesLoaded = false;
-    }
-    if (!texBaseRed.loadFromFile(basePath + "home_red.png")) {
-        texturesLoaded = false;
-    }
-    if (!texArcherBlue.loadFromFile(basePath + "Archer_blue.png")) {
-        texturesLoaded = false;
-    }
-    if (!texArcherRed.loadFromFile(basePath + "Archer_red.png")) {
-        texturesLoaded = false;
-    }
-    if (!texSaberBlue.loadFromFile(basePath + "Saber_blue.png")) {
-        texturesLoaded = false;
-    }
-    if (!texSaberRed.loadFromFile(basePath + "Saber_red.png")) {
-        texturesLoaded = false;
-    }
-    if (!texRiderBlue.loadFromFile(basePath + "Rider_blue.png")) {
-        texturesLoaded = false;
-    }
-    if (!texRiderRed.loadFromFile(basePath + "Rider_red.png")) {
-        texturesLoaded = false;
-    }
-    if (!texCasterBlue.loadFromFile(basePath + "caster_blue.png")) {
-        texturesLoaded = false;
-    }
-    if (!texCasterRed.loadFromFile(basePath + "caster_red.png")) {
-        texturesLoaded = false;
-    }
-    if (!texDoctorBlue.loadFromFile(basePath + "doctor_blue.png")) {
-        texturesLoaded = false;
+    texturesLoaded = true;
+    for (int tile = 0; tile < ATLAS_TILE_COUNT - 1; tile++) {
+        sf::Image source;
+        tileLoaded[tile] = source.loadFromFile(basePath + files[tile]);
+        if (!tileLoaded[tile]) {
+            texturesLoaded = false;
+            continue;
+        }
+        sf::Vector2u origin = atlasOrigin(tile);
+        blitScaled(source, image, origin.x, origin.y, ATLAS_TILE_SIZE);
     }
-    if (!texDoctorRed.loadFromFile(basePath + "doctor_red.png")) {
-        texturesLoaded = false;
+    
+    // 纯白图块连同四周的间隔一起填满，采样时不会混入透明像素
+    tileLoaded[WHITE_TILE] = true;
+    sf::Vector2u white = atlasOrigin(WHITE_TILE);
+    for (unsigned y = white.y - ATLAS_PADDING; y < white.y + ATLAS_TILE_SIZE + ATLAS_PADDING; y++) {
+        for (unsigned x = white.x - ATLAS_PADDING; x < white.x + ATLAS_TILE_SIZE + ATLAS_PADDING; x++) {
+            image.setPixel(x, y, sf::Color::White);
+        }
     }
     
+    atlas.loadFromImage(image);
+    atlas.setSmooth(true);
+    
     if (texturesLoaded) {
         std::cout << "All textures loaded successfully!" << std::endl;
     }
 }
 
 void GameView::render() {
+    if (replay) updateReplay();
+    model->copyRenderSnapshot(snapshot);
+    
     window.clear(sf::Color::Black);
     
     // 渲染各层
     renderMap();
-    renderBases();
-    renderSoldiers();
+    renderUnits();
     renderUI();
     renderPurchasePanel();
+    if (replay) renderReplayBar();
     
     window.display();
 }
 
+void GameView::playReplay(std::unique_ptr<ReplayPlayer> player) {
+    replay = std::move(player);
+    replayProgress = 0.0;
+    replayPaused = false;
+    replayClock.restart();
+    showReplayFrame(0);
+}
+
+void GameView::showReplayFrame(int index) {
+    if (!replay->seek(index)) {
+        std::cerr << "Replay error: " << replay->getError() << std::endl;
+        replayPaused = true;
+        return;
+    }
+    replay->toState(replayState);
+    model->loadState(replayState);
+    model->publishRenderSnapshot();
+}
+
+void GameView::updateReplay() {
+    double elapsed = replayClock.restart().asSeconds();
+    if (replayPaused) return;
+    
+    // 按播放速度累计回合，一帧内可能前进多个回合（只载入最后一个）
+    replayProgress += elapsed * replaySpeed;
+    int steps = static_cast<int>(replayProgress);
+    if (steps == 0) return;
+    replayProgress -= steps;
+    
+    int last = replay->frameCount() - 1;
+    int target = std::min(replay->position() + steps, last);
+    if (target != replay->position()) showReplayFrame(target);
+    if (target == last) replayPaused = true;
+}
+
+void GameView::handleReplayKey(sf::Keyboard::Key key) {
+    int position = replay->position();
+    if (key == sf::Keyboard::Space) {
+        // 在结尾处继续播放时从头开始
+        if (replayPaused && position == replay->frameCount() - 1) showReplayFrame(0);
+        replayPaused = !replayPaused;
+        replayProgress = 0.0;
+    } else if (key == sf::Keyboard::Right) {
+        showReplayFrame(position + 1);
+    } else if (key == sf::Keyboard::Left) {
+        showReplayFrame(position - 1);
+    } else if (key == sf::Keyboard::Up) {
+        replaySpeed = std::min(replaySpeed * 2.0, 256.0);
+    } else if (key == sf::Keyboard::Down) {
+        replaySpeed = std::max(replaySpeed / 2.0, 0.25);
+    } else if (key == sf::Keyboard::Home) {
+        showReplayFrame(0);
+    } else if (key == sf::Keyboard::End) {
+        showReplayFrame(replay->frameCount() - 1);
+    }
+}
+
 void GameView::renderMap() {
     GameMap* map = model->getMap();
+    if (!map) return;
+    
+    if (map->getRevision() != terrainRevision) {
+        rebuildTerrain(*map);
+    }
+    window.draw(terrainVertices);
+}
+
+void GameView::rebuildTerrain(const GameMap& map) {
+    // 先取版本号：重建期间地形再次变化时，下一帧会再重建一次
+    terrainRevision = map.getRevision();
+    
+    // 每个格子两个三角形；格线画成1像素宽的矩形（相当于相邻两格各0.5像素的内描边）
+    const size_t cellVertices = MAP_SIZE * MAP_SIZE * 6;
+    const size_t lineVertices = (MAP_SIZE + 1) * 2 * 6;
+    terrainVertices.setPrimitiveType(sf::Triangles);
+    terrainVertices.resize(cellVertices + lineVertices);
+    
+    size_t v = 0;
+    auto addRect = [&](float left, float top, float width, float height, sf::Color color) {
+        const sf::Vector2f corners[4] = {
+            {left, top}, {left + width, top}, {left + width, top + height}, {left, top + height}
+        };
+        for (int corner : {0, 1, 2, 0, 2, 3}) {
+            terrainVertices[v++] = sf::Vertex(corners[corner], color);
+        }
+    };
     
     for (int x = 0; x < MAP_SIZE; x++) {
         for (int y = 0; y < MAP_SIZE; y++) {
             Position pos(x, y);
-            TerrainType terrain = map->getTerrainAt(pos);
-            renderTerrain(x, y, terrain);
+            sf::Vector2f topLeft = gridToScreen(pos);
+            addRect(topLeft.x, topLeft.y, CELL_SIZE, CELL_SIZE, getTerrainColor(map.getTerrainAt(pos)));
         }
     }
+    
+    const sf::Color lineColor(50, 50, 50);
+    const float extent = MAP_SIZE * CELL_SIZE;
+    for (int i = 0; i <= MAP_SIZE; i++) {
+        float offset = i * CELL_SIZE - 0.5f;
+        addRect(offset, 0.0f, 1.0f, extent, lineColor);  // 竖线
+        addRect(0.0f, offset, extent, 1.0f, lineColor);  // 横线
+    }
 }
 
-void GameView::renderTerrain(int x, int y, TerrainType type) {
-    sf::RectangleShape cell(sf::Vector2f(CELL_SIZE, CELL_SIZE));
-    cell.setPosition(gridToScreen(Position(x, y)));
-    cell.setFillColor(getTerrainColor(type));
-    cell.setOutlineColor(sf::Color(50, 50, 50));
-    cell.setOutlineThickness(-0.5f);
-    
-    window.draw(cell);
+void GameView::renderUnits() {
+    unitVertices.clear();
+    
+    // 先画基地（含HP条），再画士兵，与原来的图层顺序相同
+    for (const auto& base : model->getBasesTeamA()) {
+        appendBase(*base);
+    }
+    for (const auto& base : model->getBasesTeamB()) {
+        appendBase(*base);
+    }
+    
+    for (const auto& soldier : snapshot.soldiers) {
+        appendSoldier(soldier);
+    }
+    
+    window.draw(unitVertices, &atlas);
 }
 
-void GameView::renderSoldiers() {
-    auto soldiers = model->getSoldiers();
+void GameView::appendQuad(const sf::Vector2f& position, const sf::Vector2f& size, int tile, sf::Color color) {
+    // 纯白图块只取中心像素
+    sf::Vector2u origin = atlasOrigin(tile);
+    float texLeft = static_cast<float>(origin.x);
+    float texTop = static_cast<float>(origin.y);
+    float texSize = static_cast<float>(ATLAS_TILE_SIZE);
+    if (tile == WHITE_TILE) {
+        texLeft += texSize / 2;
+        texTop += texSize / 2;
+        texSize = 0.0f;
+    }
     
-    for (const auto& soldier : soldiers) {
-        if (soldier->isAlive()) {
-            renderSoldier(*soldier);
-        }
+    const sf::Vector2f corners[4] = {
+        position, {position.x + size.x, position.y}, position + size, {position.x, position.y + size.y}
+    };
+    const sf::Vector2f texCoords[4] = {
+        {texLeft, texTop}, {texLeft + texSize, texTop}, {texLeft + texSize, texTop + texSize}, {texLeft, texTop + texSize}
+    };
+    for (int corner : {0, 1, 2, 0, 2, 3}) {
+        unitVertices.append(sf::Vertex(corners[corner], color, texCoords[corner]));
     }
 }
 
-void GameView::renderSoldier(const Soldier& soldier) {
-    Position pos = soldier.getPosition();
-    sf::Vector2f screenPos = gridToScreen(pos);
+void GameView::appendSoldier(const SoldierSnapshot& soldier) {
+    sf::Vector2f screenPos = gridToScreen(soldier.position);
+    sf::Vector2f cell(CELL_SIZE, CELL_SIZE);
+    int tile = atlasTile(soldier.type, soldier.team);
     
-    if (texturesLoaded) {
-        // 使用图片渲染
-        sf::Sprite sprite;
-        
-        // 根据士兵类型和队伍选择贴图
-        switch (soldier.getType()) {
-            case SoldierType::ARCHER:
-                sprite.setTexture(soldier.getTeam() == Team::TEAM_A ? texArcherBlue : texArcherRed);
-                break;
-            case SoldierType::INFANTRY:
-                sprite.setTexture(soldier.getTeam() == Team::TEAM_A ? texSaberBlue : texSaberRed);
-                break;
-            case SoldierType::CAVALRY:
-                sprite.setTexture(soldier.getTeam() == Team::TEAM_A ? texRiderBlue : texRiderRed);
-                break;
-            case SoldierType::CASTER:
-                sprite.setTexture(soldier.getTeam() == Team::TEAM_A ? texCasterBlue : texCasterRed);
-                break;
-            case SoldierType::DOCTOR:
-                sprite.setTexture(soldier.getTeam() == Team::TEAM_A ? texDoctorBlue : texDoctorRed);
-                break;
-        }
-        
-        // 缩放图片以适应格子大小
-        sf::Vector2u texSize = sprite.getTexture()->getSize();
-        float scaleX = CELL_SIZE / texSize.x;
-        float scaleY = CELL_SIZE / texSize.y;
-        sprite.setScale(scaleX, scaleY);
-        sprite.setPosition(screenPos);
-        
+    if (tileLoaded[tile]) {
         // 根据HP调整透明度
-        float hpRatio = static_cast<float>(soldier.getHp()) / soldier.getMaxHp();
+        float hpRatio = static_cast<float>(soldier.hp) / soldier.getMaxHp();
         sf::Color color = sf::Color::White;
         color.a = static_cast<sf::Uint8>(255 * (0.3f + 0.7f * hpRatio));
-        sprite.setColor(color);
-        
-        window.draw(sprite);
-    }
-}
-
-void GameView::renderBases() {
-    // 渲染Team A的所有基地
-    for (const auto& base : model->getBasesTeamA()) {
-        renderBase(base.get());
-    }
-    
-    // 渲染Team B的所有基地
-    for (const auto& base : model->getBasesTeamB()) {
-        renderBase(base.get());
+        appendQuad(screenPos, cell, tile, color);
+    } else {
+        appendQuad(screenPos, cell, WHITE_TILE, getSoldierColor(soldier));
     }
 }
 
-void GameView::renderBase(const Base* base) {
-    if (!base->isAlive()) return;
-    
-    Position pos = base->getPosition();
-    sf::Vector2f screenPos = gridToScreen(pos);
+void GameView::appendBase(const Base& base) {
+    if (!base.isAlive()) return;
     
-    if (texturesLoaded) {
-        // 使用图片渲染基地
-        sf::Sprite sprite;
-        sprite.setTexture(base->getTeam() == Team::TEAM_A ? texBaseBlue : texBaseRed);
-        
-        // 缩放图片以适应格子大小
-        sf::Vector2u texSize = sprite.getTexture()->getSize();
-        float scaleX = CELL_SIZE / texSize.x;
-        float scaleY = CELL_SIZE / texSize.y;
-        sprite.setScale(scaleX, scaleY);
-        sprite.setPosition(screenPos);
-        
-        window.draw(sprite);
+    sf::Vector2f screenPos = gridToScreen(base.getPosition());
+    int tile = SOLDIER_TYPE_COUNT * 2 + (base.getTeam() == Team::TEAM_A ? 0 : 1);
+    if (tileLoaded[tile]) {
+        appendQuad(screenPos, sf::Vector2f(CELL_SIZE, CELL_SIZE), tile, sf::Color::White);
+    } else {
+        appendQuad(screenPos, sf::Vector2f(CELL_SIZE, CELL_SIZE), WHITE_TILE, getTeamColor(base.getTeam()));
     }
     
-    // 绘制HP条
-    float hpRatio = static_cast<float>(base->getHp()) / base->getMaxHp();
-    sf::RectangleShape hpBar(sf::Vector2f(CELL_SIZE * hpRatio, CELL_SIZE * 0.1f));
-    hpBar.setPosition(screenPos.x, screenPos.y - CELL_SIZE * 0.15f);
-    hpBar.setFillColor(sf::Color::Green);
-    window.draw(hpBar);
-    
-    sf::RectangleShape hpBackground(sf::Vector2f(CELL_SIZE, CELL_SIZE * 0.1f));
-    hpBackground.setPosition(screenPos.x, screenPos.y - CELL_SIZE * 0.15f);
-    hpBackground.setFillColor(sf::Color(50, 50, 50));
-    hpBackground.setOutlineColor(sf::Color::White);
-    hpBackground.setOutlineThickness(-1.0f);
-    window.draw(hpBackground);
+    // HP条：白色边框、深灰底色、绿色剩余HP
+    float hpRatio = static_cast<float>(base.getHp()) / base.getMaxHp();
+    sf::Vector2f barPos(screenPos.x, screenPos.y - CELL_SIZE * 0.15f);
+    sf::Vector2f barSize(CELL_SIZE, CELL_SIZE * 0.1f);
+    appendQuad(barPos, barSize, WHITE_TILE, sf::Color::White);
+    appendQuad(barPos + sf::Vector2f(1.0f, 1.0f), barSize - sf::Vector2f(2.0f, 2.0f), WHITE_TILE, sf::Color(50, 50, 50));
+    appendQuad(barPos, sf::Vector2f(CELL_SIZE * hpRatio, barSize.y), WHITE_TILE, sf::Color::Green);
 }
 
 void GameView::renderUI() {
@@ -243,19 +360,16 @@ void GameView::renderUI() {
     turnText.setCharacterSize(20);
     turnText.setFillColor(sf::Color::White);
     std::ostringstream oss;
-    oss << "Turn: " << model->getTurnCount();
+    oss << "Turn: " << snapshot.turn;
     turnText.setString(oss.str());
     turnText.setPosition(10, 10);
     window.draw(turnText);
     
     // 显示士兵数量
-    auto soldiers = model->getSoldiers();
     int teamACount = 0, teamBCount = 0;
-    for (const auto& s : soldiers) {
-        if (s->isAlive()) {
-            if (s->getTeam() == Team::TEAM_A) teamACount++;
-            else teamBCount++;
-        }
+    for (const auto& s : snapshot.soldiers) {
+        if (s.team == Team::TEAM_A) teamACount++;
+        else teamBCount++;
     }
     
     sf::Text soldierText;
@@ -333,11 +447,11 @@ sf::Color GameView::getTeamColor(Team team) {
     }
 }
 
-sf::Color GameView::getSoldierColor(const Soldier& soldier) {
-    sf::Color baseColor = getTeamColor(soldier.getTeam());
+sf::Color GameView::getSoldierColor(const SoldierSnapshot& soldier) {
+    sf::Color baseColor = getTeamColor(soldier.team);
     
     // 根据HP调整亮度
-    float hpRatio = static_cast<float>(soldier.getHp()) / soldier.getMaxHp();
+    float hpRatio = static_cast<float>(soldier.hp) / soldier.getMaxHp();
     
     return sf::Color(
         static_cast<sf::Uint8>(baseColor.r * hpRatio),
@@ -393,8 +507,8 @@ void GameView::renderPurchasePanel() {
     
     // Team B 士兵统计
     int soldierCountA = 0;
-    for (const auto& soldier : model->soldiers) {
-        if (soldier->getTeam() == Team::TEAM_B) {
+    for (const auto& soldier : snapshot.soldiers) {
+        if (soldier.team == Team::TEAM_B) {
             soldierCountA++;
         }
     }
@@ -504,8 +618,8 @@ void GameView::renderPurchasePanel() {
     
     // Team A 士兵统计
     int soldierCountA_panel = 0;
-    for (const auto& soldier : model->soldiers) {
-        if (soldier->getTeam() == Team::TEAM_A) {
+    for (const auto& soldier : snapshot.soldiers) {
+        if (soldier.team == Team::TEAM_A) {
             soldierCountA_panel++;
         }
     }
@@ -515,7 +629,43 @@ void GameView::renderPurchasePanel() {
     window.draw(soldierTextB);
 }
 
+void GameView::renderReplayBar() {
+    int last = std::max(1, replay->frameCount() - 1);
+    
+    sf::RectangleShape track(sf::Vector2f(REPLAY_BAR_WIDTH, REPLAY_BAR_HEIGHT));
+    track.setPosition(REPLAY_BAR_LEFT, REPLAY_BAR_TOP);
+    track.setFillColor(sf::Color(40, 40, 40, 220));
+    track.setOutlineColor(sf::Color(200, 200, 200));
+    track.setOutlineThickness(1);
+    window.draw(track);
+    
+    sf::RectangleShape filled(sf::Vector2f(REPLAY_BAR_WIDTH * replay->position() / last, REPLAY_BAR_HEIGHT));
+    filled.setPosition(REPLAY_BAR_LEFT, REPLAY_BAR_TOP);
+    filled.setFillColor(sf::Color(100, 180, 255));
+    window.draw(filled);
+    
+    if (!fontLoaded) return;
+    std::ostringstream oss;
+    oss << "Replay " << replay->position() << "/" << last << " turns | "
+        << std::setprecision(3) << replaySpeed << " turns/s" << (replayPaused ? " | paused" : "");
+    sf::Text status(oss.str(), font, 16);
+    status.setPosition(REPLAY_BAR_LEFT, REPLAY_BAR_TOP - 26);
+    status.setFillColor(sf::Color::White);
+    window.draw(status);
+}
+
 void GameView::handleMouseClick(int mouseX, int mouseY) {
+    // 回放时点击进度条跳转
+    if (replay) {
+        if (mouseX >= REPLAY_BAR_LEFT && mouseX <= REPLAY_BAR_LEFT + REPLAY_BAR_WIDTH &&
+            mouseY >= REPLAY_BAR_TOP - 4 && mouseY <= REPLAY_BAR_TOP + REPLAY_BAR_HEIGHT + 4) {
+            int last = replay->frameCount() - 1;
+            showReplayFrame(static_cast<int>((mouseX - REPLAY_BAR_LEFT) / REPLAY_BAR_WIDTH * last + 0.5f));
+            replayProgress = 0.0;
+        }
+        return;
+    }
+    
     // 检查是否点击左下角购买按钮区域 (Team B)
     if (mouseX >= 15 && mouseX <= 315) {
         if (mouseY >= WINDOW_HEIGHT - 255 && mouseY <= WINDOW_HEIGHT - 225) {
@@ -539,12 +689,13 @@ void GameView::handleMouseClick(int mouseX, int mouseY) {
 
 void GameView::handlePurchaseClick(SoldierType type) {
     // 人类控制Team A（蓝色）
+    if (!controller) return;
     const auto& bases = model->getBasesTeamA();
     if (selectedBaseIndex < 0 || selectedBaseIndex >= bases.size()) return;
     if (!bases[selectedBaseIndex]->isAlive()) return;
     
     Position basePos = bases[selectedBaseIndex]->getPosition();
-    bool success = controller->purchaseSoldier(Team::TEAM_A, type, basePos);
+    bool success = controller->requestPurchase(Team::TEAM_A, type, basePos);
     
     if (!success) {
         std::cout << "Purchase failed: Not enough energy or position unavailable" << std::endl;
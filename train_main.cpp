@@ -0,0 +1,28 @@
+#include <iostream>
+#include <exception>
+#include "include/GameTypes.h"
+#include "include/Launcher.h"
+
+// 无界面训练入口：只链接 ds_sim，不依赖SFML，可在服务器/CI上构建
+// 参数与 DS_PJ 相同，但总是以训练模式运行，双方默认为规则AI
+int main(int argc, char* argv[]) {
+    try {
+        changeToProjectRoot();
+        installInterruptHandler();
+
+        GameConfig defaults;
+        defaults.mode = GameMode::TRAINING;
+        defaults.team0 = PlayerType::AI_RULE_BASED;
+        defaults.team1 = PlayerType::AI_RULE_BASED;
+
+        GameConfig config = parseArgs(argc, argv, defaults);
+        config.mode = GameMode::TRAINING;
+        return runHeadless(config);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "Unknown error occurred!" << std::endl;
+        return 1;
+    }
+}